@@ -0,0 +1,308 @@
+#include "../tools/pegen/pe_generator.hpp"
+
+#include <load/memory.hpp>
+#include <load/module.hpp>
+#include <load/process.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#if defined(__unix__)
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+using namespace load;
+
+namespace {
+
+class StubModule final : public Module
+{
+public:
+	virtual ModuleMemoryStats memory_stats() const override { return {}; }
+	virtual ModuleAbi abi() const override { return native_module_abi; }
+	virtual void * tls_data() const override { return nullptr; }
+
+protected:
+	virtual DataPtr get_data_address(std::string_view) const override { return &_value; }
+	virtual ProcPtr get_proc_address(std::string_view) const override { return nullptr; }
+
+private:
+	int _value = 0;
+};
+
+class StubModuleProvider final : public ModuleProvider
+{
+public:
+	virtual std::shared_ptr<Module> get_module(std::string_view) override
+	{
+		return _module;
+	}
+
+private:
+	std::shared_ptr<Module> _module = std::make_shared<StubModule>();
+};
+
+// Forwards to the current process memory but makes the loader take its indirect paths
+class IndirectMemoryManager final : public MemoryManager
+{
+public:
+	explicit IndirectMemoryManager(MemoryManager & target) : _target { &target } {}
+
+	virtual bool allows_direct_addressing() const override { return false; }
+	virtual std::size_t page_size() const override { return _target->page_size(); }
+
+	virtual void * allocate(std::uintptr_t base, std::size_t size) override { return _target->allocate(base, size); }
+	virtual void release(void * mem, std::size_t size) override { _target->release(mem, size); }
+
+	virtual void commit(void * mem, std::size_t size) override { _target->commit(mem, size); }
+	virtual void decommit(void * mem, std::size_t size) override { _target->decommit(mem, size); }
+	virtual void set_access(void * mem, std::size_t size, int access) override { _target->set_access(mem, size, access); }
+
+	virtual std::size_t resident_size(const void * mem, std::size_t size) const override
+	{
+		return _target->resident_size(mem, size);
+	}
+
+	virtual MemoryState memory_state(const void * mem, std::size_t size) const override
+	{
+		return _target->memory_state(mem, size);
+	}
+
+	virtual std::size_t copy_from(const void * mem, std::size_t size, void * into_buffer) override
+	{
+		return _target->copy_from(mem, size, into_buffer);
+	}
+
+	virtual std::size_t copy_into(const void * from_buffer, std::size_t size, void * into_mem) override
+	{
+		return _target->copy_into(from_buffer, size, into_mem);
+	}
+
+	virtual void flush_instruction_cache(const void * mem, std::size_t size) override
+	{
+		_target->flush_instruction_cache(mem, size);
+	}
+
+private:
+	MemoryManager * _target;
+};
+
+class IndirectProcess final : public Process
+{
+public:
+	explicit IndirectProcess(Process & target)
+		: _target { &target }, _memory_manager { target.memory_manager() } {}
+
+	virtual ProcessId process_id() const override { return _target->process_id(); }
+	virtual ProcessHandle native_handle() override { return _target->native_handle(); }
+
+	virtual MemoryManager & memory_manager() override { return _memory_manager; }
+	virtual const MemoryManager & memory_manager() const override { return _memory_manager; }
+
+	virtual ModuleProvider & module_provider() const override { return _target->module_provider(); }
+	virtual const CodeGenerator & code_generator() const override { return _target->code_generator(); }
+
+	virtual void register_exception_table(std::uintptr_t base_address,
+	                                      void         * exception_table,
+	                                      std::size_t    table_size) override
+	{
+		_target->register_exception_table(base_address, exception_table, table_size);
+	}
+
+	virtual void deregister_exception_table(void * exception_table) override
+	{
+		_target->deregister_exception_table(exception_table);
+	}
+
+	virtual std::uint32_t execute(const void * proc, void * param) override
+	{
+		return _target->execute(proc, param);
+	}
+
+private:
+	Process             * _target;
+	IndirectMemoryManager _memory_manager;
+};
+
+enum BenchArg { ImageSize, RelocsPerPage, ImportCount, IndirectMemory, ColdCache };
+
+std::filesystem::path bench_image_directory()
+{
+	// tmpfs pages can't be evicted, so point this at a disk-backed directory for cold runs
+	if (const char * bench_dir = std::getenv("LIBLOAD_BENCH_DIR"))
+		return bench_dir;
+	return std::filesystem::temp_directory_path();
+}
+
+const std::filesystem::path & bench_image(const benchmark::State & state, pegen::ImageSummary & summary)
+{
+	using image_key = std::tuple<std::int64_t, std::int64_t, std::int64_t>;
+	static std::map<image_key, std::pair<std::filesystem::path, pegen::ImageSummary>> bench_images;
+
+	const image_key key { state.range(ImageSize), state.range(RelocsPerPage), state.range(ImportCount) };
+	auto image_it = bench_images.find(key);
+	if (image_it == bench_images.end()) {
+		pegen::ImageSpec spec;
+		spec.section_count = 1;
+		spec.section_size = state.range(ImageSize);
+		spec.relocations_per_page = state.range(RelocsPerPage);
+		spec.import_module_count = state.range(ImportCount) ? 4 : 0;
+		spec.imports_per_module = state.range(ImportCount) / 4;
+		spec.export_count = 64;
+
+		const std::string file_name = "libload_bench_" + std::to_string(std::get<0>(key)) + "_"
+		                            + std::to_string(std::get<1>(key)) + "_"
+		                            + std::to_string(std::get<2>(key)) + ".dll";
+		const auto image_path = bench_image_directory() / file_name;
+		const pegen::ImageSummary image_summary = pegen::write_pe_image(spec, image_path);
+		image_it = bench_images.emplace(key, std::pair(image_path, image_summary)).first;
+	}
+
+	summary = image_it->second.second;
+	return image_it->second.first;
+}
+
+bool evict_from_page_cache(const std::filesystem::path & path)
+{
+#if defined(__unix__)
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	fdatasync(fd);
+	const bool evicted = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	close(fd);
+	return evicted;
+#else
+	return false;
+#endif
+}
+
+double percentile(const std::vector<double> & samples, double fraction)
+{
+	std::vector<double> sorted { samples };
+	std::sort(sorted.begin(), sorted.end());
+	const std::size_t index = static_cast<std::size_t>(fraction * (sorted.size() - 1));
+	return sorted[index];
+}
+
+using load_clock = std::chrono::steady_clock;
+using load_duration = std::chrono::duration<double>;
+
+template <class Fn>
+void run_load_benchmark(benchmark::State & state, Fn && timed_section)
+{
+	pegen::ImageSummary summary;
+	const std::filesystem::path & image_path = bench_image(state, summary);
+
+	StubModuleProvider module_provider;
+	IndirectProcess indirect_process { current_process() };
+	Process & process = state.range(IndirectMemory) ? static_cast<Process &>(indirect_process)
+	                                                : current_process();
+
+	const bool cold_cache = state.range(ColdCache) != 0;
+	auto image_file = cold_cache ? nullptr : std::make_unique<MappedFile>(image_path);
+
+	std::vector<double> samples;
+	for (auto _ : state) {
+		if (cold_cache) {
+			image_file.reset();
+			if (!evict_from_page_cache(image_path)) {
+				state.SkipWithError("Unable to evict image from the page cache");
+				break;
+			}
+			image_file = std::make_unique<MappedFile>(image_path);
+		}
+
+		const std::optional<load_duration> elapsed = timed_section(*image_file, module_provider, process);
+		if (!elapsed) {
+			state.SkipWithError("Image format not supported by this build");
+			break;
+		}
+		state.SetIterationTime(elapsed->count());
+		samples.push_back(elapsed->count());
+	}
+
+	state.SetBytesProcessed(state.iterations() * summary.image_size);
+	state.counters["relocations"] = benchmark::Counter(double(summary.relocation_count),
+	                                                   benchmark::Counter::kIsIterationInvariantRate);
+	state.counters["imports"] = benchmark::Counter(double(summary.import_count),
+	                                               benchmark::Counter::kIsIterationInvariantRate);
+
+	if (!samples.empty()) {
+		state.counters["p50_us"] = percentile(samples, 0.50) * 1e6;
+		state.counters["p90_us"] = percentile(samples, 0.90) * 1e6;
+		state.counters["p99_us"] = percentile(samples, 0.99) * 1e6;
+	}
+}
+
+void BM_LoadModule(benchmark::State & state)
+{
+	run_load_benchmark(state, [] (const MappedFile & image_file, ModuleProvider & module_provider,
+	                              Process & process) -> std::optional<load_duration>
+	{
+		const auto load_start = load_clock::now();
+		auto module = load::load_module(image_file, module_provider, process);
+		const auto load_end = load_clock::now();
+		if (!module) return std::nullopt;
+
+		module.reset();
+		return load_end - load_start;
+	});
+}
+
+void BM_UnloadModule(benchmark::State & state)
+{
+	run_load_benchmark(state, [] (const MappedFile & image_file, ModuleProvider & module_provider,
+	                              Process & process) -> std::optional<load_duration>
+	{
+		auto module = load::load_module(image_file, module_provider, process);
+		if (!module) return std::nullopt;
+
+		const auto unload_start = load_clock::now();
+		module.reset();
+		return load_clock::now() - unload_start;
+	});
+}
+
+void load_benchmark_args(benchmark::internal::Benchmark * bench)
+{
+	// Each argument is varied on its own around the baseline image, instead of the full product
+	const std::vector<std::int64_t> baseline_args { 0x100000, 64, 1024, 0, 0 };
+	const std::vector<std::vector<std::int64_t>> arg_values {
+		{ 0x10000, 0x100000, 0x1000000 },
+		{ 0, 64, 512 },
+		{ 0, 1024 },
+		{ 0, 1 },
+		{ 0, 1 },
+	};
+
+	bench->ArgNames({ "size", "relocs", "imports", "indirect", "cold" })
+	     ->Args(baseline_args);
+	for (std::size_t arg = 0; arg < arg_values.size(); ++arg) {
+		for (const std::int64_t value : arg_values[arg]) {
+			if (value == baseline_args[arg]) continue;
+			std::vector<std::int64_t> args { baseline_args };
+			args[arg] = value;
+			bench->Args(args);
+		}
+	}
+	bench->UseManualTime()
+	     ->Unit(benchmark::kMicrosecond);
+}
+
+}
+
+BENCHMARK(BM_LoadModule)->Apply(load_benchmark_args);
+BENCHMARK(BM_UnloadModule)->Apply(load_benchmark_args);
+
+BENCHMARK_MAIN();
\ No newline at end of file
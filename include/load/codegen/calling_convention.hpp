@@ -36,6 +36,16 @@ public:
 	virtual std::unique_ptr<CodeChunk> invoke_proc(const CodeLocation  & label,
 	                                               const ParameterList & params,
 	                                               std::uintmax_t        this_param) const = 0;
+
+	// Takes a pointer to { target, params[argc], result } as its only parameter
+	virtual std::unique_ptr<CodeChunk> make_trampoline(unsigned int argc) const = 0;
+
+	// Returns the given value from a procedure of argc parameters when the low 32 bits of the preceding call's
+	// result are zero, as for a BOOL that is FALSE; null when the convention cannot branch
+	virtual std::unique_ptr<CodeChunk> return_if_false(unsigned int /* argc */, std::uintmax_t /* value */) const
+	{
+		return nullptr;
+	}
 };
 
 }
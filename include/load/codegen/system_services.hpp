@@ -5,6 +5,8 @@
 #include <load/codegen/common.hpp>
 
 #include <memory>
+#include <optional>
+#include <string_view>
 
 namespace load {
 
@@ -16,6 +18,10 @@ public:
 	virtual ~SystemServices() = default;
 
 	virtual std::unique_ptr<CodeChunk> make_syscall(int code, const ParameterList & params) const = 0;
+
+	// Forwards the parameters of the enclosing procedure to the syscall and returns its result
+	virtual std::unique_ptr<CodeChunk> make_syscall_proc(int code) const = 0;
+	virtual std::optional<int> syscall_code(std::string_view name) const = 0;
 };
 
 }
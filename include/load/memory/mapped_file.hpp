@@ -18,6 +18,9 @@ public:
 	virtual std::size_t read(std::size_t offset, std::size_t size,
 	                         void * into_buffer) const override;
 
+	virtual const char * contiguous_data() const override;
+	virtual std::size_t  contiguous_size() const override;
+
 private:
 	boost::iostreams::mapped_file_source _mm_file;
 };
@@ -12,6 +12,9 @@ class LOAD_EXPORT MemoryBuffer
 public:
 	virtual ~MemoryBuffer() = default;
 	virtual std::size_t read(std::size_t offset, std::size_t size, void * into_buffer) const = 0;
+
+	virtual const char * contiguous_data() const { return nullptr; }
+	virtual std::size_t  contiguous_size() const { return 0; }
 };
 
 }
@@ -18,9 +18,17 @@ public:
 		ExecuteAccess = 1 << 2,
 	};
 
+	struct MemoryState
+	{
+		std::size_t committed_size = 0;
+		// Union of the access of the committed pages
+		int         access         = 0;
+	};
+
 	virtual ~MemoryManager() = default;
 
 	virtual bool allows_direct_addressing() const = 0;
+	virtual std::size_t page_size() const = 0;
 
 	virtual void * allocate(std::uintptr_t base, std::size_t size) = 0;
 	virtual void release(void * mem, std::size_t size) = 0;
@@ -28,9 +36,13 @@ public:
 	virtual void commit(void * mem, std::size_t size) = 0;
 	virtual void decommit(void * mem, std::size_t size) = 0;
 	virtual void set_access(void * mem, std::size_t size, int access) = 0;
+	virtual std::size_t resident_size(const void * mem, std::size_t size) const = 0;
+	virtual MemoryState memory_state(const void * mem, std::size_t size) const = 0;
 
 	virtual std::size_t copy_from(const void * mem, std::size_t size, void * into_buffer) = 0;
 	virtual std::size_t copy_into(const void * from_buffer, std::size_t size, void * into_mem) = 0;
+
+	virtual void flush_instruction_cache(const void * mem, std::size_t size) = 0;
 };
 
 }
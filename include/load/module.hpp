@@ -2,7 +2,16 @@
 #define LOAD_MODULE_HPP_
 
 #include <load/module/module.hpp>
+#include <load/module/call_stats.hpp>
+#include <load/module/memory_stats.hpp>
+#include <load/module/import_resolver.hpp>
 #include <load/module/load_module.hpp>
+#include <load/module/load_options.hpp>
+#include <load/module/load_result.hpp>
+#include <load/module/load_observer.hpp>
+#include <load/module/module_format.hpp>
 #include <load/module/module_provider.hpp>
+#include <load/module/module_registry.hpp>
+#include <load/module/perf_map.hpp>
 
 #endif
\ No newline at end of file
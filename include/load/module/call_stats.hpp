@@ -0,0 +1,28 @@
+#ifndef LOAD_MODULE_CALLSTATS_HPP_
+#define LOAD_MODULE_CALLSTATS_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace load {
+
+struct ImportCallStats
+{
+	std::string   module_name;
+	std::string   proc_name;
+	std::uint64_t call_count  = 0;
+	std::uint64_t cycle_count = 0;
+};
+
+struct ModuleCallStats
+{
+	std::uint64_t call_count  = 0;
+	std::uint64_t cycle_count = 0;
+
+	std::vector<ImportCallStats> imports;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef LOAD_MODULE_FUNCTIONHOOK_HPP_
+#define LOAD_MODULE_FUNCTIONHOOK_HPP_
+
+#include <load/export.hpp>
+
+#include <memory>
+
+namespace load {
+
+namespace detail { class HotPatch; }
+
+enum class ModuleAbi;
+
+class LOAD_EXPORT FunctionHook
+{
+public:
+	FunctionHook();
+	explicit FunctionHook(std::unique_ptr<detail::HotPatch> hot_patch);
+	FunctionHook(FunctionHook && other) noexcept;
+	FunctionHook & operator=(FunctionHook && other);
+	~FunctionHook();
+
+	explicit operator bool() const;
+
+	// Runs the target as it was before patching
+	const void * original() const;
+
+	template <typename Fn>
+	Fn * original() const;
+
+	void unhook();
+
+private:
+	std::unique_ptr<detail::HotPatch> _hot_patch;
+};
+
+// Patches the entry of target to jump to replacement until the returned hook is released
+LOAD_EXPORT FunctionHook hook_function(void * target, const void * replacement);
+LOAD_EXPORT FunctionHook hook_function(void * target, const void * replacement, ModuleAbi target_abi);
+
+template <typename Fn>
+Fn * FunctionHook::original() const
+{
+	return reinterpret_cast<Fn *>(const_cast<void *>(original()));
+}
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef LOAD_MODULE_IMPORTRESOLVER_HPP_
+#define LOAD_MODULE_IMPORTRESOLVER_HPP_
+
+#include <load/export.hpp>
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace load {
+
+class LOAD_EXPORT ImportResolver
+{
+public:
+	virtual ~ImportResolver() = default;
+
+	// Returns the address to bind instead of the provider's symbol, which may be null if it wasn't found.
+	// The replacement has to follow the calling convention of the module it was imported from.
+	virtual const void * resolve_import(std::string_view module_name,
+	                                    std::string_view symbol_name,
+	                                    const void     * default_address) = 0;
+};
+
+class LOAD_EXPORT ImportOverrides final : public ImportResolver
+{
+public:
+	// Overrides the symbol whichever module it is imported from
+	void add(std::string_view symbol_name, const void * address);
+	// Module names are matched case-insensitively, as the Windows loader does
+	void add(std::string_view module_name, std::string_view symbol_name, const void * address);
+
+	virtual const void * resolve_import(std::string_view module_name,
+	                                    std::string_view symbol_name,
+	                                    const void     * default_address) override;
+
+private:
+	using override_key = std::pair<std::string, std::string>;
+
+	std::map<override_key, const void *> _overrides;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef LOAD_MODULE_LOADMODULE_HPP_
 #define LOAD_MODULE_LOADMODULE_HPP_
 
+#include <load/module/load_options.hpp>
+#include <load/module/load_result.hpp>
 #include <load/module/module_provider.hpp>
 #include <load/process/process.hpp>
 
@@ -15,6 +17,25 @@ std::shared_ptr<Module> load_module(const MemoryBuffer & module_data,
                                     ModuleProvider     & module_provider = system_module_provider,
                                     Process            & into_process    = current_process());
 
+LOAD_EXPORT
+std::shared_ptr<Module> load_module(const MemoryBuffer & module_data,
+                                    const LoadOptions  & options,
+                                    ModuleProvider     & module_provider = system_module_provider,
+                                    Process            & into_process    = current_process());
+
+// Reports unrecognized images, missing dependencies and missing symbols without throwing, which makes
+// probing many candidate files cheap. Images are released again when loading fails halfway.
+LOAD_EXPORT
+LoadResult try_load_module(const MemoryBuffer & module_data,
+                           ModuleProvider     & module_provider = system_module_provider,
+                           Process            & into_process    = current_process());
+
+LOAD_EXPORT
+LoadResult try_load_module(const MemoryBuffer & module_data,
+                           const LoadOptions  & options,
+                           ModuleProvider     & module_provider = system_module_provider,
+                           Process            & into_process    = current_process());
+
 }
 
 #endif
\ No newline at end of file
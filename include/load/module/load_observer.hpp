@@ -0,0 +1,69 @@
+#ifndef LOAD_MODULE_LOADOBSERVER_HPP_
+#define LOAD_MODULE_LOADOBSERVER_HPP_
+
+#include <load/export.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <string_view>
+
+namespace load {
+
+enum class LoadPhase
+{
+	CopyHeaders,
+	MapSections,
+	ApplyRelocations,
+	ResolveImports,
+	ApplyPermissions,
+	DiscardSections,
+	Initialize,
+};
+
+struct LoadPhaseStats
+{
+	std::size_t bytes        = 0;
+	std::size_t relocations  = 0;
+	std::size_t imports      = 0;
+	long        minor_faults = 0;
+	long        major_faults = 0;
+};
+
+class LOAD_EXPORT LoadObserver
+{
+public:
+	virtual ~LoadObserver() = default;
+
+	virtual void phase_begin(LoadPhase phase) = 0;
+	virtual void phase_end(LoadPhase phase, const LoadPhaseStats & stats) = 0;
+
+	virtual void dependency_begin(std::string_view name) = 0;
+	virtual void dependency_end(std::string_view name, bool resolved) = 0;
+};
+
+class LOAD_EXPORT ChromeTraceObserver final : public LoadObserver
+{
+public:
+	explicit ChromeTraceObserver(std::ostream & trace_stream);
+	virtual ~ChromeTraceObserver();
+
+	virtual void phase_begin(LoadPhase phase) override;
+	virtual void phase_end(LoadPhase phase, const LoadPhaseStats & stats) override;
+
+	virtual void dependency_begin(std::string_view name) override;
+	virtual void dependency_end(std::string_view name, bool resolved) override;
+
+private:
+	void begin_event(char type, std::string_view name, std::string_view category);
+
+	std::ostream                        * _trace_stream;
+	std::chrono::steady_clock::time_point _start_time;
+	bool                                  _first_event;
+};
+
+LOAD_EXPORT std::string_view load_phase_name(LoadPhase phase);
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,26 @@
+#ifndef LOAD_MODULE_LOADOPTIONS_HPP_
+#define LOAD_MODULE_LOADOPTIONS_HPP_
+
+namespace load {
+
+class ImportResolver;
+class LoadObserver;
+
+enum class CallInstrumentation
+{
+	None,
+	CountCalls,
+	// Also samples the time stamp counter around each call, at the cost of a stack frame per call
+	CountAndTimeCalls,
+};
+
+struct LoadOptions
+{
+	LoadObserver      * observer = nullptr;
+	ImportResolver    * import_resolver = nullptr;
+	CallInstrumentation call_instrumentation = CallInstrumentation::None;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,91 @@
+#ifndef LOAD_MODULE_LOADRESULT_HPP_
+#define LOAD_MODULE_LOADRESULT_HPP_
+
+#include <load/export.hpp>
+#include <load/module/load_observer.hpp>
+
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace load {
+
+class Module;
+
+enum class LoadError
+{
+	None,
+	UnknownFormat,
+	TruncatedHeaders,
+	UnsupportedImage,
+	UnsupportedMachine,
+	MalformedImage,
+	// The image relies on something the loader does not implement, e.g. ordinal imports
+	UnsupportedFeature,
+	// The load options or the target process cannot be used with this image
+	UnsupportedOptions,
+	MissingModule,
+	MissingSymbol,
+	// A DllMain or the initializer of a dependency loaded along with the module returned FALSE
+	InitializationFailed,
+	OutOfMemory,
+	SystemError,
+};
+
+struct LoadFailure
+{
+	LoadFailure() = default;
+
+	explicit LoadFailure(LoadError error, std::string module_name = {}, std::string symbol_name = {})
+		: error { error }
+		, module_name { std::move(module_name) }
+		, symbol_name { std::move(symbol_name) }
+	{}
+
+	LoadError   error = LoadError::None;
+	// The dependency that is missing, or that lacks the missing symbol, where known
+	std::string module_name;
+	std::string symbol_name;
+	// What the throwing API would have thrown, and the phase the load failed in where it got that far
+	std::string              message;
+	std::optional<LoadPhase> phase;
+};
+
+class LoadResult
+{
+public:
+	LoadResult(std::shared_ptr<Module> module)
+		: _module { std::move(module) }
+	{}
+
+	LoadResult(LoadFailure failure)
+		: _failure { std::move(failure) }
+	{}
+
+	bool has_value() const { return _module != nullptr; }
+	explicit operator bool() const { return has_value(); }
+
+	const std::shared_ptr<Module> & value() const
+	{
+		if (!_module) throw std::logic_error("Module failed to load");
+		return _module;
+	}
+
+	Module & operator*() const { return *_module; }
+	Module * operator->() const { return _module.get(); }
+
+	const LoadFailure & error() const { return _failure; }
+
+private:
+	std::shared_ptr<Module> _module;
+	LoadFailure             _failure;
+};
+
+LOAD_EXPORT std::string_view load_error_name(LoadError error);
+
+}
+
+#endif
\ No newline at end of file
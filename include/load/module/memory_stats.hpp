@@ -0,0 +1,35 @@
+#ifndef LOAD_MODULE_MEMORYSTATS_HPP_
+#define LOAD_MODULE_MEMORYSTATS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace load {
+
+struct SectionMemoryStats
+{
+	std::string    name;
+	std::uintptr_t address;
+	std::size_t    reserved_size;
+	std::size_t    committed_size;
+	std::size_t    resident_size;
+	int            access;
+	bool           discarded;
+};
+
+struct ModuleMemoryStats
+{
+	std::size_t reserved_size  = 0;
+	std::size_t committed_size = 0;
+	std::size_t resident_size  = 0;
+	std::size_t discarded_size = 0;
+	std::size_t metadata_size  = 0;
+
+	std::vector<SectionMemoryStats> sections;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -2,7 +2,11 @@
 #define LOAD_MODULE_MODULE_HPP_
 
 #include <load/export.hpp>
+#include <load/module/call_stats.hpp>
+#include <load/module/function_hook.hpp>
+#include <load/module/memory_stats.hpp>
 
+#include <stdexcept>
 #include <string_view>
 
 namespace load {
@@ -12,6 +16,18 @@ class MemoryBuffer;
 using DataPtr = const void *;
 using ProcPtr = void (*)(...);
 
+enum class ModuleAbi
+{
+	Windows,
+	SystemV,
+};
+
+#ifdef _WIN32
+	inline constexpr ModuleAbi native_module_abi = ModuleAbi::Windows;
+#else
+	inline constexpr ModuleAbi native_module_abi = ModuleAbi::SystemV;
+#endif
+
 class Module
 {
 public:
@@ -26,6 +42,19 @@ public:
 	template <typename Fn>
 	Fn * get_proc(std::string_view name) const;
 
+	virtual ModuleMemoryStats memory_stats() const = 0;
+	virtual ModuleAbi abi() const = 0;
+
+	// Counters of the import thunks installed by LoadOptions::call_instrumentation
+	virtual ModuleCallStats call_stats() const;
+
+	// A host-side copy of the TLS template for the calling thread, created on first use; module code reaches
+	// its own TLS through the TEB and does not see this copy. Null when the module has no TLS directory.
+	virtual void * tls_data() const = 0;
+
+	// Patches the procedure's entry, so calls from within the module are redirected as well
+	virtual FunctionHook hook_proc(std::string_view name, const void * replacement);
+
 protected:
 	virtual DataPtr get_data_address(std::string_view name) const = 0;
 	virtual ProcPtr get_proc_address(std::string_view name) const = 0;
@@ -49,6 +78,20 @@ Fn * Module::get_proc(std::string_view name) const
 	return reinterpret_cast<Fn *>(get_proc_address(name));
 }
 
+inline ModuleCallStats Module::call_stats() const
+{
+	return {};
+}
+
+inline FunctionHook Module::hook_proc(std::string_view name, const void * replacement)
+{
+	const ProcPtr proc = get_proc_address(name);
+	if (proc == nullptr)
+		throw std::invalid_argument("Procedure not found");
+
+	return hook_function(reinterpret_cast<void *>(proc), replacement, abi());
+}
+
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef LOAD_MODULE_MODULEFORMAT_HPP_
+#define LOAD_MODULE_MODULEFORMAT_HPP_
+
+#include <load/export.hpp>
+#include <load/module/load_options.hpp>
+#include <load/module/load_result.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace load {
+
+class MemoryBuffer;
+class Module;
+class ModuleProvider;
+class Process;
+
+// Ordered from least to most specific; detection reports the most specific error of all probed formats
+enum class ModuleFormatError
+{
+	None,
+	UnknownFormat,
+	TruncatedHeaders,
+	// The format is known, but the image is not a kind of module it loads, e.g. an executable
+	UnsupportedImage,
+	// The format is known, but the image targets another machine or word size
+	UnsupportedMachine,
+};
+
+class LOAD_EXPORT ModuleFormat
+{
+public:
+	// Detection reads at most this many leading bytes of a module, once, and probes all formats on them
+	static constexpr std::size_t HEADER_PAGE_SIZE = 0x1000;
+
+	virtual ~ModuleFormat() = default;
+
+	virtual std::string_view name() const = 0;
+
+	// Only modules starting with these bytes are probed
+	virtual std::string_view magic() const = 0;
+	virtual ModuleFormatError probe(const char * header, std::size_t header_size) const = 0;
+
+	virtual std::shared_ptr<Module> load(const MemoryBuffer & module_data,
+	                                     const LoadOptions  & options,
+	                                     ModuleProvider     & module_provider,
+	                                     Process            & into_process) const = 0;
+
+	// Formats that report expected failures without throwing override this; by default the exceptions
+	// thrown by load() are translated
+	virtual LoadResult try_load(const MemoryBuffer & module_data,
+	                            const LoadOptions  & options,
+	                            ModuleProvider     & module_provider,
+	                            Process            & into_process) const;
+};
+
+struct ModuleFormatMatch
+{
+	const ModuleFormat * format = nullptr;
+	ModuleFormatError    error  = ModuleFormatError::UnknownFormat;
+
+	explicit operator bool() const { return format != nullptr; }
+};
+
+// Registered formats are probed after the built-in ones, in registration order. A format must stay alive
+// until it is unregistered, and its probe must not register or unregister formats.
+LOAD_EXPORT void register_module_format(const ModuleFormat & format);
+LOAD_EXPORT void unregister_module_format(const ModuleFormat & format);
+
+LOAD_EXPORT ModuleFormatMatch detect_module_format(const MemoryBuffer & module_data);
+
+LOAD_EXPORT std::string_view module_format_error_name(ModuleFormatError error);
+
+}
+
+#endif
\ No newline at end of file
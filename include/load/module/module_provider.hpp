@@ -18,6 +18,7 @@ public:
 };
 
 LOAD_EXPORT extern ModuleProvider & system_module_provider;
+LOAD_EXPORT extern ModuleProvider & syscall_module_provider;
 
 }
 
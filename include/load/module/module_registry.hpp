@@ -0,0 +1,49 @@
+#ifndef LOAD_MODULE_MODULEREGISTRY_HPP_
+#define LOAD_MODULE_MODULEREGISTRY_HPP_
+
+#include <load/export.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace load {
+
+class Module;
+
+struct RuntimeFunction
+{
+	std::uint32_t begin_address;
+	std::uint32_t end_address;
+	std::uint32_t unwind_info_address;
+};
+
+struct ModuleRange
+{
+	std::uintptr_t          base_address;
+	std::size_t             size;
+	const Module          * module;
+	const RuntimeFunction * runtime_functions;
+	std::size_t             runtime_function_count;
+};
+
+enum class ModuleEvent
+{
+	Loaded,
+	Unloaded,
+};
+
+using ModuleRangeCallback = int (*)(const ModuleRange & range, void * data);
+using ModuleEventListener = void (*)(ModuleEvent event, const ModuleRange & range, void * data);
+
+// Wait-free and async-signal-safe
+LOAD_EXPORT bool find_module_range(std::uintptr_t address, ModuleRange & range);
+LOAD_EXPORT const RuntimeFunction * find_runtime_function(std::uintptr_t address);
+
+LOAD_EXPORT int iterate_module_ranges(ModuleRangeCallback callback, void * data);
+
+LOAD_EXPORT void add_module_event_listener(ModuleEventListener listener, void * data);
+LOAD_EXPORT void remove_module_event_listener(ModuleEventListener listener, void * data);
+
+}
+
+#endif
\ No newline at end of file
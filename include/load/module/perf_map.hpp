@@ -0,0 +1,16 @@
+#ifndef LOAD_MODULE_PERFMAP_HPP_
+#define LOAD_MODULE_PERFMAP_HPP_
+
+#include <load/export.hpp>
+
+namespace load {
+
+// Publishes symbols of loaded modules and generated code in /tmp/perf-<pid>.map.
+// Setting LIBLOAD_PERF_MAP in the environment enables it at startup.
+LOAD_EXPORT void enable_perf_map();
+LOAD_EXPORT void disable_perf_map();
+LOAD_EXPORT bool is_perf_map_enabled();
+
+}
+
+#endif
\ No newline at end of file
@@ -34,6 +34,9 @@ public:
 	                                      std::size_t    table_size) = 0;
 	
 	virtual void deregister_exception_table(void * exception_table) = 0;
+
+	// Runs the generated procedure on a thread of the process and waits for it to return
+	virtual std::uint32_t execute(const void * proc, void * param) = 0;
 };
 
 LOAD_EXPORT Process & current_process();
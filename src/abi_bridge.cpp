@@ -0,0 +1,87 @@
+#include <config.hpp>
+#include "abi_bridge.hpp"
+#include "platform/code_address.hpp"
+
+#if defined(LIBLOAD_ARCH_X86_64) && defined(LIBLOAD_ENABLE_ARCH_X86_64)
+	#include "arch/x64/abi_thunks.hpp"
+	#define LIBLOAD_HAS_ABI_THUNKS 1
+#endif
+
+#include <stdexcept>
+
+namespace load::detail {
+
+namespace {
+
+std::unique_ptr<CodeChunk> make_abi_thunk(const void * target, ModuleAbi from_abi, ModuleAbi to_abi)
+{
+	std::unique_ptr<CodeChunk> code_chunk;
+#ifdef LIBLOAD_HAS_ABI_THUNKS
+	const auto target_addr = reinterpret_cast<std::uintptr_t>(target);
+	if (from_abi == ModuleAbi::Windows && to_abi == ModuleAbi::SystemV)
+		code_chunk = make_x64_win64_to_sysv_thunk(target_addr, AbiBridge::GENERIC_ARGC);
+	else if (from_abi == ModuleAbi::SystemV && to_abi == ModuleAbi::Windows)
+		code_chunk = make_x64_sysv_to_win64_thunk(target_addr, AbiBridge::GENERIC_ARGC);
+#endif
+	if (code_chunk == nullptr)
+		throw std::logic_error("Unsupported ABI bridge");
+
+	return code_chunk;
+}
+
+}
+
+AbiBridge::AbiBridge(ModuleAbi module_abi, ModuleAbi host_abi)
+	: _module_abi { module_abi }
+	, _host_abi { host_abi }
+	, _code_arena { 0x1000 }
+{
+	if (!is_abi_bridge_supported(module_abi, host_abi))
+		throw std::logic_error("Unsupported ABI bridge");
+}
+
+const void * AbiBridge::import_thunk(const void * host_proc)
+{
+	if (!is_code_address(host_proc)) return host_proc;
+	return import_proc_thunk(host_proc);
+}
+
+const void * AbiBridge::import_proc_thunk(const void * host_proc)
+{
+	return get_thunk(_import_thunks, host_proc, _module_abi, _host_abi);
+}
+
+const void * AbiBridge::export_thunk(const void * module_proc)
+{
+	return get_thunk(_export_thunks, module_proc, _host_abi, _module_abi);
+}
+
+const void * AbiBridge::get_thunk(ThunkMap & thunks, const void * target, ModuleAbi from_abi, ModuleAbi to_abi)
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+
+	auto thunk_it = thunks.find(target);
+	if (thunk_it == thunks.end()) {
+		const auto code_chunk = make_abi_thunk(target, from_abi, to_abi);
+		thunk_it = thunks.emplace(target, _code_arena.emit(*code_chunk, "libload_abi_thunk")).first;
+	}
+
+	return thunk_it->second.address;
+}
+
+bool is_abi_bridge_supported(ModuleAbi module_abi, ModuleAbi host_abi)
+{
+#ifdef LIBLOAD_HAS_ABI_THUNKS
+	return module_abi != host_abi;
+#else
+	return false;
+#endif
+}
+
+std::unique_ptr<AbiBridge> make_abi_bridge(ModuleAbi module_abi, ModuleAbi host_abi)
+{
+	if (!is_abi_bridge_supported(module_abi, host_abi)) return nullptr;
+	return std::make_unique<AbiBridge>(module_abi, host_abi);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef LOAD_SRC_ABIBRIDGE_HPP_
+#define LOAD_SRC_ABIBRIDGE_HPP_
+
+#include "code_arena.hpp"
+
+#include <load/module/module.hpp>
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace load::detail {
+
+class AbiBridge
+{
+public:
+	enum { GENERIC_ARGC = 8 };
+
+	AbiBridge(ModuleAbi module_abi, ModuleAbi host_abi);
+	AbiBridge(const AbiBridge &) = delete;
+	AbiBridge & operator=(const AbiBridge &) = delete;
+
+	ModuleAbi module_abi() const { return _module_abi; }
+
+	const void * import_thunk(const void * host_proc);
+	const void * import_proc_thunk(const void * host_proc);
+	const void * export_thunk(const void * module_proc);
+
+private:
+	using ThunkMap = std::unordered_map<const void *, CodeStub>;
+
+	const void * get_thunk(ThunkMap & thunks, const void * target, ModuleAbi from_abi, ModuleAbi to_abi);
+
+	ModuleAbi  _module_abi;
+	ModuleAbi  _host_abi;
+	std::mutex _mutex;
+	CodeArena  _code_arena;
+	ThunkMap   _import_thunks;
+	ThunkMap   _export_thunks;
+};
+
+bool is_abi_bridge_supported(ModuleAbi module_abi, ModuleAbi host_abi);
+std::unique_ptr<AbiBridge> make_abi_bridge(ModuleAbi module_abi, ModuleAbi host_abi);
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,253 @@
+#include "abi_thunks.hpp"
+#include "eh_frame.hpp"
+#include "../../code_chunk.hpp"
+
+#include <algorithm>
+
+namespace load::detail {
+
+namespace {
+
+constexpr std::uint32_t WIN64_SHADOW_SIZE = 0x20;
+constexpr std::uint32_t XMM_SAVE_SIZE     = 10 * 16;
+
+std::uint32_t align_frame(std::uint32_t size)
+{
+	return (size + 15) & ~std::uint32_t(15);
+}
+
+void append_movdqu_xmm(bool store, unsigned int xmm, std::uint32_t rsp_disp, CodeAssembler & code_chunk)
+{
+	code_chunk.append('\xf3');
+	if (xmm >= 8) code_chunk.append('\x44');
+	code_chunk.append('\x0f');
+	code_chunk.append(store ? '\x7f' : '\x6f');
+	code_chunk.append(char(0x84 | (xmm & 7) << 3));
+	code_chunk.append('\x24');
+	code_chunk.append_imm32(rsp_disp);
+}
+
+void append_frame_setup(CodeAssembler & code_chunk)
+{
+	code_chunk.append("\x55" /* push rbp */);
+	code_chunk.cfi_def_cfa_offset(16);
+	code_chunk.cfi_offset(DWARF_RBP, -16);
+	code_chunk.append("\x48\x89\xe5" /* mov rbp, rsp */);
+	code_chunk.cfi_def_cfa_register(DWARF_RBP);
+}
+
+void copy_stack_argument(std::uint32_t rbp_disp, std::uint32_t rsp_disp, CodeAssembler & code_chunk)
+{
+	code_chunk.append("\x48\x8b\x85" /* mov rax, [rbp + disp32] */);
+	code_chunk.append_imm32(rbp_disp);
+	code_chunk.append("\x48\x89\x84\x24" /* mov [rsp + disp32], rax */);
+	code_chunk.append_imm32(rsp_disp);
+}
+
+}
+
+std::unique_ptr<CodeChunk> make_x64_win64_to_sysv_thunk(std::uintptr_t target, unsigned int argc)
+{
+	const unsigned int stack_argc = argc > 6 ? argc - 6 : 0;
+	const std::uint32_t xmm_save_offset = align_frame(8 * stack_argc);
+	const std::uint32_t frame_size = xmm_save_offset + XMM_SAVE_SIZE;
+
+	auto code_chunk = std::make_unique<CodeAssembler>();
+	append_frame_setup(*code_chunk);
+	code_chunk->append("\x57" /* push rdi */);
+	code_chunk->cfi_offset(DWARF_RDI, -24);
+	code_chunk->append("\x56" /* push rsi */);
+	code_chunk->cfi_offset(DWARF_RSI, -32);
+	code_chunk->append("\x48\x81\xec" /* sub rsp, imm32 */);
+	code_chunk->append_imm32(frame_size);
+
+	for (unsigned int xmm = 6; xmm < 16; ++xmm)
+		append_movdqu_xmm(true, xmm, xmm_save_offset + 16 * (xmm - 6), *code_chunk);
+
+	for (unsigned int i = 0; i < stack_argc; ++i)
+		copy_stack_argument(0x10 + WIN64_SHADOW_SIZE + 8 * (6 + i - 4), 8 * i, *code_chunk);
+
+	code_chunk->append(
+		"\x48\x89\xcf" // mov rdi, rcx
+		"\x48\x89\xd6" // mov rsi, rdx
+		"\x4c\x89\xc2" // mov rdx, r8
+		"\x4c\x89\xc9" // mov rcx, r9
+	);
+	if (argc > 4) {
+		code_chunk->append("\x4c\x8b\x85" /* mov r8, [rbp + disp32] */);
+		code_chunk->append_imm32(0x10 + WIN64_SHADOW_SIZE);
+	}
+	if (argc > 5) {
+		code_chunk->append("\x4c\x8b\x8d" /* mov r9, [rbp + disp32] */);
+		code_chunk->append_imm32(0x10 + WIN64_SHADOW_SIZE + 8);
+	}
+
+	code_chunk->append_call(target);
+
+	for (unsigned int xmm = 6; xmm < 16; ++xmm)
+		append_movdqu_xmm(false, xmm, xmm_save_offset + 16 * (xmm - 6), *code_chunk);
+
+	code_chunk->append("\x48\x8d\x65\xf0" /* lea rsp, [rbp - 16] */);
+	code_chunk->append("\x5e" /* pop rsi */);
+	code_chunk->cfi_restore(DWARF_RSI);
+	code_chunk->append("\x5f" /* pop rdi */);
+	code_chunk->cfi_restore(DWARF_RDI);
+	code_chunk->append("\x5d" /* pop rbp */);
+	code_chunk->cfi_def_cfa(DWARF_RSP, 8);
+	code_chunk->cfi_restore(DWARF_RBP);
+	code_chunk->append("\xc3" /* ret */);
+	return code_chunk;
+}
+
+std::unique_ptr<CodeChunk> make_x64_sysv_to_win64_thunk(std::uintptr_t target, unsigned int argc)
+{
+	const unsigned int stack_argc = argc > 4 ? argc - 4 : 0;
+	const std::uint32_t frame_size = align_frame(WIN64_SHADOW_SIZE + 8 * stack_argc);
+
+	auto code_chunk = std::make_unique<CodeAssembler>();
+	append_frame_setup(*code_chunk);
+	code_chunk->append("\x48\x81\xec" /* sub rsp, imm32 */);
+	code_chunk->append_imm32(frame_size);
+
+	if (argc > 4) {
+		code_chunk->append("\x4c\x89\x84\x24" /* mov [rsp + disp32], r8 */);
+		code_chunk->append_imm32(WIN64_SHADOW_SIZE);
+	}
+	if (argc > 5) {
+		code_chunk->append("\x4c\x89\x8c\x24" /* mov [rsp + disp32], r9 */);
+		code_chunk->append_imm32(WIN64_SHADOW_SIZE + 8);
+	}
+	for (unsigned int i = 6; i < argc; ++i)
+		copy_stack_argument(0x10 + 8 * (i - 6), WIN64_SHADOW_SIZE + 8 * (i - 4), *code_chunk);
+
+	code_chunk->append(
+		"\x49\x89\xc9" // mov r9, rcx
+		"\x49\x89\xd0" // mov r8, rdx
+		"\x48\x89\xf2" // mov rdx, rsi
+		"\x48\x89\xf9" // mov rcx, rdi
+	);
+
+	code_chunk->append_call(target);
+	code_chunk->append("\xc9" /* leave */);
+	code_chunk->cfi_def_cfa(DWARF_RSP, 8);
+	code_chunk->cfi_restore(DWARF_RBP);
+	code_chunk->append("\xc3" /* ret */);
+	return code_chunk;
+}
+
+std::unique_ptr<CodeChunk> make_x64_counting_thunk(std::uintptr_t target, std::uintptr_t counter)
+{
+	auto code_chunk = std::make_unique<CodeAssembler>();
+	code_chunk->append("\x49\xbb" /* mov r11, imm64 */);
+	code_chunk->append_imm64(counter);
+	code_chunk->append("\xf0\x49\xff\x03" /* lock inc qword [r11] */);
+	code_chunk->append(std::string_view("\xff\x25\x00\x00\x00\x00" /* jmp [rip] */, 6));
+	code_chunk->append_imm64(target);
+	return code_chunk;
+}
+
+std::unique_ptr<CodeChunk> make_x64_entry_hook_thunk(std::uintptr_t target, std::uintptr_t hook,
+                                                     std::uintptr_t context)
+{
+	// Argument registers of both calling conventions, plus rax (vector count) and r10 (static chain)
+	constexpr std::uint32_t gpr_save_size = 8 * 8;
+	constexpr unsigned int xmm_arg_count = 8;
+	constexpr std::uint32_t frame_size = WIN64_SHADOW_SIZE + 16 * xmm_arg_count;
+
+	auto code_chunk = std::make_unique<CodeAssembler>();
+	append_frame_setup(*code_chunk);
+	code_chunk->append(
+		"\x57"     // push rdi
+		"\x56"     // push rsi
+		"\x52"     // push rdx
+		"\x51"     // push rcx
+		"\x41\x50" // push r8
+		"\x41\x51" // push r9
+		"\x41\x52" // push r10
+		"\x50"     // push rax
+		"\x48\x81\xec" // sub rsp, imm32
+	);
+	code_chunk->append_imm32(frame_size);
+	for (unsigned int xmm = 0; xmm < xmm_arg_count; ++xmm)
+		append_movdqu_xmm(true, xmm, WIN64_SHADOW_SIZE + 16 * xmm, *code_chunk);
+
+	code_chunk->append("\x48\xbf" /* mov rdi, imm64 */);
+	code_chunk->append_imm64(context);
+	code_chunk->append("\x48\x89\xf9" /* mov rcx, rdi */);
+	code_chunk->append_call(hook);
+
+	for (unsigned int xmm = 0; xmm < xmm_arg_count; ++xmm)
+		append_movdqu_xmm(false, xmm, WIN64_SHADOW_SIZE + 16 * xmm, *code_chunk);
+	code_chunk->append("\x48\x8d\x65" /* lea rsp, [rbp - disp8] */);
+	code_chunk->append(char(-std::int32_t(gpr_save_size)));
+	code_chunk->append(
+		"\x58"     // pop rax
+		"\x41\x5a" // pop r10
+		"\x41\x59" // pop r9
+		"\x41\x58" // pop r8
+		"\x59"     // pop rcx
+		"\x5a"     // pop rdx
+		"\x5e"     // pop rsi
+		"\x5f"     // pop rdi
+	);
+	code_chunk->append("\x5d" /* pop rbp */);
+	code_chunk->cfi_def_cfa(DWARF_RSP, 8);
+	code_chunk->cfi_restore(DWARF_RBP);
+	code_chunk->append(std::string_view("\xff\x25\x00\x00\x00\x00" /* jmp [rip] */, 6));
+	code_chunk->append_imm64(target);
+	return code_chunk;
+}
+
+std::unique_ptr<CodeChunk> make_x64_win64_timing_thunk(std::uintptr_t target, std::uintptr_t counter,
+                                                       unsigned int argc)
+{
+	const unsigned int stack_argc = argc > 4 ? argc - 4 : 0;
+	const std::uint32_t frame_size = align_frame(WIN64_SHADOW_SIZE + 8 * stack_argc);
+
+	auto code_chunk = std::make_unique<CodeAssembler>();
+	append_frame_setup(*code_chunk);
+	code_chunk->append("\x53" /* push rbx */);
+	code_chunk->cfi_offset(DWARF_RBX, -24);
+	code_chunk->append("\x41\x54" /* push r12 */);
+	code_chunk->cfi_offset(DWARF_R12, -32);
+	code_chunk->append("\x48\x81\xec" /* sub rsp, imm32 */);
+	code_chunk->append_imm32(frame_size);
+
+	code_chunk->append(
+		"\x49\x89\xd2"             // mov r10, rdx
+		"\x0f\x31"                 // rdtsc
+		"\x48\xc1\xe2\x20"         // shl rdx, 32
+		"\x48\x09\xd0"             // or rax, rdx
+		"\x48\x89\xc3"             // mov rbx, rax
+		"\x4c\x89\xd2"             // mov rdx, r10
+		"\x49\xbc"                 // mov r12, imm64
+	);
+	code_chunk->append_imm64(counter);
+
+	for (unsigned int i = 0; i < stack_argc; ++i)
+		copy_stack_argument(0x10 + WIN64_SHADOW_SIZE + 8 * i, WIN64_SHADOW_SIZE + 8 * i, *code_chunk);
+
+	code_chunk->append_call(target);
+	code_chunk->append(
+		"\x49\x89\xc2"             // mov r10, rax
+		"\x0f\x31"                 // rdtsc
+		"\x48\xc1\xe2\x20"         // shl rdx, 32
+		"\x48\x09\xd0"             // or rax, rdx
+		"\x48\x29\xd8"             // sub rax, rbx
+		"\xf0\x49\x01\x44\x24\x08" // lock add [r12 + 8], rax
+		"\xf0\x49\xff\x04\x24"     // lock inc qword [r12]
+		"\x4c\x89\xd0"             // mov rax, r10
+		"\x48\x8d\x65\xf0"         // lea rsp, [rbp - 16]
+	);
+	code_chunk->append("\x41\x5c" /* pop r12 */);
+	code_chunk->cfi_restore(DWARF_R12);
+	code_chunk->append("\x5b" /* pop rbx */);
+	code_chunk->cfi_restore(DWARF_RBX);
+	code_chunk->append("\x5d" /* pop rbp */);
+	code_chunk->cfi_def_cfa(DWARF_RSP, 8);
+	code_chunk->cfi_restore(DWARF_RBP);
+	code_chunk->append("\xc3" /* ret */);
+	return code_chunk;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef LOAD_SRC_ARCH_X64_ABITHUNKS_HPP_
+#define LOAD_SRC_ARCH_X64_ABITHUNKS_HPP_
+
+#include <load/codegen/code_chunk.hpp>
+
+#include <cstdint>
+#include <memory>
+
+namespace load::detail {
+
+std::unique_ptr<CodeChunk> make_x64_win64_to_sysv_thunk(std::uintptr_t target, unsigned int argc);
+std::unique_ptr<CodeChunk> make_x64_sysv_to_win64_thunk(std::uintptr_t target, unsigned int argc);
+
+// The counter points at a pair of 64-bit words, the call count followed by the cycle count
+std::unique_ptr<CodeChunk> make_x64_counting_thunk(std::uintptr_t target, std::uintptr_t counter);
+// Calls hook(context) with every argument register preserved, then jumps to the target
+std::unique_ptr<CodeChunk> make_x64_entry_hook_thunk(std::uintptr_t target, std::uintptr_t hook,
+                                                     std::uintptr_t context);
+
+std::unique_ptr<CodeChunk> make_x64_win64_timing_thunk(std::uintptr_t target, std::uintptr_t counter,
+                                                       unsigned int argc);
+
+}
+
+#endif
\ No newline at end of file
@@ -1,13 +1,15 @@
 #include <config.hpp>
 #include "code_generator.hpp"
+#include "eh_frame.hpp"
 #include "../../code_chunk.hpp"
 
 #include <load/codegen.hpp>
 
-#include <climits>
+#include <algorithm>
 #include <limits>
 #include <memory>
 #include <stdexcept>
+#include <unordered_map>
 
 namespace load::detail {
 
@@ -15,6 +17,8 @@ class X64LinuxServices final : public SystemServices
 {
 public:
 	virtual std::unique_ptr<CodeChunk> make_syscall(int code, const ParameterList & params) const override;
+	virtual std::unique_ptr<CodeChunk> make_syscall_proc(int code) const override;
+	virtual std::optional<int> syscall_code(std::string_view name) const override;
 };
 
 class X64CallingConvention final : public CallingConvention
@@ -30,19 +34,9 @@ public:
 	virtual std::unique_ptr<CodeChunk> invoke_proc(const CodeLocation  & label,
 	                                               const ParameterList & params,
 	                                               std::uintmax_t        this_param) const override;
-};
-
-class X64RelativeCall final : public CodeChunk
-{
-public:
-	X64RelativeCall(const CodeLocation  & location, const ParameterList & params);
-
-	virtual std::size_t max_size() const override;
-	virtual std::size_t emit(void * location, CodeSink & code_sink) const override;
 
-private:
-	FixedCodeChunk _set_params_chunk;
-	std::unique_ptr<CodeLocation> _location;
+	virtual std::unique_ptr<CodeChunk> make_trampoline(unsigned int argc) const override;
+	virtual std::unique_ptr<CodeChunk> return_if_false(unsigned int argc, std::uintmax_t value) const override;
 };
 
 #ifdef LIBLOAD_ARCH_X86_64
@@ -57,95 +51,118 @@ const CodeGenerator & native_code_generator()
 
 namespace {
 
-const char * PUSH_IMM32    = "\x68";
-const char * MOV_RAX_IMM64 = "\x48\xb8";
-const char * MOV_RCX_IMM64 = "\x48\xb9";
-const char * MOV_RDX_IMM64 = "\x48\xba";
-const char * MOV_RSI_IMM64 = "\x48\xbe";
-const char * MOV_RDI_IMM64 = "\x48\xbf";
-const char * MOV_R8_IMM64  = "\x49\xb8";
-const char * MOV_R9_IMM64  = "\x49\xb9";
-const char * MOV_R10_IMM64 = "\x49\xba";
-
-void append_imm32(std::uintmax_t value, FixedCodeChunk & code_chunk)
+enum X64Register
 {
-	if (value > std::numeric_limits<std::uint32_t>::max())
-		throw std::overflow_error("Immediate value exceeds 32 bits");
+	RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+	R8,  R9,  R10, R11, R12, R13, R14, R15,
+};
 
-	for (std::size_t i = 0; i < sizeof(std::uint32_t); ++i)
-		code_chunk.append((value >> (i * CHAR_BIT)) & UCHAR_MAX);
+const char * MOV_RCX_RBX_DISP32 = "\x48\x8b\x8b";
+const char * MOV_RDX_RBX_DISP32 = "\x48\x8b\x93";
+const char * MOV_R8_RBX_DISP32  = "\x4c\x8b\x83";
+const char * MOV_R9_RBX_DISP32  = "\x4c\x8b\x8b";
+const char * MOV_RAX_RBX_DISP32 = "\x48\x8b\x83";
+const char * MOV_RBX_DISP32_RAX = "\x48\x89\x83";
+const char * MOV_RSP_DISP32_RAX = "\x48\x89\x84\x24";
+
+bool fits_simm32(std::uint64_t value)
+{
+	const auto svalue = static_cast<std::int64_t>(value);
+	return svalue >= std::numeric_limits<std::int32_t>::min()
+	    && svalue <= std::numeric_limits<std::int32_t>::max();
 }
 
-void append_imm64(std::uintmax_t value, FixedCodeChunk & code_chunk)
+void append_mov_imm(X64Register reg, std::uintmax_t value, CodeAssembler & code_chunk)
 {
 	if (value > std::numeric_limits<std::uint64_t>::max())
 		throw std::overflow_error("Immediate value exceeds 64 bits");
 
-	for (std::size_t i = 0; i < sizeof(std::uint64_t); ++i)
-		code_chunk.append((value >> (i * CHAR_BIT)) & UCHAR_MAX);
+	const char rex_b = (reg & 8) ? '\x41' : '\0';
+	const char reg_bits = reg & 7;
+	if (value == 0) {
+		if (rex_b) code_chunk.append('\x45');
+		code_chunk.append('\x31' /* xor r32, r32 */);
+		code_chunk.append(char(0xc0 | reg_bits << 3 | reg_bits));
+	} else if (value <= std::numeric_limits<std::uint32_t>::max()) {
+		if (rex_b) code_chunk.append(rex_b);
+		code_chunk.append(char(0xb8 | reg_bits) /* mov r32, imm32 */);
+		code_chunk.append_imm32(value);
+	} else if (fits_simm32(value)) {
+		code_chunk.append(char(0x48 | (reg >> 3)));
+		code_chunk.append('\xc7' /* mov r/m64, simm32 */);
+		code_chunk.append(char(0xc0 | reg_bits));
+		code_chunk.append_imm32(value & std::numeric_limits<std::uint32_t>::max());
+	} else {
+		code_chunk.append(char(0x48 | (reg >> 3)));
+		code_chunk.append(char(0xb8 | reg_bits) /* mov r64, imm64 */);
+		code_chunk.append_imm64(value);
+	}
+}
+
+void append_push_imm(std::uintmax_t value, CodeAssembler & code_chunk)
+{
+	if (fits_simm32(value)) {
+		code_chunk.append('\x68' /* push simm32 */);
+		code_chunk.append_imm32(value & std::numeric_limits<std::uint32_t>::max());
+	} else {
+		append_mov_imm(RAX, value, code_chunk);
+		code_chunk.append('\x50' /* push rax */);
+	}
+}
+
+void append_frame_setup(CodeAssembler & code_chunk)
+{
+	code_chunk.append("\x55" /* push rbp */);
+	code_chunk.cfi_def_cfa_offset(16);
+	code_chunk.cfi_offset(DWARF_RBP, -16);
+	code_chunk.append("\x48\x89\xe5" /* mov rbp, rsp */);
+	code_chunk.cfi_def_cfa_register(DWARF_RBP);
 }
 
-void set_proc_parameters(const ParameterList & params, FixedCodeChunk & code_chunk)
+void set_proc_parameters(const ParameterList & params, CodeAssembler & code_chunk)
 {
 	auto params_it = params.begin();
 	const auto params_end = params.end();
 	if (params_it == params_end) return;
 
-	code_chunk.append(MOV_RCX_IMM64);
-	append_imm64(*params_it++, code_chunk);
+	append_mov_imm(RCX, *params_it++, code_chunk);
 	if (params_it == params_end) return;
 
-	code_chunk.append(MOV_RDX_IMM64);
-	append_imm64(*params_it++, code_chunk);
+	append_mov_imm(RDX, *params_it++, code_chunk);
 	if (params_it == params_end) return;
 
-	code_chunk.append(MOV_R8_IMM64);
-	append_imm64(*params_it++, code_chunk);
+	append_mov_imm(R8, *params_it++, code_chunk);
 	if (params_it == params_end) return;
 
-	code_chunk.append(MOV_R9_IMM64);
-	append_imm64(*params_it++, code_chunk);
+	append_mov_imm(R9, *params_it++, code_chunk);
 	if (params_it == params_end) return;
 
-	for (auto params_rit = params.rbegin(); params_rit.base() != params_it; ++params_rit) {
-		const auto value = static_cast<std::uint64_t>(*params_rit);
-		
-		code_chunk.append(PUSH_IMM32);
-		append_imm32((value >>  0) & std::uint32_t(~0), code_chunk);
-
-		code_chunk.append(PUSH_IMM32);
-		append_imm32((value >> 32) & std::uint32_t(~0), code_chunk);
-	}
+	for (auto params_rit = params.rbegin(); params_rit.base() != params_it; ++params_rit)
+		append_push_imm(*params_rit, code_chunk);
 }
 
-void set_syscall_parameters(const ParameterList & params, FixedCodeChunk & code_chunk)
+void set_syscall_parameters(const ParameterList & params, CodeAssembler & code_chunk)
 {
 	auto params_it = params.begin();
 	const auto params_end = params.end();
 	if (params_it == params_end) return;
 
-	code_chunk.append(MOV_RDI_IMM64);
-	append_imm64(*params_it++, code_chunk);
+	append_mov_imm(RDI, *params_it++, code_chunk);
 	if (params_it == params_end) return;
 
-	code_chunk.append(MOV_RSI_IMM64);
-	append_imm64(*params_it++, code_chunk);
+	append_mov_imm(RSI, *params_it++, code_chunk);
 	if (params_it == params_end) return;
 
-	code_chunk.append(MOV_RDX_IMM64);
-	append_imm64(*params_it++, code_chunk);
+	append_mov_imm(RDX, *params_it++, code_chunk);
 	if (params_it == params_end) return;
 
-	code_chunk.append(MOV_R10_IMM64);
-	append_imm64(*params_it++, code_chunk);
+	append_mov_imm(R10, *params_it++, code_chunk);
 	if (params_it == params_end) return;
 
-	code_chunk.append(MOV_R8_IMM64);
-	append_imm64(*params_it++, code_chunk);
+	append_mov_imm(R8, *params_it++, code_chunk);
 	if (params_it == params_end) return;
 
-	code_chunk.append(MOV_R9_IMM64);
-	append_imm64(*params_it++, code_chunk);
+	append_mov_imm(R9, *params_it++, code_chunk);
 	if (params_it == params_end) return;
 
 	throw std::invalid_argument("Too many syscall parameters");
@@ -179,45 +196,106 @@ const SystemServices * X64CodeGenerator::get_system_services(std::string_view un
 
 std::unique_ptr<CodeChunk> X64LinuxServices::make_syscall(int code, const ParameterList & params) const
 {
-	auto code_chunk = std::make_unique<FixedCodeChunk>();
+	auto code_chunk = std::make_unique<CodeAssembler>();
 	set_syscall_parameters(params, *code_chunk);
 
-	code_chunk->append(MOV_RAX_IMM64);
-	append_imm64(code, *code_chunk);
+	append_mov_imm(RAX, code, *code_chunk);
 
 	code_chunk->append("\x0f\x05" /* syscall */);
 	return code_chunk;
 }
 
-std::unique_ptr<CodeChunk> X64CallingConvention::make_prolog(unsigned int) const
+std::unique_ptr<CodeChunk> X64LinuxServices::make_syscall_proc(int code) const
 {
-	return std::make_unique<CodeChunkLiteral>(
-		"\x55"         // push rbp
-		"\x48\x89\xe5" // mov rbp, rsp
+	auto code_chunk = std::make_unique<CodeAssembler>();
+	code_chunk->append("\x57" /* push rdi */);
+	code_chunk->cfi_def_cfa_offset(16);
+	code_chunk->cfi_offset(DWARF_RDI, -16);
+	code_chunk->append("\x56" /* push rsi */);
+	code_chunk->cfi_def_cfa_offset(24);
+	code_chunk->cfi_offset(DWARF_RSI, -24);
+	code_chunk->append(
+		"\x48\x89\xcf"         // mov rdi, rcx
+		"\x48\x89\xd6"         // mov rsi, rdx
+		"\x4c\x89\xc2"         // mov rdx, r8
+		"\x4d\x89\xca"         // mov r10, r9
+		"\x4c\x8b\x44\x24\x38" // mov r8, [rsp + 0x38]
+		"\x4c\x8b\x4c\x24\x40" // mov r9, [rsp + 0x40]
 	);
+
+	append_mov_imm(RAX, code, *code_chunk);
+
+	code_chunk->append("\x0f\x05" /* syscall */);
+	code_chunk->append("\x5e" /* pop rsi */);
+	code_chunk->cfi_def_cfa_offset(16);
+	code_chunk->cfi_restore(DWARF_RSI);
+	code_chunk->append("\x5f" /* pop rdi */);
+	code_chunk->cfi_def_cfa_offset(8);
+	code_chunk->cfi_restore(DWARF_RDI);
+	code_chunk->append("\xc3" /* ret */);
+	return code_chunk;
+}
+
+std::optional<int> X64LinuxServices::syscall_code(std::string_view name) const
+{
+	static const std::unordered_map<std::string_view, int> syscall_codes = {
+		{ "read",             0 }, { "write",            1 }, { "open",             2 },
+		{ "close",            3 }, { "stat",             4 }, { "fstat",            5 },
+		{ "poll",             7 }, { "lseek",            8 }, { "mmap",             9 },
+		{ "mprotect",        10 }, { "munmap",          11 }, { "brk",             12 },
+		{ "ioctl",           16 }, { "pread64",         17 }, { "pwrite64",        18 },
+		{ "readv",           19 }, { "writev",          20 }, { "sched_yield",     24 },
+		{ "madvise",         28 }, { "dup",             32 }, { "nanosleep",       35 },
+		{ "getpid",          39 }, { "socket",          41 }, { "connect",         42 },
+		{ "accept",          43 }, { "sendto",          44 }, { "recvfrom",        45 },
+		{ "bind",            49 }, { "listen",          50 }, { "exit",            60 },
+		{ "fcntl",           72 }, { "fsync",           74 }, { "fdatasync",       75 },
+		{ "ftruncate",       77 }, { "gettid",         186 }, { "futex",          202 },
+		{ "clock_gettime",  228 }, { "exit_group",     231 }, { "epoll_wait",     232 },
+		{ "epoll_ctl",      233 }, { "openat",         257 }, { "eventfd2",       290 },
+		{ "epoll_create1",  291 }, { "pipe2",          293 }, { "getrandom",      318 },
+	};
+
+	const auto code_it = syscall_codes.find(name);
+	if (code_it == syscall_codes.end()) return std::nullopt;
+	return code_it->second;
+}
+
+std::unique_ptr<CodeChunk> X64CallingConvention::make_prolog(unsigned int) const
+{
+	auto code_chunk = std::make_unique<CodeAssembler>();
+	append_frame_setup(*code_chunk);
+	return code_chunk;
 }
 
 std::unique_ptr<CodeChunk> X64CallingConvention::make_epilog(unsigned int) const
 {
-	return std::make_unique<CodeChunkLiteral>(
-		"\x48\x89\xec" // mov rsp, rbp
-		"\x5d"         // pop rbp
-		"\xc3"         // ret
-	);
+	auto code_chunk = std::make_unique<CodeAssembler>();
+	code_chunk->cfi_remember_state();
+	code_chunk->append("\x48\x89\xec" /* mov rsp, rbp */);
+	code_chunk->append("\x5d" /* pop rbp */);
+	code_chunk->cfi_def_cfa(DWARF_RSP, 8);
+	code_chunk->cfi_restore(DWARF_RBP);
+	code_chunk->append("\xc3" /* ret */);
+	code_chunk->cfi_restore_state();
+	return code_chunk;
 }
 
 std::unique_ptr<CodeChunk> X64CallingConvention::set_return_value(std::uintmax_t value) const
 {
-	auto code_chunk = std::make_unique<FixedCodeChunk>();
-	code_chunk->append(MOV_RAX_IMM64);
-	append_imm64(value, *code_chunk);
+	auto code_chunk = std::make_unique<CodeAssembler>();
+	append_mov_imm(RAX, value, *code_chunk);
 	return code_chunk;
 }
 
 std::unique_ptr<CodeChunk> X64CallingConvention::invoke_proc(const CodeLocation  & location,
                                                              const ParameterList & params) const
 {
-	return std::make_unique<X64RelativeCall>(location, params);
+	auto code_chunk = std::make_unique<CodeAssembler>();
+	set_proc_parameters(params, *code_chunk);
+
+	code_chunk->append_call(location.absolute_address(nullptr));
+	return code_chunk;
 }
 
 std::unique_ptr<CodeChunk> X64CallingConvention::invoke_proc(const CodeLocation  & location,
@@ -225,32 +303,79 @@ std::unique_ptr<CodeChunk> X64CallingConvention::invoke_proc(const CodeLocation
                                                              std::uintmax_t        this_param) const
 {
 	ParameterList proc_params;
+	proc_params.reserve(params.size() + 1);
 	proc_params.push_back(this_param);
 	std::copy(params.begin(), params.end(), std::back_inserter(proc_params));
-	return std::make_unique<X64RelativeCall>(location, std::move(proc_params));
+	return invoke_proc(location, proc_params);
 }
 
-X64RelativeCall::X64RelativeCall(const CodeLocation & location, const ParameterList & params)
-	: _location { location.clone() }
+std::unique_ptr<CodeChunk> X64CallingConvention::make_trampoline(unsigned int argc) const
 {
-	set_proc_parameters(params, _set_params_chunk);
-}
+	const char * const param_regs[] = {
+		MOV_RCX_RBX_DISP32, MOV_RDX_RBX_DISP32, MOV_R8_RBX_DISP32, MOV_R9_RBX_DISP32
+	};
+	const unsigned int reg_argc = std::min(argc, 4u);
+	const unsigned int stack_argc = argc - reg_argc;
+
+	std::uint32_t frame_size = 0x20 + 8 * stack_argc;
+	if (frame_size % 16 == 0) frame_size += 8;
+
+	auto code_chunk = std::make_unique<CodeAssembler>();
+	append_frame_setup(*code_chunk);
+	code_chunk->append("\x53" /* push rbx */);
+	code_chunk->cfi_offset(DWARF_RBX, -24);
+	code_chunk->append(
+		"\x48\x89\xcb" // mov rbx, rcx
+		"\x48\x81\xec" // sub rsp, imm32
+	);
+	code_chunk->append_imm32(frame_size);
 
-std::size_t X64RelativeCall::max_size() const
-{
-	return _set_params_chunk.max_size() + 1 + sizeof(std::uint32_t);
+	for (unsigned int i = 0; i < stack_argc; ++i) {
+		code_chunk->append(MOV_RAX_RBX_DISP32);
+		code_chunk->append_imm32(8 * (1 + reg_argc + i));
+		code_chunk->append(MOV_RSP_DISP32_RAX);
+		code_chunk->append_imm32(0x20 + 8 * i);
+	}
+
+	for (unsigned int i = 0; i < reg_argc; ++i) {
+		code_chunk->append(param_regs[i]);
+		code_chunk->append_imm32(8 * (1 + i));
+	}
+
+	code_chunk->append("\xff\x13" /* call [rbx] */);
+	code_chunk->append(MOV_RBX_DISP32_RAX);
+	code_chunk->append_imm32(8 * (1 + argc));
+
+	code_chunk->append("\x48\x8d\x65\xf8" /* lea rsp, [rbp - 8] */);
+	code_chunk->append("\x5b" /* pop rbx */);
+	code_chunk->cfi_restore(DWARF_RBX);
+	code_chunk->append("\x5d" /* pop rbp */);
+	code_chunk->cfi_def_cfa(DWARF_RSP, 8);
+	code_chunk->cfi_restore(DWARF_RBP);
+	code_chunk->append("\xc3" /* ret */);
+	return code_chunk;
 }
 
-std::size_t X64RelativeCall::emit(void * location, CodeSink & code_sink) const
+std::unique_ptr<CodeChunk> X64CallingConvention::return_if_false(unsigned int, std::uintmax_t value) const
 {
-	std::size_t chunk_size = _set_params_chunk.emit(location, code_sink);
-	const auto call_location = static_cast<char *>(location) + chunk_size;
-
-	FixedCodeChunk call_chunk;
-	call_chunk.append('\xe8' /* call rel32 */);
-	append_imm32(_location->distance_from(call_location) - 5, call_chunk);
-	chunk_size += call_chunk.emit(call_location, code_sink);
-	return chunk_size;
+	if (value > std::numeric_limits<std::uint64_t>::max())
+		throw std::overflow_error("Immediate value exceeds 64 bits");
+
+	auto code_chunk = std::make_unique<CodeAssembler>();
+	code_chunk->append(
+		"\x85\xc0" // test eax, eax
+		"\x75\x0f" // jnz +15, past the mov rax, imm64 and the epilog
+		"\x48\xb8" // mov rax, imm64
+	);
+	code_chunk->append_imm64(value);
+	code_chunk->cfi_remember_state();
+	code_chunk->append("\x48\x89\xec" /* mov rsp, rbp */);
+	code_chunk->append("\x5d" /* pop rbp */);
+	code_chunk->cfi_def_cfa(DWARF_RSP, 8);
+	code_chunk->cfi_restore(DWARF_RBP);
+	code_chunk->append("\xc3" /* ret */);
+	code_chunk->cfi_restore_state();
+	return code_chunk;
 }
 
 }
\ No newline at end of file
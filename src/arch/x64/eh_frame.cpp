@@ -0,0 +1,197 @@
+#include "eh_frame.hpp"
+
+#include <boost/endian/conversion.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace load::detail {
+
+namespace {
+
+constexpr std::int32_t DATA_ALIGNMENT = -8;
+
+enum DwarfCallFrameOp : std::uint8_t
+{
+	DW_CFA_nop                = 0x00,
+	DW_CFA_advance_loc1       = 0x02,
+	DW_CFA_advance_loc2       = 0x03,
+	DW_CFA_advance_loc4       = 0x04,
+	DW_CFA_remember_state     = 0x0a,
+	DW_CFA_restore_state      = 0x0b,
+	DW_CFA_def_cfa            = 0x0c,
+	DW_CFA_def_cfa_register   = 0x0d,
+	DW_CFA_def_cfa_offset     = 0x0e,
+	DW_CFA_offset_extended_sf = 0x11,
+	DW_CFA_advance_loc        = 0x40,
+	DW_CFA_offset             = 0x80,
+	DW_CFA_restore            = 0xc0,
+};
+
+class EhFrameWriter
+{
+public:
+	void append_u8(std::uint8_t value) { _data.push_back(char(value)); }
+
+	template <typename T>
+	void append_le(T value)
+	{
+		const T le_value = boost::endian::native_to_little(value);
+		const char * const bytes = reinterpret_cast<const char *>(&le_value);
+		_data.insert(_data.end(), bytes, bytes + sizeof(T));
+	}
+
+	void append_uleb128(std::uint64_t value)
+	{
+		do {
+			const std::uint8_t byte = value & 0x7f;
+			value >>= 7;
+			append_u8(value != 0 ? byte | 0x80 : byte);
+		} while (value != 0);
+	}
+
+	void append_sleb128(std::int64_t value)
+	{
+		for (bool more = true; more; ) {
+			const std::uint8_t byte = value & 0x7f;
+			value >>= 7;
+			more = !((value == 0 && !(byte & 0x40)) || (value == -1 && (byte & 0x40)));
+			append_u8(more ? byte | 0x80 : byte);
+		}
+	}
+
+	std::size_t begin_entry()
+	{
+		const std::size_t entry_offset = _data.size();
+		append_le(std::uint32_t(0));
+		return entry_offset;
+	}
+
+	void end_entry(std::size_t entry_offset)
+	{
+		while ((_data.size() - entry_offset) % 8 != 0)
+			append_u8(DW_CFA_nop);
+
+		const auto entry_size = boost::endian::native_to_little(std::uint32_t(_data.size() - entry_offset - 4));
+		std::copy_n(reinterpret_cast<const char *>(&entry_size), sizeof(entry_size), _data.begin() + entry_offset);
+	}
+
+	std::size_t size() const { return _data.size(); }
+	std::vector<char> release() { return std::move(_data); }
+
+private:
+	std::vector<char> _data;
+};
+
+void append_advance_loc(std::uint32_t delta, EhFrameWriter & writer)
+{
+	if (delta == 0) return;
+
+	if (delta < 0x40) {
+		writer.append_u8(DW_CFA_advance_loc | delta);
+	} else if (delta <= 0xff) {
+		writer.append_u8(DW_CFA_advance_loc1);
+		writer.append_u8(std::uint8_t(delta));
+	} else if (delta <= 0xffff) {
+		writer.append_u8(DW_CFA_advance_loc2);
+		writer.append_le(std::uint16_t(delta));
+	} else {
+		writer.append_u8(DW_CFA_advance_loc4);
+		writer.append_le(delta);
+	}
+}
+
+void append_call_frame_rule(const CallFrameRule & rule, EhFrameWriter & writer)
+{
+	switch (rule.kind) {
+		case CallFrameRule::DefCfa:
+			writer.append_u8(DW_CFA_def_cfa);
+			writer.append_uleb128(rule.reg);
+			writer.append_uleb128(std::uint32_t(rule.value));
+			break;
+
+		case CallFrameRule::DefCfaOffset:
+			writer.append_u8(DW_CFA_def_cfa_offset);
+			writer.append_uleb128(std::uint32_t(rule.value));
+			break;
+
+		case CallFrameRule::DefCfaRegister:
+			writer.append_u8(DW_CFA_def_cfa_register);
+			writer.append_uleb128(rule.reg);
+			break;
+
+		case CallFrameRule::Offset: {
+			if (rule.value % DATA_ALIGNMENT != 0)
+				throw std::invalid_argument("Unaligned saved register offset");
+
+			const std::int32_t factored_offset = rule.value / DATA_ALIGNMENT;
+			if (factored_offset >= 0) {
+				writer.append_u8(DW_CFA_offset | rule.reg);
+				writer.append_uleb128(std::uint32_t(factored_offset));
+			} else {
+				writer.append_u8(DW_CFA_offset_extended_sf);
+				writer.append_uleb128(rule.reg);
+				writer.append_sleb128(factored_offset);
+			}
+			break;
+		}
+
+		case CallFrameRule::Restore:
+			writer.append_u8(DW_CFA_restore | rule.reg);
+			break;
+
+		case CallFrameRule::RememberState:
+			writer.append_u8(DW_CFA_remember_state);
+			break;
+
+		case CallFrameRule::RestoreState:
+			writer.append_u8(DW_CFA_restore_state);
+			break;
+	}
+}
+
+}
+
+std::vector<char> make_x64_eh_frame(std::uintptr_t code_address, std::size_t code_size,
+                                    const CallFrameRules & rules)
+{
+	EhFrameWriter writer;
+
+	const std::size_t cie_offset = writer.begin_entry();
+	writer.append_le(std::uint32_t(0) /* CIE id */);
+	writer.append_u8(1 /* version */);
+	writer.append_u8('z');
+	writer.append_u8('R');
+	writer.append_u8('\0');
+	writer.append_uleb128(1 /* code alignment */);
+	writer.append_sleb128(DATA_ALIGNMENT);
+	writer.append_u8(DWARF_RETURN_ADDRESS);
+	writer.append_uleb128(1 /* augmentation size */);
+	writer.append_u8(0x00 /* DW_EH_PE_absptr */);
+	append_call_frame_rule({ 0, CallFrameRule::DefCfa, DWARF_RSP, 8 }, writer);
+	append_call_frame_rule({ 0, CallFrameRule::Offset, DWARF_RETURN_ADDRESS, -8 }, writer);
+	writer.end_entry(cie_offset);
+
+	const std::size_t fde_offset = writer.begin_entry();
+	writer.append_le(std::uint32_t(writer.size() - cie_offset));
+	writer.append_le(std::uint64_t(code_address));
+	writer.append_le(std::uint64_t(code_size));
+	writer.append_uleb128(0 /* augmentation size */);
+
+	std::uint32_t location = 0;
+	for (const CallFrameRule & rule : rules) {
+		if (rule.offset < location || rule.offset > code_size)
+			throw std::invalid_argument("Call frame rules are out of order");
+
+		append_advance_loc(rule.offset - location, writer);
+		append_call_frame_rule(rule, writer);
+		location = rule.offset;
+	}
+	writer.end_entry(fde_offset);
+
+	writer.append_le(std::uint32_t(0));
+	return writer.release();
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef LOAD_SRC_ARCH_X64_EHFRAME_HPP_
+#define LOAD_SRC_ARCH_X64_EHFRAME_HPP_
+
+#include "../../code_chunk.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace load::detail {
+
+enum X64DwarfRegister : unsigned int
+{
+	DWARF_RAX, DWARF_RDX, DWARF_RCX, DWARF_RBX, DWARF_RSI, DWARF_RDI, DWARF_RBP, DWARF_RSP,
+	DWARF_R8,  DWARF_R9,  DWARF_R10, DWARF_R11, DWARF_R12, DWARF_R13, DWARF_R14, DWARF_R15,
+	DWARF_RETURN_ADDRESS,
+};
+
+// A zero-terminated .eh_frame holding one CIE and one FDE covering the code
+std::vector<char> make_x64_eh_frame(std::uintptr_t code_address, std::size_t code_size,
+                                    const CallFrameRules & rules);
+
+}
+
+#endif
\ No newline at end of file
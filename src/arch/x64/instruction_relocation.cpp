@@ -0,0 +1,329 @@
+#include "instruction_relocation.hpp"
+#include "../../code_chunk.hpp"
+
+#include <boost/endian/conversion.hpp>
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace load::detail {
+
+namespace {
+
+constexpr std::size_t ABSOLUTE_JUMP_SIZE = 14;
+
+bool is_legacy_prefix(std::uint8_t byte)
+{
+	switch (byte) {
+		case 0x26: case 0x2e: case 0x36: case 0x3e: case 0x64: case 0x65:
+		case 0x66: case 0x67: case 0xf0: case 0xf2: case 0xf3:
+			return true;
+		default:
+			return false;
+	}
+}
+
+std::size_t modrm_operand_size(const std::uint8_t * modrm, bool & rip_relative)
+{
+	const unsigned int mod = modrm[0] >> 6;
+	const unsigned int rm = modrm[0] & 7;
+	rip_relative = false;
+	if (mod == 3) return 1;
+
+	std::size_t size = 1;
+	unsigned int base = rm;
+	if (rm == 4) {
+		base = modrm[1] & 7;
+		++size;
+	}
+
+	if (mod == 0 && rm == 5) {
+		rip_relative = true;
+		return size + 4;
+	}
+	if (mod == 0 && rm == 4 && base == 5) return size + 4;
+	if (mod == 1) return size + 1;
+	if (mod == 2) return size + 4;
+	return size;
+}
+
+bool one_byte_has_modrm(std::uint8_t opcode)
+{
+	if (opcode < 0x40) return (opcode & 7) < 4;
+
+	switch (opcode) {
+		case 0x63: case 0x69: case 0x6b:
+		case 0xc0: case 0xc1: case 0xc6: case 0xc7:
+		case 0xd0: case 0xd1: case 0xd2: case 0xd3:
+		case 0xf6: case 0xf7: case 0xfe: case 0xff:
+			return true;
+		default:
+			return (opcode >= 0x80 && opcode <= 0x8f) || (opcode >= 0xd8 && opcode <= 0xdf);
+	}
+}
+
+std::size_t one_byte_imm_size(std::uint8_t opcode, const std::uint8_t * modrm, bool opsize16, bool rex_w)
+{
+	const std::size_t imm_z = opsize16 ? 2 : 4;
+	if (opcode < 0x40) {
+		if ((opcode & 7) == 4) return 1;
+		if ((opcode & 7) == 5) return imm_z;
+		return 0;
+	}
+
+	switch (opcode) {
+		case 0x6a: case 0x6b: case 0x80: case 0x83: case 0xa8: case 0xc0: case 0xc1:
+		case 0xc6: case 0xcd: case 0xe4: case 0xe5: case 0xe6: case 0xe7:
+			return 1;
+		case 0x68: case 0x69: case 0x81: case 0xa9: case 0xc7:
+			return imm_z;
+		case 0xc2:
+			return 2;
+		case 0xc8:
+			return 3;
+		case 0xf6:
+			return ((modrm[0] >> 3) & 7) < 2 ? 1 : 0;
+		case 0xf7:
+			return ((modrm[0] >> 3) & 7) < 2 ? imm_z : 0;
+		default:
+			break;
+	}
+
+	if (opcode >= 0xb0 && opcode <= 0xb7) return 1;
+	if (opcode >= 0xb8 && opcode <= 0xbf) return rex_w ? 8 : imm_z;
+	return 0;
+}
+
+bool is_supported_one_byte(std::uint8_t opcode)
+{
+	if (opcode < 0x40) return (opcode & 7) < 6;
+	if (opcode >= 0x50 && opcode <= 0x5f) return true;
+	if (opcode >= 0x84 && opcode <= 0x9f) return opcode != 0x9a;
+	if (opcode >= 0xa8 && opcode <= 0xbf) return true;
+
+	switch (opcode) {
+		case 0x63: case 0x68: case 0x69: case 0x6a: case 0x6b:
+		case 0x80: case 0x81: case 0x83:
+		case 0xc0: case 0xc1: case 0xc2: case 0xc3: case 0xc6: case 0xc7: case 0xc8: case 0xc9:
+		case 0xcc: case 0xcd:
+		case 0xd0: case 0xd1: case 0xd2: case 0xd3:
+		case 0xe8: case 0xe9: case 0xeb:
+		case 0xf4: case 0xf5: case 0xf6: case 0xf7: case 0xf8: case 0xf9: case 0xfa: case 0xfb:
+		case 0xfc: case 0xfd: case 0xfe: case 0xff:
+			return true;
+		default:
+			return (opcode >= 0x70 && opcode <= 0x7f) || (opcode >= 0xd8 && opcode <= 0xdf);
+	}
+}
+
+bool two_byte_has_modrm(std::uint8_t opcode)
+{
+	switch (opcode) {
+		case 0x05: case 0x06: case 0x07: case 0x08: case 0x09: case 0x0b: case 0x0e:
+		case 0x30: case 0x31: case 0x32: case 0x33: case 0x34: case 0x35: case 0x37: case 0x77:
+		case 0xa0: case 0xa1: case 0xa2: case 0xa8: case 0xa9: case 0xaa:
+			return false;
+		default:
+			return !(opcode >= 0x80 && opcode <= 0x8f) && !(opcode >= 0xc8 && opcode <= 0xcf);
+	}
+}
+
+std::size_t two_byte_imm_size(std::uint8_t opcode)
+{
+	switch (opcode) {
+		case 0x70: case 0x71: case 0x72: case 0x73: case 0xa4: case 0xac:
+		case 0xba: case 0xc2: case 0xc4: case 0xc5: case 0xc6:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+void append_jump_back(std::uintptr_t target, CodeAssembler & code_chunk)
+{
+	code_chunk.append(std::string_view("\xff\x25\x00\x00\x00\x00", 6) /* jmp [rip] */);
+	code_chunk.append_imm64(target);
+}
+
+}
+
+X64Instruction decode_x64_instruction(const char * code)
+{
+	const auto bytes = reinterpret_cast<const std::uint8_t *>(code);
+
+	std::size_t offset = 0;
+	bool opsize16 = false;
+	while (is_legacy_prefix(bytes[offset])) {
+		opsize16 |= bytes[offset] == 0x66;
+		if (++offset > 4)
+			throw std::runtime_error("Too many instruction prefixes");
+	}
+
+	bool rex_w = false;
+	if ((bytes[offset] & 0xf0) == 0x40) {
+		rex_w = (bytes[offset] & 0x08) != 0;
+		++offset;
+	}
+
+	X64Instruction instruction { 0, X64Instruction::Other, 0, 0, 0, 0 };
+	const std::uint8_t opcode = bytes[offset++];
+	if (opcode == 0x0f) {
+		std::uint8_t opcode2 = bytes[offset++];
+		std::size_t imm_size = 0;
+		if (opcode2 == 0x38 || opcode2 == 0x3a) {
+			imm_size = opcode2 == 0x3a ? 1 : 0;
+			opcode2 = bytes[offset++];
+		} else if (opcode2 >= 0x80 && opcode2 <= 0x8f) {
+			instruction.kind = X64Instruction::ConditionalJump;
+			instruction.condition = opcode2 & 0x0f;
+			instruction.rel_offset = offset;
+			instruction.rel_size = 4;
+			instruction.length = offset + 4;
+			return instruction;
+		} else {
+			imm_size = two_byte_imm_size(opcode2);
+			if (!two_byte_has_modrm(opcode2)) {
+				instruction.length = offset;
+				return instruction;
+			}
+		}
+
+		bool rip_relative;
+		const std::size_t modrm_offset = offset;
+		offset += modrm_operand_size(bytes + offset, rip_relative);
+		if (rip_relative) {
+			instruction.rel_offset = modrm_offset + 1;
+			instruction.rel_size = 4;
+		}
+		instruction.imm_size = imm_size;
+		instruction.length = offset + imm_size;
+		return instruction;
+	}
+
+	if (!is_supported_one_byte(opcode))
+		throw std::runtime_error("Unsupported instruction in function entry");
+
+	if (opcode >= 0x70 && opcode <= 0x7f) {
+		instruction.kind = X64Instruction::ConditionalJump;
+		instruction.condition = opcode & 0x0f;
+		instruction.rel_offset = offset;
+		instruction.rel_size = 1;
+		instruction.length = offset + 1;
+		return instruction;
+	}
+
+	switch (opcode) {
+		case 0xc2: case 0xc3:
+			instruction.kind = X64Instruction::Return;
+			break;
+		case 0xe8: case 0xe9: case 0xeb:
+			instruction.kind = opcode == 0xe8 ? X64Instruction::Call : X64Instruction::Jump;
+			instruction.rel_offset = offset;
+			instruction.rel_size = opcode == 0xeb ? 1 : 4;
+			instruction.length = offset + instruction.rel_size;
+			return instruction;
+		default:
+			break;
+	}
+
+	const std::uint8_t * const modrm = bytes + offset;
+	if (one_byte_has_modrm(opcode)) {
+		bool rip_relative;
+		offset += modrm_operand_size(modrm, rip_relative);
+		if (rip_relative) {
+			instruction.rel_offset = (modrm - bytes) + 1;
+			instruction.rel_size = 4;
+		}
+		if (opcode == 0xff && ((modrm[0] >> 3) & 7) >= 4 && ((modrm[0] >> 3) & 7) <= 5)
+			instruction.kind = X64Instruction::IndirectJump;
+	}
+
+	instruction.imm_size = one_byte_imm_size(opcode, modrm, opsize16, rex_w);
+	instruction.length = offset + instruction.imm_size;
+	return instruction;
+}
+
+RelocatedEntry relocate_x64_entry(const char * entry, std::size_t min_size)
+{
+	const auto entry_address = reinterpret_cast<std::uintptr_t>(entry);
+
+	auto code_chunk = std::make_unique<CodeAssembler>();
+	std::size_t offset = 0;
+	while (offset < min_size) {
+		const char * const code = entry + offset;
+		const X64Instruction instruction = decode_x64_instruction(code);
+		const std::uintptr_t next_address = entry_address + offset + instruction.length;
+		offset += instruction.length;
+
+		std::intptr_t displacement = 0;
+		if (instruction.rel_size == 1) {
+			displacement = static_cast<std::int8_t>(code[instruction.rel_offset]);
+		} else if (instruction.rel_size == 4) {
+			std::int32_t rel32;
+			std::memcpy(&rel32, code + instruction.rel_offset, sizeof(rel32));
+			displacement = boost::endian::little_to_native(rel32);
+		}
+		const std::uintptr_t rel_target = next_address + displacement;
+
+		switch (instruction.kind) {
+			case X64Instruction::Call:
+				code_chunk->append_call(rel_target);
+				continue;
+
+			case X64Instruction::Jump:
+				append_jump_back(rel_target, *code_chunk);
+				return { std::move(code_chunk), offset };
+
+			case X64Instruction::ConditionalJump:
+				code_chunk->append(char(0x70 | (instruction.condition ^ 1)) /* jncc +14 */);
+				code_chunk->append(char(ABSOLUTE_JUMP_SIZE));
+				append_jump_back(rel_target, *code_chunk);
+				continue;
+
+			case X64Instruction::Return:
+			case X64Instruction::IndirectJump:
+				if (offset < min_size)
+					throw std::runtime_error("Function is too short to be patched");
+				code_chunk->append(std::string_view(code, instruction.length));
+				return { std::move(code_chunk), offset };
+
+			default:
+				break;
+		}
+
+		if (instruction.rel_size == 4) {
+			code_chunk->append(std::string_view(code, instruction.rel_offset));
+			code_chunk->append_rel32(rel_target - instruction.imm_size);
+			const std::size_t rel_end = instruction.rel_offset + instruction.rel_size;
+			code_chunk->append(std::string_view(code + rel_end, instruction.length - rel_end));
+		} else {
+			code_chunk->append(std::string_view(code, instruction.length));
+		}
+	}
+
+	append_jump_back(entry_address + offset, *code_chunk);
+	return { std::move(code_chunk), offset };
+}
+
+std::unique_ptr<CodeChunk> make_x64_absolute_jump(std::uintptr_t target)
+{
+	auto code_chunk = std::make_unique<CodeAssembler>();
+	append_jump_back(target, *code_chunk);
+	return code_chunk;
+}
+
+bool encode_x64_near_jump(std::uintptr_t from, std::uintptr_t to, char * into)
+{
+	const std::intptr_t displacement = to - (from + X64_NEAR_JUMP_SIZE);
+	if (displacement < std::numeric_limits<std::int32_t>::min()
+	 || displacement > std::numeric_limits<std::int32_t>::max())
+		return false;
+
+	const auto rel32 = boost::endian::native_to_little(std::int32_t(displacement));
+	into[0] = '\xe9';
+	std::memcpy(into + 1, &rel32, sizeof(rel32));
+	return true;
+}
+
+}
\ No newline at end of file
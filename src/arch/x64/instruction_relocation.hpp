@@ -0,0 +1,42 @@
+#ifndef LOAD_SRC_ARCH_X64_INSTRUCTIONRELOCATION_HPP_
+#define LOAD_SRC_ARCH_X64_INSTRUCTIONRELOCATION_HPP_
+
+#include <load/codegen/code_chunk.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace load::detail {
+
+constexpr std::size_t X64_NEAR_JUMP_SIZE = 5;
+
+struct X64Instruction
+{
+	enum Kind : std::uint8_t { Other, Return, Jump, ConditionalJump, Call, IndirectJump };
+
+	std::size_t  length;
+	Kind         kind;
+	std::uint8_t condition;
+	std::size_t  rel_offset;
+	std::size_t  rel_size;
+	std::size_t  imm_size;
+};
+
+X64Instruction decode_x64_instruction(const char * code);
+
+struct RelocatedEntry
+{
+	std::unique_ptr<CodeChunk> code_chunk;
+	std::size_t                entry_size;
+};
+
+// Moves whole instructions covering at least min_size bytes of the entry and jumps back after them
+RelocatedEntry relocate_x64_entry(const char * entry, std::size_t min_size);
+
+std::unique_ptr<CodeChunk> make_x64_absolute_jump(std::uintptr_t target);
+bool encode_x64_near_jump(std::uintptr_t from, std::uintptr_t to, char * into);
+
+}
+
+#endif
\ No newline at end of file
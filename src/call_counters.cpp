@@ -0,0 +1,88 @@
+#include <config.hpp>
+#include "abi_bridge.hpp"
+#include "call_counters.hpp"
+#include "platform/code_address.hpp"
+
+#if defined(LIBLOAD_ARCH_X86_64) && defined(LIBLOAD_ENABLE_ARCH_X86_64)
+	#include "arch/x64/abi_thunks.hpp"
+	#define LIBLOAD_HAS_CALL_COUNTERS 1
+#endif
+
+#include <stdexcept>
+
+namespace load::detail {
+
+ImportCallCounters::ImportCallCounters(CallInstrumentation instrumentation)
+	: _instrumentation { instrumentation }
+	, _code_arena { 0x1000 }
+{
+	if (!is_call_instrumentation_supported(instrumentation))
+		throw std::logic_error("Unsupported call instrumentation");
+}
+
+const void * ImportCallCounters::counting_thunk(std::string_view module_name,
+                                                std::string_view proc_name,
+                                                const void     * target)
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+
+	Entry & entry = _entries.emplace_back();
+	entry.module_name = module_name;
+	entry.proc_name = proc_name;
+
+	std::unique_ptr<CodeChunk> code_chunk;
+#ifdef LIBLOAD_HAS_CALL_COUNTERS
+	const auto target_addr = reinterpret_cast<std::uintptr_t>(target);
+	const auto counter_addr = reinterpret_cast<std::uintptr_t>(&entry.counter);
+	code_chunk = _instrumentation == CallInstrumentation::CountAndTimeCalls
+		? make_x64_win64_timing_thunk(target_addr, counter_addr, AbiBridge::GENERIC_ARGC)
+		: make_x64_counting_thunk(target_addr, counter_addr);
+#endif
+
+	const std::string perf_name = "libload_count_" + entry.proc_name;
+	return _code_arena.emit(*code_chunk, perf_name).address;
+}
+
+const void * ImportCallCounters::import_thunk(std::string_view module_name, std::string_view proc_name,
+                                              const void * host_proc, AbiBridge * abi_bridge)
+{
+	if (!is_code_address(host_proc)) return host_proc;
+	const void * const target = abi_bridge ? abi_bridge->import_proc_thunk(host_proc) : host_proc;
+	return counting_thunk(module_name, proc_name, target);
+}
+
+ModuleCallStats ImportCallCounters::stats() const
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+
+	ModuleCallStats call_stats;
+	call_stats.imports.reserve(_entries.size());
+	for (const Entry & entry : _entries) {
+		ImportCallStats & import_stats = call_stats.imports.emplace_back();
+		import_stats.module_name = entry.module_name;
+		import_stats.proc_name = entry.proc_name;
+		import_stats.call_count = entry.counter.calls.load(std::memory_order_relaxed);
+		import_stats.cycle_count = entry.counter.cycles.load(std::memory_order_relaxed);
+		call_stats.call_count += import_stats.call_count;
+		call_stats.cycle_count += import_stats.cycle_count;
+	}
+
+	return call_stats;
+}
+
+bool is_call_instrumentation_supported(CallInstrumentation instrumentation)
+{
+#ifdef LIBLOAD_HAS_CALL_COUNTERS
+	return instrumentation != CallInstrumentation::None;
+#else
+	return false;
+#endif
+}
+
+std::unique_ptr<ImportCallCounters> make_import_call_counters(CallInstrumentation instrumentation)
+{
+	if (instrumentation == CallInstrumentation::None) return nullptr;
+	return std::make_unique<ImportCallCounters>(instrumentation);
+}
+
+}
\ No newline at end of file
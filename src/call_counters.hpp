@@ -0,0 +1,63 @@
+#ifndef LOAD_SRC_CALLCOUNTERS_HPP_
+#define LOAD_SRC_CALLCOUNTERS_HPP_
+
+#include "code_arena.hpp"
+
+#include <load/module/call_stats.hpp>
+#include <load/module/load_options.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace load::detail {
+
+class AbiBridge;
+
+class ImportCallCounters
+{
+public:
+	explicit ImportCallCounters(CallInstrumentation instrumentation);
+	ImportCallCounters(const ImportCallCounters &) = delete;
+	ImportCallCounters & operator=(const ImportCallCounters &) = delete;
+
+	// Expects a procedure using the Windows calling convention when calls are timed
+	const void * counting_thunk(std::string_view module_name, std::string_view proc_name, const void * target);
+
+	// Binds data imports as they are; procedures are counted, after ABI bridging when a bridge is given
+	const void * import_thunk(std::string_view module_name, std::string_view proc_name,
+	                          const void * host_proc, AbiBridge * abi_bridge);
+
+	ModuleCallStats stats() const;
+
+private:
+	// Every counter gets its own cache line, so threads calling different imports don't contend
+	struct alignas(64) Counter
+	{
+		std::atomic<std::uint64_t> calls  { 0 };
+		std::atomic<std::uint64_t> cycles { 0 };
+	};
+
+	struct Entry
+	{
+		std::string module_name;
+		std::string proc_name;
+		Counter     counter;
+	};
+
+	CallInstrumentation _instrumentation;
+	mutable std::mutex  _mutex;
+	std::deque<Entry>   _entries;
+	CodeArena           _code_arena;
+};
+
+bool is_call_instrumentation_supported(CallInstrumentation instrumentation);
+std::unique_ptr<ImportCallCounters> make_import_call_counters(CallInstrumentation instrumentation);
+
+}
+
+#endif
\ No newline at end of file
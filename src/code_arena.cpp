@@ -0,0 +1,168 @@
+#include <config.hpp>
+#include "code_arena.hpp"
+#include "perf_map.hpp"
+#include "platform/unwind_frames.hpp"
+
+#if defined(LIBLOAD_ARCH_X86_64) && defined(LIBLOAD_ENABLE_ARCH_X86_64)
+#	include "arch/x64/eh_frame.hpp"
+#	define LIBLOAD_HAS_EH_FRAMES 1
+#endif
+
+#include <load/memory/memory_manager.hpp>
+#include <load/process/process.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace load::detail {
+
+namespace {
+
+constexpr std::size_t STUB_ALIGNMENT = 16;
+
+std::size_t align_stub_size(std::size_t size)
+{
+	return (std::max<std::size_t>(size, 1) + STUB_ALIGNMENT - 1) & ~(STUB_ALIGNMENT - 1);
+}
+
+class WritableViewCodeSink final : public CodeSink
+{
+public:
+	WritableViewCodeSink(char * view, std::size_t capacity)
+		: _view { view }, _capacity { capacity } {}
+
+	virtual void append(const char * data, std::size_t size) override
+	{
+		if (size > _capacity)
+			throw std::length_error("Generated code exceeds its reserved size");
+		std::memcpy(_view, data, size);
+		_view += size;
+		_capacity -= size;
+	}
+
+private:
+	char        * _view;
+	std::size_t   _capacity;
+};
+
+}
+
+CodeArena::CodeArena(std::size_t slab_size)
+	: _slab_size { slab_size }
+	, _slab_used { slab_size }
+{}
+
+CodeArena::~CodeArena()
+{
+	if (PerfMap * const map = perf_map())
+		map->remove(this);
+	for (const auto & [executable, eh_frame] : _unwind_frames)
+		deregister_unwind_frames(eh_frame.data());
+	for (const DualMapping & slab : _slabs)
+		release_dual_mapping(slab);
+}
+
+CodeStub CodeArena::emit(const CodeChunk & code_chunk, std::string perf_name)
+{
+	const std::size_t stub_size = align_stub_size(code_chunk.max_size());
+	const StubSlot stub_slot = allocate_slot(stub_size);
+	const CodeStub code_stub { stub_slot.executable, stub_size };
+
+	try {
+		WritableViewCodeSink code_sink { stub_slot.writable, stub_size };
+		const std::size_t code_size = code_chunk.emit(stub_slot.executable, code_sink);
+		current_process().memory_manager().flush_instruction_cache(stub_slot.executable, code_size);
+		register_unwind_info(code_chunk, stub_slot.executable, code_size);
+	} catch (...) {
+		free(code_stub);
+		throw;
+	}
+
+	if (PerfMap * const map = perf_map()) {
+		const auto stub_addr = reinterpret_cast<std::uintptr_t>(code_stub.address);
+		map->add(this, { { stub_addr, code_stub.size, std::move(perf_name) } });
+	}
+	return code_stub;
+}
+
+void CodeArena::free(const CodeStub & code_stub)
+{
+	if (PerfMap * const map = perf_map())
+		map->remove(this, reinterpret_cast<std::uintptr_t>(code_stub.address));
+	deregister_unwind_info(code_stub.address);
+
+	const std::lock_guard<std::mutex> lock { _mutex };
+	_free_slots[code_stub.size].push_back(static_cast<char *>(code_stub.address));
+}
+
+std::size_t CodeArena::slab_count() const
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+	return _slabs.size();
+}
+
+CodeArena::StubSlot CodeArena::allocate_slot(std::size_t size)
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+
+	const auto free_it = _free_slots.find(size);
+	if (free_it != _free_slots.end() && !free_it->second.empty()) {
+		char * const executable = free_it->second.back();
+		free_it->second.pop_back();
+		return find_slot(executable);
+	}
+
+	if (size > _slab_size - _slab_used) {
+		_slabs.reserve(_slabs.size() + 1);
+		_slabs.push_back(create_dual_mapping(std::max(size, _slab_size)));
+		_slab_used = 0;
+	}
+
+	const DualMapping & slab = _slabs.back();
+	const StubSlot stub_slot { slab.writable + _slab_used, slab.executable + _slab_used };
+	_slab_used = size > _slab_size ? _slab_size : _slab_used + size;
+	return stub_slot;
+}
+
+CodeArena::StubSlot CodeArena::find_slot(void * executable) const
+{
+	const auto stub_ptr = static_cast<char *>(executable);
+	for (const DualMapping & slab : _slabs) {
+		if (stub_ptr >= slab.executable && stub_ptr < slab.executable + slab.size) {
+			const std::size_t offset = stub_ptr - slab.executable;
+			return { slab.writable + offset, stub_ptr };
+		}
+	}
+
+	throw std::invalid_argument("Code stub does not belong to this arena");
+}
+
+void CodeArena::register_unwind_info(const CodeChunk & code_chunk, void * executable, std::size_t code_size)
+{
+#ifdef LIBLOAD_HAS_EH_FRAMES
+	const CallFrameRules rules = collect_call_frame_rules(code_chunk, executable);
+	if (rules.empty()) return;
+
+	const auto code_address = reinterpret_cast<std::uintptr_t>(executable);
+	std::vector<char> eh_frame = make_x64_eh_frame(code_address, code_size, rules);
+
+	const std::lock_guard<std::mutex> lock { _mutex };
+	if (register_unwind_frames(eh_frame.data()))
+		_unwind_frames.emplace(executable, std::move(eh_frame));
+#endif
+}
+
+void CodeArena::deregister_unwind_info(void * executable)
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+
+	const auto frame_it = _unwind_frames.find(executable);
+	if (frame_it == _unwind_frames.end()) return;
+
+	deregister_unwind_frames(frame_it->second.data());
+	_unwind_frames.erase(frame_it);
+}
+
+}
\ No newline at end of file
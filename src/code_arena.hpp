@@ -0,0 +1,59 @@
+#ifndef LOAD_SRC_CODEARENA_HPP_
+#define LOAD_SRC_CODEARENA_HPP_
+
+#include "platform/dual_mapping.hpp"
+
+#include <load/codegen/code_chunk.hpp>
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace load::detail {
+
+struct CodeStub
+{
+	void        * address;
+	std::size_t   size;
+};
+
+class CodeArena
+{
+public:
+	explicit CodeArena(std::size_t slab_size = 0x10000);
+	CodeArena(const CodeArena &) = delete;
+	CodeArena & operator=(const CodeArena &) = delete;
+	~CodeArena();
+
+	CodeStub emit(const CodeChunk & code_chunk, std::string perf_name = "libload_stub");
+	void free(const CodeStub & code_stub);
+
+	std::size_t slab_count() const;
+
+private:
+	struct StubSlot
+	{
+		char * writable;
+		char * executable;
+	};
+
+	StubSlot allocate_slot(std::size_t size);
+	StubSlot find_slot(void * executable) const;
+
+	void register_unwind_info(const CodeChunk & code_chunk, void * executable, std::size_t code_size);
+	void deregister_unwind_info(void * executable);
+
+	mutable std::mutex                            _mutex;
+	std::size_t                                   _slab_size;
+	std::size_t                                   _slab_used;
+	std::vector<DualMapping>                      _slabs;
+	std::map<std::size_t, std::vector<char *>>    _free_slots;
+	std::unordered_map<void *, std::vector<char>> _unwind_frames;
+};
+
+}
+
+#endif
\ No newline at end of file
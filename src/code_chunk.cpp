@@ -1,10 +1,99 @@
 #include "code_chunk.hpp"
 
+#include <boost/endian/conversion.hpp>
+
+#include <cstring>
+#include <limits>
 #include <numeric>
+#include <stdexcept>
 #include <utility>
 
 namespace load::detail {
 
+namespace {
+
+constexpr std::size_t NEAR_CALL_SIZE = 5;
+constexpr std::size_t FAR_CALL_SIZE  = 16;
+
+bool fits_rel32(std::intptr_t displacement)
+{
+	return displacement >= std::numeric_limits<std::int32_t>::min()
+	    && displacement <= std::numeric_limits<std::int32_t>::max();
+}
+
+void append_le_rel32(std::intptr_t displacement, CodeSink & code_sink)
+{
+	const auto rel32 = boost::endian::native_to_little(std::int32_t(displacement));
+	code_sink.append(reinterpret_cast<const char *>(&rel32), sizeof(rel32));
+}
+
+class NullCodeSink final : public CodeSink
+{
+public:
+	virtual void append(const char *, std::size_t) override {}
+};
+
+bool fits_rel8(std::intptr_t displacement)
+{
+	return displacement >= std::numeric_limits<std::int8_t>::min()
+	    && displacement <= std::numeric_limits<std::int8_t>::max();
+}
+
+std::size_t branch_size(BranchCondition condition, bool near_branch)
+{
+	if (!near_branch) return 2;
+	return condition == BranchCondition::Always ? 5 : 6;
+}
+
+void emit_branch(BranchCondition condition, bool near_branch,
+                 std::intptr_t displacement, CodeSink & code_sink)
+{
+	const char condition_code = static_cast<char>(condition);
+	if (!near_branch) {
+		const char short_branch[] = {
+			condition == BranchCondition::Always ? '\xeb' /* jmp rel8 */ : char(0x70 | condition_code) /* jcc rel8 */,
+			static_cast<char>(displacement)
+		};
+		code_sink.append(short_branch, sizeof(short_branch));
+	} else if (condition == BranchCondition::Always) {
+		code_sink.append("\xe9" /* jmp rel32 */, 1);
+		append_le_rel32(displacement, code_sink);
+	} else {
+		const char near_jcc[] = { '\x0f', char(0x80 | condition_code) /* jcc rel32 */ };
+		code_sink.append(near_jcc, sizeof(near_jcc));
+		append_le_rel32(displacement, code_sink);
+	}
+}
+
+std::size_t emit_call(std::uintptr_t target, std::uintptr_t call_address, CodeSink & code_sink)
+{
+	const std::intptr_t displacement = target - (call_address + NEAR_CALL_SIZE);
+	if (fits_rel32(displacement)) {
+		code_sink.append("\xe8" /* call rel32 */, 1);
+		append_le_rel32(displacement, code_sink);
+		return NEAR_CALL_SIZE;
+	}
+
+	code_sink.append(
+		"\xff\x15\x02\x00\x00\x00" // call [rip + 2]
+		"\xeb\x08",                // jmp +8
+		8);
+	const auto literal = boost::endian::native_to_little(std::uint64_t(target));
+	code_sink.append(reinterpret_cast<const char *>(&literal), sizeof(literal));
+	return FAR_CALL_SIZE;
+}
+
+void collect_chunk_frame_rules(const CodeChunk & code_chunk, void * location, std::size_t offset,
+                               CallFrameRules & rules)
+{
+	if (const auto code_assembler = dynamic_cast<const CodeAssembler *>(&code_chunk))
+		code_assembler->collect_call_frame_rules(location, offset, rules);
+	else if (const auto code_block = dynamic_cast<const CodeBlock *>(&code_chunk))
+		code_block->collect_call_frame_rules(location, offset, rules);
+}
+
+}
+
 AbsoluteCodeLocation::AbsoluteCodeLocation(void * address)
 	: _address { static_cast<char *>(address) } {}
 
@@ -37,49 +126,264 @@ std::size_t CodeChunkLiteral::emit(void * location, CodeSink & code_sink) const
 	return _data.size();
 }
 
-void FixedCodeChunk::append(char byte)
+void CodeAssembler::append(char byte)
 {
 	_data.push_back(byte);
 }
 
-void FixedCodeChunk::append(std::string_view data)
+void CodeAssembler::append(std::string_view data)
 {
-	std::copy(data.begin(), data.end(), std::back_inserter(_data));
+	_data.insert(_data.end(), data.begin(), data.end());
 }
 
-std::size_t FixedCodeChunk::max_size() const
+void CodeAssembler::append_imm32(std::uintmax_t value)
 {
-	return _data.size();
+	if (value > std::numeric_limits<std::uint32_t>::max())
+		throw std::overflow_error("Immediate value exceeds 32 bits");
+
+	const auto imm = boost::endian::native_to_little(std::uint32_t(value));
+	append(std::string_view(reinterpret_cast<const char *>(&imm), sizeof(imm)));
 }
 
-std::size_t FixedCodeChunk::emit(void * location, CodeSink & code_sink) const
+void CodeAssembler::append_imm64(std::uintmax_t value)
 {
-	code_sink.append(_data.data(), _data.size());
-	return _data.size();
+	const auto imm = boost::endian::native_to_little(std::uint64_t(value));
+	append(std::string_view(reinterpret_cast<const char *>(&imm), sizeof(imm)));
+}
+
+void CodeAssembler::append_rel32(std::uintptr_t target)
+{
+	_fixups.push_back({ std::uint32_t(_data.size()), CodeFixup::Rel32, target });
+	_data.insert(_data.end(), sizeof(std::int32_t), '\0');
+}
+
+void CodeAssembler::append_call(std::uintptr_t target)
+{
+	_fixups.push_back({ std::uint32_t(_data.size()), CodeFixup::Call, target });
+	++_call_count;
+}
+
+void CodeAssembler::cfi_def_cfa(unsigned int reg, std::int32_t offset)
+{
+	add_call_frame_rule(CallFrameRule::DefCfa, reg, offset);
+}
+
+void CodeAssembler::cfi_def_cfa_offset(std::int32_t offset)
+{
+	add_call_frame_rule(CallFrameRule::DefCfaOffset, 0, offset);
+}
+
+void CodeAssembler::cfi_def_cfa_register(unsigned int reg)
+{
+	add_call_frame_rule(CallFrameRule::DefCfaRegister, reg, 0);
+}
+
+void CodeAssembler::cfi_offset(unsigned int reg, std::int32_t offset)
+{
+	add_call_frame_rule(CallFrameRule::Offset, reg, offset);
+}
+
+void CodeAssembler::cfi_restore(unsigned int reg)
+{
+	add_call_frame_rule(CallFrameRule::Restore, reg, 0);
+}
+
+void CodeAssembler::cfi_remember_state()
+{
+	add_call_frame_rule(CallFrameRule::RememberState, 0, 0);
+}
+
+void CodeAssembler::cfi_restore_state()
+{
+	add_call_frame_rule(CallFrameRule::RestoreState, 0, 0);
+}
+
+void CodeAssembler::add_call_frame_rule(CallFrameRule::Kind kind, unsigned int reg, std::int32_t value)
+{
+	const CallFrameRule rule { std::uint32_t(_data.size()), kind, std::uint8_t(reg), value };
+	_frame_rules.push_back({ std::uint32_t(_fixups.size()), rule });
+}
+
+std::size_t CodeAssembler::max_size() const
+{
+	return _data.size() + _call_count * FAR_CALL_SIZE;
+}
+
+std::size_t CodeAssembler::emit(void * location, CodeSink & code_sink) const
+{
+	const auto base_address = reinterpret_cast<std::uintptr_t>(location);
+
+	std::size_t data_offset = 0;
+	std::size_t bytes_emitted = 0;
+	for (const CodeFixup & fixup : _fixups) {
+		code_sink.append(_data.data() + data_offset, fixup.offset - data_offset);
+		bytes_emitted += fixup.offset - data_offset;
+		data_offset = fixup.offset;
+
+		if (fixup.kind == CodeFixup::Rel32) {
+			data_offset += sizeof(std::int32_t);
+			bytes_emitted += sizeof(std::int32_t);
+			const std::intptr_t displacement = fixup.target - (base_address + bytes_emitted);
+			if (!fits_rel32(displacement))
+				throw std::overflow_error("Relative displacement exceeds 32 bits");
+			append_le_rel32(displacement, code_sink);
+		} else {
+			bytes_emitted += emit_call(fixup.target, base_address + bytes_emitted, code_sink);
+		}
+	}
+
+	code_sink.append(_data.data() + data_offset, _data.size() - data_offset);
+	return bytes_emitted + _data.size() - data_offset;
 }
 
+void CodeAssembler::collect_call_frame_rules(void * location, std::size_t offset, CallFrameRules & rules) const
+{
+	const auto base_address = reinterpret_cast<std::uintptr_t>(location);
+
+	std::size_t fixup_index = 0;
+	std::size_t call_bytes = 0;
+	for (const PendingFrameRule & pending_rule : _frame_rules) {
+		for (; fixup_index < pending_rule.fixup_count; ++fixup_index) {
+			const CodeFixup & fixup = _fixups[fixup_index];
+			if (fixup.kind != CodeFixup::Call) continue;
+
+			const std::uintptr_t call_address = base_address + fixup.offset + call_bytes;
+			const bool near_call = fits_rel32(std::intptr_t(fixup.target - (call_address + NEAR_CALL_SIZE)));
+			call_bytes += near_call ? NEAR_CALL_SIZE : FAR_CALL_SIZE;
+		}
+
+		CallFrameRule rule = pending_rule.rule;
+		rule.offset = std::uint32_t(offset + rule.offset + call_bytes);
+		rules.push_back(rule);
+	}
+}
+
+struct CodeBlock::CodeLayout
+{
+	boost::container::small_vector<std::size_t, 8> item_offsets;
+	boost::container::small_vector<std::size_t, 4> label_offsets;
+	boost::container::small_vector<bool, 8>        near_branches;
+	std::size_t                                    code_size;
+};
+
 void CodeBlock::add(std::unique_ptr<CodeChunk> code_chunk)
 {
-	_code_chunks.emplace_back(std::move(code_chunk));
+	_items.push_back({ CodeBlockItem::Chunk, BranchCondition::Always, {}, std::move(code_chunk) });
+}
+
+CodeLabel CodeBlock::make_label()
+{
+	return { _label_count++ };
+}
+
+void CodeBlock::bind(CodeLabel label)
+{
+	_items.push_back({ CodeBlockItem::Label, BranchCondition::Always, label, nullptr });
+}
+
+void CodeBlock::add_branch(CodeLabel target, BranchCondition condition)
+{
+	_items.push_back({ CodeBlockItem::Branch, condition, target, nullptr });
+	++_branch_count;
 }
 
 std::size_t CodeBlock::max_size() const
 {
-	return std::accumulate(_code_chunks.begin(), _code_chunks.end(), std::size_t(0),
-		[] (std::size_t block_size, auto & code_chunk)
+	return std::accumulate(_items.begin(), _items.end(), std::size_t(0),
+		[] (std::size_t block_size, const CodeBlockItem & item)
 	{
-		return block_size + code_chunk->max_size();
+		switch (item.kind) {
+			case CodeBlockItem::Chunk:  return block_size + item.code_chunk->max_size();
+			case CodeBlockItem::Branch: return block_size + branch_size(item.condition, true);
+			default:                    return block_size;
+		}
 	});
 }
 
+void CodeBlock::layout_code(void * location, CodeLayout & layout) const
+{
+	layout.item_offsets.resize(_items.size());
+	layout.label_offsets.assign(_label_count, std::size_t(-1));
+	layout.near_branches.assign(_items.size(), false);
+
+	for (bool relaxed = false; !relaxed; ) {
+		std::size_t offset = 0;
+		for (std::size_t i = 0; i < _items.size(); ++i) {
+			const CodeBlockItem & item = _items[i];
+			layout.item_offsets[i] = offset;
+			if (item.kind == CodeBlockItem::Chunk) {
+				NullCodeSink null_sink;
+				offset += item.code_chunk->emit(static_cast<char *>(location) + offset, null_sink);
+			} else if (item.kind == CodeBlockItem::Branch) {
+				offset += branch_size(item.condition, layout.near_branches[i]);
+			} else {
+				layout.label_offsets[item.label.id] = offset;
+			}
+		}
+		layout.code_size = offset;
+
+		relaxed = true;
+		for (std::size_t i = 0; i < _items.size(); ++i) {
+			const CodeBlockItem & item = _items[i];
+			if (item.kind != CodeBlockItem::Branch || layout.near_branches[i]) continue;
+
+			const std::size_t target_offset = layout.label_offsets.at(item.label.id);
+			if (target_offset == std::size_t(-1))
+				throw std::logic_error("Branch to unbound label");
+
+			const std::size_t branch_end = layout.item_offsets[i] + branch_size(item.condition, false);
+			if (!fits_rel8(std::intptr_t(target_offset - branch_end))) {
+				layout.near_branches[i] = true;
+				relaxed = false;
+			}
+		}
+	}
+}
+
 std::size_t CodeBlock::emit(void * location, CodeSink & code_sink) const
 {
-	return std::accumulate(_code_chunks.begin(), _code_chunks.end(), std::size_t(0),
-		[&] (std::size_t bytes_emitted, auto & code_chunk)
-	{
-		const auto bytes_ptr = static_cast<char *>(location) + bytes_emitted;
-		return bytes_emitted + code_chunk->emit(bytes_ptr, code_sink);
-	});
+	if (_branch_count == 0) {
+		return std::accumulate(_items.begin(), _items.end(), std::size_t(0),
+			[&] (std::size_t bytes_emitted, const CodeBlockItem & item)
+		{
+			if (item.kind != CodeBlockItem::Chunk) return bytes_emitted;
+			const auto bytes_ptr = static_cast<char *>(location) + bytes_emitted;
+			return bytes_emitted + item.code_chunk->emit(bytes_ptr, code_sink);
+		});
+	}
+
+	CodeLayout layout;
+	layout_code(location, layout);
+
+	for (std::size_t i = 0; i < _items.size(); ++i) {
+		const CodeBlockItem & item = _items[i];
+		const std::size_t item_offset = layout.item_offsets[i];
+		if (item.kind == CodeBlockItem::Chunk) {
+			item.code_chunk->emit(static_cast<char *>(location) + item_offset, code_sink);
+		} else if (item.kind == CodeBlockItem::Branch) {
+			const bool near_branch = layout.near_branches[i];
+			const std::size_t branch_end = item_offset + branch_size(item.condition, near_branch);
+			const std::size_t target_offset = layout.label_offsets[item.label.id];
+			emit_branch(item.condition, near_branch, std::intptr_t(target_offset - branch_end), code_sink);
+		}
+	}
+
+	return layout.code_size;
+}
+
+void CodeBlock::collect_call_frame_rules(void * location, std::size_t offset, CallFrameRules & rules) const
+{
+	CodeLayout layout;
+	layout_code(location, layout);
+
+	for (std::size_t i = 0; i < _items.size(); ++i) {
+		const CodeBlockItem & item = _items[i];
+		if (item.kind != CodeBlockItem::Chunk) continue;
+
+		const std::size_t item_offset = layout.item_offsets[i];
+		void * const item_location = static_cast<char *>(location) + item_offset;
+		collect_chunk_frame_rules(*item.code_chunk, item_location, offset + item_offset, rules);
+	}
 }
 
 MemoryBufferCodeSink::MemoryBufferCodeSink(MutableMemoryBuffer & buffer)
@@ -91,4 +395,46 @@ void MemoryBufferCodeSink::append(const char * data, std::size_t size)
 	_offset += size;
 }
 
+StagingCodeSink::StagingCodeSink(MemoryManager & memory_manager, void * location, std::size_t capacity)
+	: _memory_manager { &memory_manager }
+	, _location { static_cast<char *>(location) }
+	, _capacity { capacity }
+{
+	_staging.reserve(capacity);
+}
+
+void StagingCodeSink::append(const char * data, std::size_t size)
+{
+	if (size > _capacity - _staging.size())
+		throw std::length_error("Generated code exceeds its reserved size");
+	_staging.insert(_staging.end(), data, data + size);
+}
+
+std::size_t StagingCodeSink::flush()
+{
+	const std::size_t code_size = _staging.size();
+	if (code_size == 0) return 0;
+
+	_memory_manager->copy_into(_staging.data(), code_size, _location);
+	_memory_manager->flush_instruction_cache(_location, code_size);
+	_location += code_size;
+	_capacity -= code_size;
+	_staging.clear();
+	return code_size;
+}
+
+std::size_t emit_code(const CodeChunk & code_chunk, MemoryManager & memory_manager, void * location)
+{
+	StagingCodeSink code_sink { memory_manager, location, code_chunk.max_size() };
+	code_chunk.emit(location, code_sink);
+	return code_sink.flush();
+}
+
+CallFrameRules collect_call_frame_rules(const CodeChunk & code_chunk, void * location)
+{
+	CallFrameRules rules;
+	collect_chunk_frame_rules(code_chunk, location, 0, rules);
+	return rules;
+}
+
 }
\ No newline at end of file
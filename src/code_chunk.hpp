@@ -8,6 +8,9 @@
 #include <load/codegen/code_generator.hpp>
 #include <load/codegen/calling_convention.hpp>
 
+#include <boost/container/small_vector.hpp>
+
+#include <cstdint>
 #include <memory>
 #include <string_view>
 #include <vector>
@@ -39,17 +42,78 @@ private:
 	std::string_view _data;
 };
 
-class FixedCodeChunk final : public CodeChunk
+struct CallFrameRule
+{
+	enum Kind : std::uint8_t { DefCfa, DefCfaOffset, DefCfaRegister, Offset, Restore, RememberState, RestoreState };
+
+	std::uint32_t offset;
+	Kind          kind;
+	std::uint8_t  reg;
+	std::int32_t  value;
+};
+
+// Inline room for the rules of a whole trampoline, prolog to epilog
+using CallFrameRules = boost::container::small_vector<CallFrameRule, 16>;
+
+struct CodeFixup
+{
+	enum Kind : std::uint8_t { Rel32, Call };
+
+	std::uint32_t  offset;
+	Kind           kind;
+	std::uintptr_t target;
+};
+
+class CodeAssembler final : public CodeChunk
 {
 public:
 	void append(char byte);
 	void append(std::string_view data);
+	void append_imm32(std::uintmax_t value);
+	void append_imm64(std::uintmax_t value);
+	void append_rel32(std::uintptr_t target);
+	void append_call(std::uintptr_t target);
+
+	// Call frame rules apply from the current end of the code, as their .cfi_* directives do
+	void cfi_def_cfa(unsigned int reg, std::int32_t offset);
+	void cfi_def_cfa_offset(std::int32_t offset);
+	void cfi_def_cfa_register(unsigned int reg);
+	void cfi_offset(unsigned int reg, std::int32_t offset);
+	void cfi_restore(unsigned int reg);
+	void cfi_remember_state();
+	void cfi_restore_state();
 
 	virtual std::size_t max_size() const override;
 	virtual std::size_t emit(void * location, CodeSink & code_sink) const override;
 
+	void collect_call_frame_rules(void * location, std::size_t offset, CallFrameRules & rules) const;
+
 private:
-	std::vector<char> _data;
+	struct PendingFrameRule
+	{
+		std::uint32_t fixup_count;
+		CallFrameRule rule;
+	};
+
+	void add_call_frame_rule(CallFrameRule::Kind kind, unsigned int reg, std::int32_t value);
+
+	boost::container::small_vector<char, 96>            _data;
+	boost::container::small_vector<CodeFixup, 2>        _fixups;
+	std::size_t                                         _call_count = 0;
+	// A prolog or epilog emits up to four rules
+	boost::container::small_vector<PendingFrameRule, 4> _frame_rules;
+};
+
+struct CodeLabel
+{
+	std::uint32_t id;
+};
+
+enum class BranchCondition : std::uint8_t
+{
+	Overflow, NoOverflow, Below, AboveOrEqual, Equal, NotEqual, BelowOrEqual, Above,
+	Sign, NoSign, Parity, NoParity, Less, GreaterOrEqual, LessOrEqual, Greater,
+	Always,
 };
 
 class CodeBlock final : public CodeChunk
@@ -57,11 +121,33 @@ class CodeBlock final : public CodeChunk
 public:
 	void add(std::unique_ptr<CodeChunk> code_chunk);
 
+	CodeLabel make_label();
+	void bind(CodeLabel label);
+	void add_branch(CodeLabel target, BranchCondition condition = BranchCondition::Always);
+
 	virtual std::size_t max_size() const override;
 	virtual std::size_t emit(void * location, CodeSink & code_sink) const override;
 
+	void collect_call_frame_rules(void * location, std::size_t offset, CallFrameRules & rules) const;
+
 private:
-	std::vector<std::unique_ptr<CodeChunk>> _code_chunks;
+	struct CodeBlockItem
+	{
+		enum Kind : std::uint8_t { Chunk, Label, Branch };
+
+		Kind                       kind;
+		BranchCondition            condition;
+		CodeLabel                  label;
+		std::unique_ptr<CodeChunk> code_chunk;
+	};
+
+	struct CodeLayout;
+
+	void layout_code(void * location, CodeLayout & layout) const;
+
+	boost::container::small_vector<CodeBlockItem, 8> _items;
+	std::uint32_t                                     _label_count  = 0;
+	std::uint32_t                                     _branch_count = 0;
 };
 
 class MemoryBufferCodeSink final : public CodeSink
@@ -76,6 +162,26 @@ private:
 	std::size_t _offset;
 };
 
+class StagingCodeSink final : public CodeSink
+{
+public:
+	StagingCodeSink(MemoryManager & memory_manager, void * location, std::size_t capacity);
+
+	virtual void append(const char * data, std::size_t size) override;
+	std::size_t flush();
+
+private:
+	MemoryManager   * _memory_manager;
+	char            * _location;
+	std::size_t       _capacity;
+	std::vector<char> _staging;
+};
+
+std::size_t emit_code(const CodeChunk & code_chunk, MemoryManager & memory_manager, void * location);
+
+// Rules are ordered by code offset; chunks without frame information contribute none
+CallFrameRules collect_call_frame_rules(const CodeChunk & code_chunk, void * location);
+
 template <typename... Params>
 ParameterList make_proc_params(Params... params)
 {
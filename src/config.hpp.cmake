@@ -12,5 +12,6 @@
 
 #cmakedefine LIBLOAD_ENABLE_FORMAT_PE32
 #cmakedefine LIBLOAD_ENABLE_FORMAT_PE64
+#cmakedefine LIBLOAD_ENABLE_FORMAT_ELF64
 
 #endif
\ No newline at end of file
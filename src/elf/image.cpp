@@ -0,0 +1,559 @@
+#include <config.hpp>
+#include "image.hpp"
+#include "../load_result.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace load::detail {
+
+namespace {
+
+constexpr std::uint64_t align_down(std::uint64_t value, std::uint64_t alignment)
+{
+	return value & ~(alignment - 1);
+}
+
+constexpr std::uint64_t align_up(std::uint64_t value, std::uint64_t alignment)
+{
+	return align_down(value + alignment - 1, alignment);
+}
+
+ModuleFormatError probe_elf_header(const Elf64_Ehdr & header)
+{
+	if (std::memcmp(header.e_ident, ELFMAG, SELFMAG) != 0) return ModuleFormatError::UnknownFormat;
+	if (header.e_ident[EI_CLASS] != ELFCLASS64 || header.e_ident[EI_DATA] != ELFDATA2LSB)
+		return ModuleFormatError::UnsupportedMachine;
+#ifdef LIBLOAD_ARCH_X86_64
+	if (header.e_machine != EM_X86_64) return ModuleFormatError::UnsupportedMachine;
+#else
+	return ModuleFormatError::UnsupportedMachine;
+#endif
+	if (header.e_ident[EI_VERSION] != EV_CURRENT || header.e_type != ET_DYN)
+		return ModuleFormatError::UnsupportedImage;
+	return ModuleFormatError::None;
+}
+
+template <typename T>
+const T * image_pointer(const ElfImageLayout & layout, const char * image_mem,
+                        std::uint64_t vaddr, std::uint64_t count = 1)
+{
+	const std::uint64_t offset = vaddr - layout.image_base;
+	if (vaddr < layout.image_base || offset > layout.image_size
+	 || count > (layout.image_size - offset) / sizeof(T))
+		throw std::runtime_error("Invalid dynamic section");
+	return reinterpret_cast<const T *>(image_mem + offset);
+}
+
+char * relocation_target(const ElfImageLayout & layout, char * image_mem, std::uint64_t vaddr)
+{
+	const std::uint64_t offset = vaddr - layout.image_base;
+	if (vaddr < layout.image_base || offset > layout.image_size - sizeof(std::uint64_t))
+		throw std::runtime_error("Invalid relocation entry");
+	return image_mem + offset;
+}
+
+void write_relocated_value(char * target, std::uint64_t value)
+{
+	std::memcpy(target, &value, sizeof(value));
+}
+
+std::uint32_t gnu_symbol_hash(std::string_view name)
+{
+	std::uint32_t hash = 5381;
+	for (const char c : name)
+		hash = hash * 33 + static_cast<unsigned char>(c);
+	return hash;
+}
+
+std::uint32_t sysv_symbol_hash(std::string_view name)
+{
+	std::uint32_t hash = 0;
+	for (const char c : name) {
+		hash = (hash << 4) + static_cast<unsigned char>(c);
+		hash ^= (hash >> 24) & 0xf0;
+	}
+	return hash & 0x0fffffff;
+}
+
+bool is_exported_symbol(const Elf64_Sym & symbol)
+{
+	const unsigned char binding = ELF64_ST_BIND(symbol.st_info);
+	return symbol.st_shndx != SHN_UNDEF && ELF64_ST_TYPE(symbol.st_info) != STT_TLS
+	    && (binding == STB_GLOBAL || binding == STB_WEAK || binding == STB_GNU_UNIQUE);
+}
+
+const Elf64_Sym * matching_symbol(const ElfDynamicInfo & dynamic, std::uint32_t index, std::string_view name)
+{
+	if (index >= dynamic.symbol_count) return nullptr;
+	const Elf64_Sym & symbol = dynamic.symbol_table[index];
+	return is_exported_symbol(symbol) && dynamic.string(symbol.st_name) == name ? &symbol : nullptr;
+}
+
+// Counts the symbols covered by the GNU hash chains, as the table holds no explicit count
+std::size_t gnu_hash_symbol_count(const ElfImageLayout & layout, const char * image_mem, std::uint64_t vaddr)
+{
+	const auto header = image_pointer<std::uint32_t>(layout, image_mem, vaddr, 4);
+	const std::uint32_t bucket_count = header[0], symbol_offset = header[1], bloom_size = header[2];
+	const std::uint64_t buckets_vaddr = vaddr + 16 + std::uint64_t(bloom_size) * 8;
+	const auto buckets = image_pointer<std::uint32_t>(layout, image_mem, buckets_vaddr, bucket_count);
+	const std::uint64_t chain_vaddr = buckets_vaddr + std::uint64_t(bucket_count) * 4;
+
+	const std::uint32_t last_bucket = bucket_count ? *std::max_element(buckets, buckets + bucket_count) : 0;
+	if (last_bucket < symbol_offset) return symbol_offset;
+
+	std::uint64_t index = last_bucket;
+	while (!(*image_pointer<std::uint32_t>(layout, image_mem, chain_vaddr + (index - symbol_offset) * 4) & 1))
+		++index;
+	return index + 1;
+}
+
+}
+
+std::size_t ElfImageLayout::memory_footprint() const
+{
+	return sizeof(*this) + segments.capacity() * sizeof(SegmentLayout);
+}
+
+ModuleFormatError probe_elf_image_64(const char * header, std::size_t header_size)
+{
+	Elf64_Ehdr elf_header;
+	if (header_size < sizeof(elf_header)) return ModuleFormatError::TruncatedHeaders;
+	std::memcpy(&elf_header, header, sizeof(elf_header));
+	return probe_elf_header(elf_header);
+}
+
+ElfImageLayout decode_elf_image_layout(const MemoryBuffer & image_data, std::size_t page_size,
+                                       LoadFailure * failure)
+{
+	Elf64_Ehdr header;
+	if (image_data.read(0, sizeof(header), &header) != sizeof(header) || probe_elf_header(header) != ModuleFormatError::None)
+		throw std::runtime_error("Malformed image headers");
+	if (header.e_phentsize != sizeof(Elf64_Phdr))
+		throw std::runtime_error("Malformed image headers");
+
+	std::vector<Elf64_Phdr> program_headers (header.e_phnum);
+	const std::size_t phdrs_size = program_headers.size() * sizeof(Elf64_Phdr);
+	if (image_data.read(header.e_phoff, phdrs_size, program_headers.data()) != phdrs_size)
+		throw std::runtime_error("Malformed image headers");
+
+	ElfImageLayout layout {};
+	std::uint64_t image_begin = std::numeric_limits<std::uint64_t>::max(), image_end = 0;
+	for (const Elf64_Phdr & phdr : program_headers) {
+		switch (phdr.p_type) {
+			case PT_LOAD:
+				if (phdr.p_filesz > phdr.p_memsz || phdr.p_vaddr + phdr.p_memsz < phdr.p_vaddr)
+					throw std::runtime_error("Invalid segment header");
+				layout.segments.push_back({ phdr.p_vaddr, phdr.p_memsz, phdr.p_offset, phdr.p_filesz, phdr.p_flags });
+				image_begin = std::min(image_begin, align_down(phdr.p_vaddr, page_size));
+				image_end = std::max(image_end, align_up(phdr.p_vaddr + phdr.p_memsz, page_size));
+				break;
+			case PT_DYNAMIC:      layout.dynamic = { phdr.p_vaddr, phdr.p_memsz }; break;
+			case PT_GNU_RELRO:    layout.relro = { phdr.p_vaddr, phdr.p_memsz }; break;
+			case PT_GNU_EH_FRAME: layout.eh_frame_hdr = { phdr.p_vaddr, phdr.p_memsz }; break;
+			case PT_TLS:
+				report_load_failure(failure, LoadError::UnsupportedFeature, "Thread local storage is not supported");
+				return {};
+		}
+	}
+
+	if (layout.segments.empty() || !layout.dynamic)
+		throw std::runtime_error("Image has no loadable segments");
+
+	layout.image_base = image_begin;
+	layout.image_size = image_end - image_begin;
+	for (const AddressRange & range : { layout.dynamic, layout.relro, layout.eh_frame_hdr }) {
+		if (range && (range.virtual_address < image_begin || range.virtual_address + range.size > image_end))
+			throw std::runtime_error("Invalid segment header");
+	}
+
+	layout.segments.shrink_to_fit();
+	return layout;
+}
+
+int elf_segment_memory_access(std::uint32_t flags)
+{
+	int mem_access = 0;
+	if (flags & PF_R) mem_access |= MemoryManager::ReadAccess;
+	if (flags & PF_W) mem_access |= MemoryManager::WriteAccess;
+	if (flags & PF_X) mem_access |= MemoryManager::ExecuteAccess;
+	return mem_access;
+}
+
+std::size_t map_elf_image_segments(const MemoryBuffer & image_data, const ElfImageLayout & layout,
+                                   char * image_mem, MemoryManager & memory_manager)
+{
+	std::size_t bytes_mapped = 0;
+	for (const SegmentLayout & segment : layout.segments) {
+		char * const segment_ptr = image_mem + (segment.virtual_address - layout.image_base);
+		memory_manager.commit(segment_ptr, segment.memory_size);
+		if (image_data.read(segment.file_offset, segment.file_size, segment_ptr) != segment.file_size)
+			throw std::runtime_error("Invalid segment header");
+		bytes_mapped += segment.file_size;
+	}
+
+	return bytes_mapped;
+}
+
+std::size_t apply_elf_memory_permissions(const ElfImageLayout & layout, char * image_mem,
+                                         MemoryManager & memory_manager)
+{
+	std::size_t bytes_protected = 0;
+	for (const SegmentLayout & segment : layout.segments) {
+		char * const segment_ptr = image_mem + (segment.virtual_address - layout.image_base);
+		memory_manager.set_access(segment_ptr, segment.memory_size, elf_segment_memory_access(segment.flags));
+		bytes_protected += segment.memory_size;
+	}
+
+	if (layout.relro) {
+		const std::size_t page_size = memory_manager.page_size();
+		const std::uint64_t relro_begin = align_down(layout.relro.virtual_address, page_size);
+		const std::uint64_t relro_end = align_down(layout.relro.virtual_address + layout.relro.size, page_size);
+		if (relro_begin < relro_end)
+			memory_manager.set_access(image_mem + (relro_begin - layout.image_base), relro_end - relro_begin,
+			                          MemoryManager::ReadAccess);
+	}
+
+	memory_manager.flush_instruction_cache(image_mem, layout.image_size);
+	return bytes_protected;
+}
+
+std::string_view ElfDynamicInfo::string(std::uint32_t offset) const
+{
+	if (offset >= string_table_size) return {};
+	return std::string_view(string_table + offset, strnlen(string_table + offset, string_table_size - offset));
+}
+
+ElfDynamicInfo decode_elf_dynamic_info(const ElfImageLayout & layout, const char * image_mem)
+{
+	const std::size_t dyn_count = layout.dynamic.size / sizeof(Elf64_Dyn);
+	const auto dyn_entries = image_pointer<Elf64_Dyn>(layout, image_mem, layout.dynamic.virtual_address, dyn_count);
+
+	ElfDynamicInfo dynamic;
+	std::uint64_t strtab = 0, symtab = 0, gnu_hash = 0, sysv_hash = 0, rela = 0, jmprel = 0, relr = 0;
+	std::uint64_t rela_size = 0, jmprel_size = 0, relr_size = 0;
+	for (const Elf64_Dyn * dyn = dyn_entries; dyn != dyn_entries + dyn_count && dyn->d_tag != DT_NULL; ++dyn) {
+		const std::uint64_t value = dyn->d_un.d_val;
+		switch (dyn->d_tag) {
+			case DT_NEEDED:        dynamic.needed.push_back(std::uint32_t(value)); break;
+			case DT_SONAME:        dynamic.soname = std::uint32_t(value); break;
+			case DT_STRTAB:        strtab = value; break;
+			case DT_STRSZ:         dynamic.string_table_size = value; break;
+			case DT_SYMTAB:        symtab = value; break;
+			case DT_GNU_HASH:      gnu_hash = value; break;
+			case DT_HASH:          sysv_hash = value; break;
+			case DT_RELA:          rela = value; break;
+			case DT_RELASZ:        rela_size = value; break;
+			case DT_RELACOUNT:     dynamic.rela.relative_count = value; break;
+			case DT_JMPREL:        jmprel = value; break;
+			case DT_PLTRELSZ:      jmprel_size = value; break;
+			case DT_RELR:          relr = value; break;
+			case DT_RELRSZ:        relr_size = value; break;
+			case DT_INIT:          dynamic.init = value; break;
+			case DT_FINI:          dynamic.fini = value; break;
+			case DT_INIT_ARRAY:    dynamic.init_array.virtual_address = value; break;
+			case DT_INIT_ARRAYSZ:  dynamic.init_array.size = value; break;
+			case DT_FINI_ARRAY:    dynamic.fini_array.virtual_address = value; break;
+			case DT_FINI_ARRAYSZ:  dynamic.fini_array.size = value; break;
+			case DT_SYMENT:
+				if (value != sizeof(Elf64_Sym)) throw std::runtime_error("Invalid dynamic section");
+				break;
+			case DT_PLTREL:
+				if (value != DT_RELA) throw std::runtime_error("Unsupported relocation type");
+				break;
+			case DT_REL:
+				throw std::runtime_error("Unsupported relocation type");
+		}
+	}
+
+	dynamic.string_table = image_pointer<char>(layout, image_mem, strtab, dynamic.string_table_size);
+	if (gnu_hash) {
+		dynamic.gnu_hash = image_pointer<std::uint32_t>(layout, image_mem, gnu_hash, 4);
+		dynamic.symbol_count = gnu_hash_symbol_count(layout, image_mem, gnu_hash);
+	}
+	if (sysv_hash) {
+		dynamic.sysv_hash = image_pointer<std::uint32_t>(layout, image_mem, sysv_hash, 2);
+		const std::uint32_t bucket_count = dynamic.sysv_hash[0], chain_count = dynamic.sysv_hash[1];
+		image_pointer<std::uint32_t>(layout, image_mem, sysv_hash, 2 + std::uint64_t(bucket_count) + chain_count);
+		dynamic.symbol_count = std::max<std::size_t>(dynamic.symbol_count, chain_count);
+	}
+	if (dynamic.symbol_count != 0)
+		dynamic.symbol_table = image_pointer<Elf64_Sym>(layout, image_mem, symtab, dynamic.symbol_count);
+
+	dynamic.rela.count = rela_size / sizeof(Elf64_Rela);
+	if (dynamic.rela.count != 0)
+		dynamic.rela.entries = image_pointer<Elf64_Rela>(layout, image_mem, rela, dynamic.rela.count);
+	dynamic.rela.relative_count = std::min(dynamic.rela.relative_count, dynamic.rela.count);
+
+	dynamic.jmprel.count = jmprel_size / sizeof(Elf64_Rela);
+	if (dynamic.jmprel.count != 0)
+		dynamic.jmprel.entries = image_pointer<Elf64_Rela>(layout, image_mem, jmprel, dynamic.jmprel.count);
+
+	dynamic.relr_count = relr_size / sizeof(std::uint64_t);
+	if (dynamic.relr_count != 0)
+		dynamic.relr = image_pointer<std::uint64_t>(layout, image_mem, relr, dynamic.relr_count);
+
+	for (const AddressRange & range : { dynamic.init_array, dynamic.fini_array }) {
+		if (range) image_pointer<std::uint64_t>(layout, image_mem, range.virtual_address, range.size / 8);
+	}
+
+	return dynamic;
+}
+
+const Elf64_Sym * find_elf_symbol(const ElfDynamicInfo & dynamic, std::string_view name)
+{
+	if (const std::uint32_t * const table = dynamic.gnu_hash) {
+		const std::uint32_t bucket_count = table[0], symbol_offset = table[1];
+		const std::uint32_t bloom_size = table[2], bloom_shift = table[3];
+		if (bucket_count == 0 || bloom_size == 0) return nullptr;
+
+		const auto bloom = reinterpret_cast<const std::uint64_t *>(table + 4);
+		const std::uint32_t * const buckets = table + 4 + bloom_size * 2;
+		const std::uint32_t * const chain = buckets + bucket_count - symbol_offset;
+
+		const std::uint32_t hash = gnu_symbol_hash(name);
+		const std::uint64_t bloom_word = bloom[(hash / 64) % bloom_size];
+		const std::uint64_t bloom_mask = (std::uint64_t(1) << (hash % 64))
+		                               | (std::uint64_t(1) << ((hash >> bloom_shift) % 64));
+		if ((bloom_word & bloom_mask) != bloom_mask) return nullptr;
+
+		std::uint32_t index = buckets[hash % bucket_count];
+		if (index < symbol_offset) return nullptr;
+		for (; index < dynamic.symbol_count; ++index) {
+			const std::uint32_t chain_hash = chain[index];
+			if ((chain_hash | 1) == (hash | 1)) {
+				if (const Elf64_Sym * const symbol = matching_symbol(dynamic, index, name))
+					return symbol;
+			}
+			if (chain_hash & 1) break;
+		}
+		return nullptr;
+	}
+
+	if (const std::uint32_t * const table = dynamic.sysv_hash) {
+		const std::uint32_t bucket_count = table[0], chain_count = table[1];
+		if (bucket_count == 0) return nullptr;
+
+		const std::uint32_t * const buckets = table + 2;
+		const std::uint32_t * const chain = buckets + bucket_count;
+		std::uint32_t index = buckets[sysv_symbol_hash(name) % bucket_count];
+		for (std::uint32_t steps = 0; index != STN_UNDEF && index < chain_count && steps < chain_count; ++steps) {
+			if (const Elf64_Sym * const symbol = matching_symbol(dynamic, index, name))
+				return symbol;
+			index = chain[index];
+		}
+	}
+
+	return nullptr;
+}
+
+std::uintptr_t elf_load_bias(const ElfImageLayout & layout, const char * image_mem)
+{
+	return reinterpret_cast<std::uintptr_t>(image_mem) - layout.image_base;
+}
+
+std::uintptr_t elf_symbol_address(const Elf64_Sym & symbol, std::uintptr_t load_bias)
+{
+	if (symbol.st_shndx == SHN_ABS) return symbol.st_value;
+
+	const std::uintptr_t address = load_bias + symbol.st_value;
+	if (ELF64_ST_TYPE(symbol.st_info) == STT_GNU_IFUNC)
+		return reinterpret_cast<std::uintptr_t (*)()>(address)();
+	return address;
+}
+
+std::size_t apply_elf_relative_relocations(const ElfImageLayout & layout,
+                                           const ElfDynamicInfo & dynamic,
+                                           char                 * image_mem)
+{
+	const std::uintptr_t load_bias = elf_load_bias(layout, image_mem);
+
+	// The linker sorts R_X86_64_RELATIVE entries first and counts them in DT_RELACOUNT
+	for (std::size_t i = 0; i < dynamic.rela.relative_count; ++i) {
+		const Elf64_Rela & reloc = dynamic.rela.entries[i];
+		if (ELF64_R_TYPE(reloc.r_info) != R_X86_64_RELATIVE)
+			throw std::runtime_error("Invalid relocation entry");
+		write_relocated_value(relocation_target(layout, image_mem, reloc.r_offset), load_bias + reloc.r_addend);
+	}
+
+	std::size_t relr_count = 0;
+	const char * const image_end = image_mem + layout.image_size;
+	std::uint64_t * where = nullptr;
+	for (std::size_t i = 0; i < dynamic.relr_count; ++i) {
+		const std::uint64_t entry = dynamic.relr[i];
+		if ((entry & 1) == 0) {
+			where = reinterpret_cast<std::uint64_t *>(relocation_target(layout, image_mem, entry));
+			*where++ += load_bias;
+			++relr_count;
+		} else {
+			if (where == nullptr)
+				throw std::runtime_error("Invalid relocation entry");
+			for (std::uint64_t bitmap = entry >> 1, bit = 0; bitmap != 0; bitmap >>= 1, ++bit) {
+				if ((bitmap & 1) == 0) continue;
+				if (reinterpret_cast<const char *>(where + bit + 1) > image_end)
+					throw std::runtime_error("Invalid relocation entry");
+				where[bit] += load_bias;
+				++relr_count;
+			}
+			where += 63;
+		}
+	}
+
+	return dynamic.rela.relative_count + relr_count;
+}
+
+std::size_t apply_elf_symbol_relocations(const ElfImageLayout    & layout,
+                                         const ElfDynamicInfo    & dynamic,
+                                         char                    * image_mem,
+                                         const ElfSymbolResolver & resolve_symbol,
+                                         LoadFailure             * failure)
+{
+	const std::uintptr_t load_bias = elf_load_bias(layout, image_mem);
+
+	constexpr std::uintptr_t unresolved = std::numeric_limits<std::uintptr_t>::max();
+	std::vector<std::uintptr_t> symbol_addresses (dynamic.symbol_count, unresolved);
+	const auto symbol_address = [&] (std::uint32_t index) -> std::uintptr_t {
+		if (index == STN_UNDEF) return 0;
+		if (index >= dynamic.symbol_count)
+			throw std::runtime_error("Invalid relocation entry");
+
+		std::uintptr_t & address = symbol_addresses[index];
+		if (address != unresolved) return address;
+
+		const Elf64_Sym & symbol = dynamic.symbol_table[index];
+		const std::string_view name = dynamic.string(symbol.st_name);
+		if (symbol.st_shndx != SHN_UNDEF) {
+			address = elf_symbol_address(symbol, load_bias);
+		} else if (const void * const import_addr = resolve_symbol(name)) {
+			address = reinterpret_cast<std::uintptr_t>(import_addr);
+		} else if (ELF64_ST_BIND(symbol.st_info) == STB_WEAK) {
+			address = 0;
+		} else {
+			report_load_failure(failure, LoadError::MissingSymbol, "Image has unresolved imports", {}, name);
+		}
+		return address;
+	};
+
+	std::size_t reloc_count = 0;
+	std::vector<const Elf64_Rela *> irelative_relocs;
+	const auto apply_relocations = [&] (const Elf64_Rela * relocs, std::size_t count) {
+		for (const Elf64_Rela * reloc = relocs; reloc != relocs + count; ++reloc) {
+			char * const target = relocation_target(layout, image_mem, reloc->r_offset);
+			switch (ELF64_R_TYPE(reloc->r_info)) {
+				case R_X86_64_NONE:
+					continue;
+				case R_X86_64_RELATIVE:
+					write_relocated_value(target, load_bias + reloc->r_addend);
+					break;
+				case R_X86_64_64:
+				case R_X86_64_GLOB_DAT:
+				case R_X86_64_JUMP_SLOT: {
+					const std::uintptr_t address = symbol_address(ELF64_R_SYM(reloc->r_info));
+					if (address == unresolved) return false;
+					write_relocated_value(target, address + reloc->r_addend);
+					break;
+				}
+				case R_X86_64_IRELATIVE:
+					irelative_relocs.push_back(reloc);
+					continue;
+				case R_X86_64_DTPMOD64:
+				case R_X86_64_DTPOFF64:
+				case R_X86_64_TPOFF64:
+					report_load_failure(failure, LoadError::UnsupportedFeature, "Thread local storage is not supported");
+					return false;
+				default:
+					report_load_failure(failure, LoadError::UnsupportedFeature, "Unsupported relocation type");
+					return false;
+			}
+			++reloc_count;
+		}
+		return true;
+	};
+	if (!apply_relocations(dynamic.rela.entries + dynamic.rela.relative_count,
+	                       dynamic.rela.count - dynamic.rela.relative_count) ||
+	    !apply_relocations(dynamic.jmprel.entries, dynamic.jmprel.count))
+		return reloc_count;
+
+	// IFUNC resolvers may read relocated data, so they run once everything else is bound
+	for (const Elf64_Rela * reloc : irelative_relocs) {
+		const auto resolver = reinterpret_cast<std::uintptr_t (*)()>(load_bias + reloc->r_addend);
+		write_relocated_value(relocation_target(layout, image_mem, reloc->r_offset), resolver());
+		++reloc_count;
+	}
+
+	return reloc_count;
+}
+
+ModuleMemoryStats elf_image_memory_stats(const ElfImageLayout & layout, const char * image_mem,
+                                         const MemoryManager & memory_manager)
+{
+	const std::size_t page_size = memory_manager.page_size();
+
+	ModuleMemoryStats mem_stats;
+	mem_stats.reserved_size = layout.image_size;
+	for (const SegmentLayout & segment : layout.segments) {
+		const std::uint64_t segment_begin = align_down(segment.virtual_address, page_size);
+		const std::uint64_t segment_end = align_up(segment.virtual_address + segment.memory_size, page_size);
+		const char * const segment_ptr = image_mem + (segment_begin - layout.image_base);
+
+		SectionMemoryStats & seg_stats = mem_stats.sections.emplace_back();
+		seg_stats.name = "LOAD";
+		seg_stats.address = reinterpret_cast<std::uintptr_t>(segment_ptr);
+		seg_stats.reserved_size = segment_end - segment_begin;
+
+		const MemoryManager::MemoryState mem_state = memory_manager.memory_state(segment_ptr, seg_stats.reserved_size);
+		seg_stats.committed_size = mem_state.committed_size;
+		seg_stats.resident_size = mem_state.committed_size != 0
+		                        ? memory_manager.resident_size(segment_ptr, seg_stats.reserved_size) : 0;
+		seg_stats.access = mem_state.access;
+		seg_stats.discarded = mem_state.committed_size == 0;
+
+		mem_stats.committed_size += seg_stats.committed_size;
+		mem_stats.resident_size += seg_stats.resident_size;
+	}
+
+	return mem_stats;
+}
+
+ModuleRange elf_image_module_range(const ElfImageLayout & layout, const char * image_mem, const Module * module)
+{
+	return { reinterpret_cast<std::uintptr_t>(image_mem), layout.image_size, module, nullptr, 0 };
+}
+
+std::vector<PerfMapEntry> elf_image_perf_map_entries(const ElfImageLayout & layout, const ElfDynamicInfo & dynamic,
+                                                     const char * image_mem)
+{
+	const std::uintptr_t load_bias = elf_load_bias(layout, image_mem);
+	std::string module_name { dynamic.string(dynamic.soname) };
+	if (module_name.empty()) module_name = "libload_module";
+
+	std::vector<PerfMapEntry> entries;
+	for (std::size_t i = 0; i < dynamic.symbol_count; ++i) {
+		const Elf64_Sym & symbol = dynamic.symbol_table[i];
+		if (ELF64_ST_TYPE(symbol.st_info) != STT_FUNC || symbol.st_shndx == SHN_UNDEF || symbol.st_size == 0)
+			continue;
+		const std::string_view name = dynamic.string(symbol.st_name);
+		entries.push_back({ load_bias + symbol.st_value, symbol.st_size, module_name + '!' + std::string(name) });
+	}
+
+	return entries;
+}
+
+const char * find_elf_eh_frame(const ElfImageLayout & layout, const char * image_mem)
+{
+	constexpr unsigned char DW_EH_PE_pcrel_sdata4 = 0x1b;
+
+	if (layout.eh_frame_hdr.size < 8) return nullptr;
+	const auto header = image_pointer<unsigned char>(layout, image_mem, layout.eh_frame_hdr.virtual_address, 8);
+	if (header[0] != 1 || header[1] != DW_EH_PE_pcrel_sdata4) return nullptr;
+
+	std::int32_t eh_frame_offset;
+	std::memcpy(&eh_frame_offset, header + 4, sizeof(eh_frame_offset));
+	const std::uint64_t eh_frame_vaddr = layout.eh_frame_hdr.virtual_address + 4 + eh_frame_offset;
+	return image_pointer<char>(layout, image_mem, eh_frame_vaddr, 4);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef LOAD_SRC_ELF_IMAGE_HPP_
+#define LOAD_SRC_ELF_IMAGE_HPP_
+
+#include "image_layout.hpp"
+#include "../perf_map.hpp"
+
+#include <load/memory/memory_manager.hpp>
+#include <load/module/memory_stats.hpp>
+#include <load/module/module.hpp>
+#include <load/module/module_registry.hpp>
+
+#include <elf.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+namespace load::detail {
+
+struct ElfRelocations
+{
+	const Elf64_Rela * entries        = nullptr;
+	std::size_t        count          = 0;
+	std::size_t        relative_count = 0;
+};
+
+struct ElfDynamicInfo
+{
+	const char               * string_table      = nullptr;
+	std::size_t                string_table_size = 0;
+	const Elf64_Sym          * symbol_table      = nullptr;
+	std::size_t                symbol_count      = 0;
+	const std::uint32_t      * gnu_hash          = nullptr;
+	const std::uint32_t      * sysv_hash         = nullptr;
+	ElfRelocations             rela;
+	ElfRelocations             jmprel;
+	const std::uint64_t      * relr              = nullptr;
+	std::size_t                relr_count        = 0;
+	std::uint64_t              init              = 0;
+	std::uint64_t              fini              = 0;
+	std::uint32_t              soname            = 0;
+	AddressRange               init_array;
+	AddressRange               fini_array;
+	std::vector<std::uint32_t> needed;
+
+	std::string_view string(std::uint32_t offset) const;
+};
+
+std::size_t map_elf_image_segments(const MemoryBuffer & image_data, const ElfImageLayout & layout,
+                                   char * image_mem, MemoryManager & memory_manager);
+std::size_t apply_elf_memory_permissions(const ElfImageLayout & layout, char * image_mem,
+                                         MemoryManager & memory_manager);
+
+ElfDynamicInfo decode_elf_dynamic_info(const ElfImageLayout & layout, const char * image_mem);
+
+// Walks the GNU hash bloom filter and chains, falling back to the SysV hash table
+const Elf64_Sym * find_elf_symbol(const ElfDynamicInfo & dynamic, std::string_view name);
+
+std::uintptr_t elf_load_bias(const ElfImageLayout & layout, const char * image_mem);
+std::uintptr_t elf_symbol_address(const Elf64_Sym & symbol, std::uintptr_t load_bias);
+
+// Returns the address bound to an undefined symbol, or null if it can't be resolved
+using ElfSymbolResolver = std::function<const void * (std::string_view name)>;
+
+std::size_t apply_elf_relative_relocations(const ElfImageLayout & layout,
+                                           const ElfDynamicInfo & dynamic,
+                                           char                 * image_mem);
+
+std::size_t apply_elf_symbol_relocations(const ElfImageLayout    & layout,
+                                         const ElfDynamicInfo    & dynamic,
+                                         char                    * image_mem,
+                                         const ElfSymbolResolver & resolve_symbol,
+                                         LoadFailure             * failure = nullptr);
+
+ModuleMemoryStats elf_image_memory_stats(const ElfImageLayout & layout, const char * image_mem,
+                                         const MemoryManager & memory_manager);
+
+ModuleRange elf_image_module_range(const ElfImageLayout & layout, const char * image_mem, const Module * module);
+std::vector<PerfMapEntry> elf_image_perf_map_entries(const ElfImageLayout & layout, const ElfDynamicInfo & dynamic,
+                                                     const char * image_mem);
+
+// The .eh_frame located through PT_GNU_EH_FRAME, or null
+const char * find_elf_eh_frame(const ElfImageLayout & layout, const char * image_mem);
+
+}
+
+#endif
\ No newline at end of file
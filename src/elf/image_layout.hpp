@@ -0,0 +1,52 @@
+#ifndef LOAD_SRC_ELF_IMAGELAYOUT_HPP_
+#define LOAD_SRC_ELF_IMAGELAYOUT_HPP_
+
+#include <load/memory/memory_buffer.hpp>
+#include <load/module/load_result.hpp>
+#include <load/module/module_format.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace load::detail {
+
+struct SegmentLayout
+{
+	std::uint64_t virtual_address;
+	std::uint64_t memory_size;
+	std::uint64_t file_offset;
+	std::uint64_t file_size;
+	std::uint32_t flags;
+};
+
+struct AddressRange
+{
+	std::uint64_t virtual_address = 0;
+	std::uint64_t size            = 0;
+
+	explicit operator bool() const { return size != 0; }
+};
+
+// Virtual addresses are as linked; the image is mapped from image_base, the lowest PT_LOAD page
+struct ElfImageLayout
+{
+	std::uint64_t              image_base;
+	std::uint64_t              image_size;
+	std::vector<SegmentLayout> segments;
+	AddressRange               dynamic;
+	AddressRange               relro;
+	AddressRange               eh_frame_hdr;
+
+	std::size_t memory_footprint() const;
+};
+
+ModuleFormatError probe_elf_image_64(const char * header, std::size_t header_size);
+ElfImageLayout decode_elf_image_layout(const MemoryBuffer & image_data, std::size_t page_size,
+                                       LoadFailure * failure = nullptr);
+
+int elf_segment_memory_access(std::uint32_t flags);
+
+}
+
+#endif
\ No newline at end of file
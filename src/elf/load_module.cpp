@@ -0,0 +1,133 @@
+#include <config.hpp>
+#include "module.hpp"
+#include "../load_observer.hpp"
+#include "../load_result.hpp"
+#include "../module_format.hpp"
+
+#include <load/module/import_resolver.hpp>
+#include <load/process/process.hpp>
+
+#include <stdexcept>
+
+namespace load::detail {
+
+std::shared_ptr<ElfModule> load_elf_module_64(const MemoryBuffer & image_data,
+                                              const LoadOptions  & options,
+                                              ModuleProvider     & module_provider,
+                                              Process            & into_process,
+                                              LoadFailure        * failure)
+{
+	MemoryManager & mem_manager = into_process.memory_manager();
+	if (!mem_manager.allows_direct_addressing())
+		throw std::logic_error("ELF modules can only be loaded into the current process");
+	if (options.call_instrumentation != CallInstrumentation::None)
+		throw std::logic_error("Unsupported call instrumentation");
+
+	ElfImageLayout image_layout = decode_elf_image_layout(image_data, mem_manager.page_size(), failure);
+	if (has_load_failure(failure)) return nullptr;
+
+	const std::size_t image_size = image_layout.image_size;
+	OwnedMemoryBlock image_mem { mem_manager, mem_manager.allocate(0, image_size), image_size };
+	{
+		LoadPhaseScope map_phase { options.observer, LoadPhase::MapSections };
+		map_phase.stats.bytes = map_elf_image_segments(image_data, image_layout, image_mem.data(), mem_manager);
+	}
+
+	ElfDynamicInfo dynamic_info = decode_elf_dynamic_info(image_layout, image_mem.data());
+	{
+		LoadPhaseScope reloc_phase { options.observer, LoadPhase::ApplyRelocations };
+		reloc_phase.stats.relocations = apply_elf_relative_relocations(image_layout, dynamic_info, image_mem.data());
+	}
+
+	std::vector<ElfModule::NeededModule> needed_modules;
+	{
+		LoadPhaseScope import_phase { options.observer, LoadPhase::ResolveImports };
+		for (const std::uint32_t name_offset : dynamic_info.needed) {
+			std::string mod_name { dynamic_info.string(name_offset) };
+			DependencyScope dependency_scope { options.observer, mod_name };
+			auto mod_sp = module_provider.get_module(mod_name);
+			if (!mod_sp) {
+				report_load_failure(failure, LoadError::MissingModule, "Image has unresolved imports", mod_name);
+				return nullptr;
+			}
+			dependency_scope.resolved = true;
+			needed_modules.emplace_back(std::move(mod_name), std::move(mod_sp));
+		}
+
+		ImportResolver * const import_resolver = options.import_resolver;
+		import_phase.stats.imports = apply_elf_symbol_relocations(image_layout, dynamic_info, image_mem.data(),
+			[&] (std::string_view name) -> const void * {
+				for (const auto & [mod_name, mod_sp] : needed_modules) {
+					if (const void * const import_addr = mod_sp->get_data<void>(name))
+						return import_resolver ? import_resolver->resolve_import(mod_name, name, import_addr)
+						                       : import_addr;
+				}
+				return import_resolver ? import_resolver->resolve_import({}, name, nullptr) : nullptr;
+			}, failure);
+	}
+	if (has_load_failure(failure)) return nullptr;
+	{
+		LoadPhaseScope access_phase { options.observer, LoadPhase::ApplyPermissions };
+		access_phase.stats.bytes = apply_elf_memory_permissions(image_layout, image_mem.data(), mem_manager);
+	}
+
+	auto module = std::make_shared<ElfModule>(into_process, image_mem.data(), std::move(image_layout),
+	                                          std::move(dynamic_info), std::move(needed_modules));
+	image_mem.release();
+	{
+		LoadPhaseScope init_phase { options.observer, LoadPhase::Initialize };
+		module->initialize();
+	}
+	return module;
+}
+
+namespace {
+
+class ElfModuleFormat final : public ModuleFormat
+{
+public:
+	virtual std::string_view name() const override
+	{
+		return "elf64";
+	}
+
+	virtual std::string_view magic() const override
+	{
+		return { ELFMAG, SELFMAG };
+	}
+
+	virtual ModuleFormatError probe(const char * header, std::size_t header_size) const override
+	{
+		return probe_elf_image_64(header, header_size);
+	}
+
+	virtual std::shared_ptr<Module> load(const MemoryBuffer & module_data,
+	                                     const LoadOptions  & options,
+	                                     ModuleProvider     & module_provider,
+	                                     Process            & into_process) const override
+	{
+		return load_or_throw([&] (LoadFailure * failure) {
+			return load_elf_module_64(module_data, options, module_provider, into_process, failure);
+		});
+	}
+
+	virtual LoadResult try_load(const MemoryBuffer & module_data,
+	                            const LoadOptions  & options,
+	                            ModuleProvider     & module_provider,
+	                            Process            & into_process) const override
+	{
+		return catch_load_failure([&] (LoadFailure * failure) {
+			return load_elf_module_64(module_data, options, module_provider, into_process, failure);
+		});
+	}
+};
+
+}
+
+const ModuleFormat & elf64_module_format()
+{
+	static const ElfModuleFormat format;
+	return format;
+}
+
+}
\ No newline at end of file
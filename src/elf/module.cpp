@@ -0,0 +1,120 @@
+#include "module.hpp"
+#include "../module_registry.hpp"
+#include "../perf_map.hpp"
+#include "../platform/unwind_frames.hpp"
+
+#include <load/process/process.hpp>
+
+#include <unistd.h>
+
+namespace load::detail {
+
+namespace {
+
+using elf_init_fn = void (*)(int, char **, char **);
+using elf_fini_fn = void (*)();
+
+bool is_callable_entry(std::uintptr_t entry)
+{
+	return entry != 0 && entry != ~std::uintptr_t(0);
+}
+
+}
+
+ElfModule::ElfModule(Process                 & process,
+                     void                    * image_ptr,
+                     ElfImageLayout            image_layout,
+                     ElfDynamicInfo            dynamic_info,
+                     std::vector<NeededModule> needed_modules)
+	: _needed_modules { std::move(needed_modules) }
+	, _image_mem { process.memory_manager(), image_ptr, image_layout.image_size }
+	, _image_layout { std::move(image_layout) }
+	, _dynamic_info { std::move(dynamic_info) }
+	, _eh_frame { find_elf_eh_frame(_image_layout, _image_mem.data()) }
+	, _initialized { false }
+{
+	if (_eh_frame != nullptr && !register_unwind_frames(_eh_frame))
+		_eh_frame = nullptr;
+
+	module_registry().add(elf_image_module_range(_image_layout, _image_mem.data(), this));
+	if (PerfMap * const map = perf_map())
+		map->add(this, elf_image_perf_map_entries(_image_layout, _dynamic_info, _image_mem.data()));
+}
+
+ElfModule::~ElfModule()
+{
+	const std::uintptr_t load_bias = elf_load_bias(_image_layout, _image_mem.data());
+	if (_initialized) {
+		const AddressRange & fini_array = _dynamic_info.fini_array;
+		const auto fini_entries = reinterpret_cast<const std::uintptr_t *>(load_bias + fini_array.virtual_address);
+		for (std::size_t i = fini_array.size / sizeof(std::uintptr_t); i-- > 0;) {
+			if (is_callable_entry(fini_entries[i]))
+				reinterpret_cast<elf_fini_fn>(fini_entries[i])();
+		}
+		if (_dynamic_info.fini != 0)
+			reinterpret_cast<elf_fini_fn>(load_bias + _dynamic_info.fini)();
+	}
+
+	if (_eh_frame != nullptr)
+		deregister_unwind_frames(_eh_frame);
+	module_registry().remove(reinterpret_cast<std::uintptr_t>(_image_mem.data()));
+	if (PerfMap * const map = perf_map())
+		map->remove(this);
+}
+
+void ElfModule::initialize()
+{
+	const std::uintptr_t load_bias = elf_load_bias(_image_layout, _image_mem.data());
+	if (_dynamic_info.init != 0)
+		reinterpret_cast<elf_init_fn>(load_bias + _dynamic_info.init)(0, nullptr, environ);
+
+	const AddressRange & init_array = _dynamic_info.init_array;
+	const auto init_entries = reinterpret_cast<const std::uintptr_t *>(load_bias + init_array.virtual_address);
+	for (std::size_t i = 0; i < init_array.size / sizeof(std::uintptr_t); ++i) {
+		if (is_callable_entry(init_entries[i]))
+			reinterpret_cast<elf_init_fn>(init_entries[i])(0, nullptr, environ);
+	}
+
+	_initialized = true;
+}
+
+ModuleMemoryStats ElfModule::memory_stats() const
+{
+	ModuleMemoryStats mem_stats = elf_image_memory_stats(_image_layout, _image_mem.data(),
+	                                                     _image_mem.memory_manager());
+	mem_stats.metadata_size = sizeof(*this) + _image_layout.memory_footprint()
+	                        + _needed_modules.capacity() * sizeof(NeededModule)
+	                        + _dynamic_info.needed.capacity() * sizeof(std::uint32_t);
+	return mem_stats;
+}
+
+ModuleAbi ElfModule::abi() const
+{
+	return ModuleAbi::SystemV;
+}
+
+void * ElfModule::tls_data() const
+{
+	return nullptr;
+}
+
+DataPtr ElfModule::get_data_address(std::string_view name) const
+{
+	return reinterpret_cast<DataPtr>(find_symbol(name));
+}
+
+ProcPtr ElfModule::get_proc_address(std::string_view name) const
+{
+	return reinterpret_cast<ProcPtr>(find_symbol(name));
+}
+
+const void * ElfModule::find_symbol(std::string_view name) const
+{
+	const Elf64_Sym * const symbol = find_elf_symbol(_dynamic_info, name);
+	if (symbol == nullptr) return nullptr;
+
+	const std::uintptr_t load_bias = elf_load_bias(_image_layout, _image_mem.data());
+	return reinterpret_cast<const void *>(elf_symbol_address(*symbol, load_bias));
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef LOAD_SRC_ELF_MODULE_HPP_
+#define LOAD_SRC_ELF_MODULE_HPP_
+
+#include "image.hpp"
+#include "../memory_block.hpp"
+#include <load/module/load_options.hpp>
+#include <load/module/module.hpp>
+#include <load/module/module_provider.hpp>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace load::detail {
+
+class ElfModule final : public Module
+{
+public:
+	using NeededModule = std::pair<std::string, std::shared_ptr<Module>>;
+
+	ElfModule(Process                 & process,
+	          void                    * image_ptr,
+	          ElfImageLayout            image_layout,
+	          ElfDynamicInfo            dynamic_info,
+	          std::vector<NeededModule> needed_modules);
+
+	ElfModule(const ElfModule &) = delete;
+	ElfModule & operator=(const ElfModule &) = delete;
+	virtual ~ElfModule();
+
+	// Runs DT_INIT and DT_INIT_ARRAY; finalizers only run for initialized modules
+	void initialize();
+
+	virtual ModuleMemoryStats memory_stats() const override;
+	virtual ModuleAbi abi() const override;
+	virtual void * tls_data() const override;
+
+protected:
+	virtual DataPtr get_data_address(std::string_view name) const override;
+	virtual ProcPtr get_proc_address(std::string_view name) const override;
+
+private:
+	const void * find_symbol(std::string_view name) const;
+
+	std::vector<NeededModule> _needed_modules;
+	OwnedMemoryBlock          _image_mem;
+	ElfImageLayout            _image_layout;
+	ElfDynamicInfo            _dynamic_info;
+	const char              * _eh_frame;
+	bool                      _initialized;
+};
+
+#ifdef LIBLOAD_ENABLE_FORMAT_ELF64
+
+	std::shared_ptr<ElfModule> load_elf_module_64(const MemoryBuffer & image_data,
+	                                              const LoadOptions  & options,
+	                                              ModuleProvider     & module_provider,
+	                                              Process            & into_process,
+	                                              LoadFailure        * failure);
+
+#endif
+
+}
+
+#endif
\ No newline at end of file
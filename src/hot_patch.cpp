@@ -0,0 +1,256 @@
+#include <config.hpp>
+#include "hot_patch.hpp"
+#include "code_chunk.hpp"
+#include "platform/code_patching.hpp"
+
+#if defined(LIBLOAD_ARCH_X86_64) && defined(LIBLOAD_ENABLE_ARCH_X86_64)
+#	include "arch/x64/instruction_relocation.hpp"
+#	define LIBLOAD_HAS_HOT_PATCH 1
+#endif
+
+#include <load/memory/memory_manager.hpp>
+#include <load/process/process.hpp>
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace load {
+
+using namespace detail;
+
+namespace {
+
+CodeArena & hot_patch_arena()
+{
+	static CodeArena code_arena;
+	return code_arena;
+}
+
+// Threads may still be running a trampoline after unhooking, so its code is never unmapped
+void retire_hot_patch(std::unique_ptr<HotPatch> hot_patch)
+{
+	static std::mutex retired_mutex;
+	static std::vector<std::unique_ptr<HotPatch>> retired_patches;
+
+	const std::lock_guard<std::mutex> lock { retired_mutex };
+	retired_patches.push_back(std::move(hot_patch));
+}
+
+#ifdef LIBLOAD_HAS_HOT_PATCH
+
+constexpr std::uintptr_t RELAY_SEARCH_RANGE = 0x40000000;
+constexpr std::uintptr_t RELAY_SEARCH_STEP  = 0x10000;
+
+void * allocate_relay_near(std::uintptr_t address, std::size_t size)
+{
+	MemoryManager & memory_manager = current_process().memory_manager();
+	const std::uintptr_t search_base = address & ~(RELAY_SEARCH_STEP - 1);
+	for (std::uintptr_t distance = RELAY_SEARCH_STEP; distance < RELAY_SEARCH_RANGE; distance += RELAY_SEARCH_STEP) {
+		for (const std::uintptr_t hint : { search_base - distance, search_base + distance }) {
+			void * relay = nullptr;
+			try {
+				relay = memory_manager.allocate(hint, size);
+			} catch (const std::system_error &) {
+				continue;
+			}
+
+			const auto relay_addr = reinterpret_cast<std::uintptr_t>(relay);
+			const std::uintptr_t relay_distance = relay_addr > address ? relay_addr - address : address - relay_addr;
+			if (relay_distance < RELAY_SEARCH_RANGE)
+				return relay;
+			memory_manager.release(relay, size);
+		}
+	}
+
+	throw std::runtime_error("No memory available near the patched function");
+}
+
+#endif
+
+}
+
+FunctionHook::FunctionHook() = default;
+
+FunctionHook::FunctionHook(std::unique_ptr<HotPatch> hot_patch)
+	: _hot_patch { std::move(hot_patch) } {}
+
+FunctionHook::FunctionHook(FunctionHook && other) noexcept = default;
+
+FunctionHook & FunctionHook::operator=(FunctionHook && other)
+{
+	if (this != &other) {
+		unhook();
+		_hot_patch = std::move(other._hot_patch);
+	}
+	return *this;
+}
+
+FunctionHook::~FunctionHook()
+{
+	try {
+		unhook();
+	} catch (...) {}
+}
+
+FunctionHook::operator bool() const
+{
+	return _hot_patch != nullptr;
+}
+
+const void * FunctionHook::original() const
+{
+	return _hot_patch ? _hot_patch->original() : nullptr;
+}
+
+void FunctionHook::unhook()
+{
+	if (!_hot_patch) return;
+
+	const bool restored = _hot_patch->restore();
+	retire_hot_patch(std::move(_hot_patch));
+	if (!restored)
+		throw std::runtime_error("Patched function entry was modified by someone else");
+}
+
+FunctionHook hook_function(void * target, const void * replacement)
+{
+	return hook_function(target, replacement, native_module_abi);
+}
+
+FunctionHook hook_function(void * target, const void * replacement, ModuleAbi target_abi)
+{
+	return FunctionHook(std::make_unique<HotPatch>(target, replacement, target_abi));
+}
+
+namespace detail {
+
+HotPatch::HotPatch(void * target, const void * replacement, ModuleAbi target_abi)
+	: _target { reinterpret_cast<std::uintptr_t>(target) }
+	, _entry_word { reinterpret_cast<std::uint64_t *>(_target & ~std::uintptr_t(7)) }
+	, _original_word { 0 }
+	, _patched_word { 0 }
+	, _trampoline { nullptr, 0 }
+	, _relay { nullptr }
+	, _original { nullptr }
+{
+#ifdef LIBLOAD_HAS_HOT_PATCH
+	const std::size_t word_offset = _target & 7;
+	if (word_offset + X64_NEAR_JUMP_SIZE > sizeof(std::uint64_t))
+		throw std::invalid_argument("Function entry can't be patched atomically");
+
+	const char * const entry = reinterpret_cast<const char *>(_target);
+	RelocatedEntry relocated_entry = relocate_x64_entry(entry, X64_NEAR_JUMP_SIZE);
+	_trampoline = hot_patch_arena().emit(*relocated_entry.code_chunk, "libload_hot_patch_trampoline");
+	_original = _trampoline.address;
+	try {
+		patch_entry(replacement, target_abi);
+	} catch (...) {
+		release_code();
+		throw;
+	}
+#else
+	throw std::logic_error("Hot patching is not supported on this architecture");
+#endif
+}
+
+#ifdef LIBLOAD_HAS_HOT_PATCH
+
+void HotPatch::patch_entry(const void * replacement, ModuleAbi target_abi)
+{
+	if (target_abi != native_module_abi) {
+		_abi_bridge = std::make_unique<AbiBridge>(target_abi, native_module_abi);
+		replacement = _abi_bridge->import_proc_thunk(replacement);
+		_original = _abi_bridge->export_thunk(_original);
+	}
+
+	MemoryManager & memory_manager = current_process().memory_manager();
+	const std::size_t page_size = memory_manager.page_size();
+
+	const std::size_t word_offset = _target & 7;
+	char patch[X64_NEAR_JUMP_SIZE];
+	const auto replacement_addr = reinterpret_cast<std::uintptr_t>(replacement);
+	if (!encode_x64_near_jump(_target, replacement_addr, patch)) {
+		_relay = allocate_relay_near(_target, page_size);
+		memory_manager.commit(_relay, page_size);
+		emit_code(*make_x64_absolute_jump(replacement_addr), memory_manager, _relay);
+		memory_manager.set_access(_relay, page_size, MemoryManager::ReadAccess | MemoryManager::ExecuteAccess);
+		encode_x64_near_jump(_target, reinterpret_cast<std::uintptr_t>(_relay), patch);
+	}
+
+	_original_word = reinterpret_cast<std::atomic<std::uint64_t> *>(_entry_word)->load();
+	std::memcpy(&_patched_word, &_original_word, sizeof(_patched_word));
+	std::memcpy(reinterpret_cast<char *>(&_patched_word) + word_offset, patch, sizeof(patch));
+	if (exchange_entry_word(_entry_word, _original_word, _patched_word) != _original_word)
+		throw std::runtime_error("Function entry changed while it was being patched");
+}
+
+#endif
+
+HotPatch::~HotPatch()
+{
+	release_code();
+}
+
+void HotPatch::release_code()
+{
+	if (_trampoline.address != nullptr)
+		hot_patch_arena().free(_trampoline);
+	if (_relay != nullptr) {
+		MemoryManager & memory_manager = current_process().memory_manager();
+		memory_manager.release(_relay, memory_manager.page_size());
+	}
+	_trampoline = { nullptr, 0 };
+	_relay = nullptr;
+}
+
+const void * HotPatch::original() const
+{
+	return _original;
+}
+
+bool HotPatch::restore()
+{
+	return exchange_entry_word(_entry_word, _patched_word, _original_word) == _patched_word;
+}
+
+std::uint64_t HotPatch::exchange_entry_word(std::uint64_t * entry_word, std::uint64_t expected,
+                                           std::uint64_t desired)
+{
+	static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+	// Hooks on the same page must not make it read-only while another one is writing to it
+	static std::mutex patch_mutex;
+	const std::lock_guard<std::mutex> lock { patch_mutex };
+
+	MemoryManager & memory_manager = current_process().memory_manager();
+	const std::size_t page_size = memory_manager.page_size();
+	const auto page = reinterpret_cast<void *>(reinterpret_cast<std::uintptr_t>(entry_word) & ~(page_size - 1));
+	const int page_access = code_page_access(page);
+
+	memory_manager.set_access(page, page_size, page_access | MemoryManager::WriteAccess);
+	auto & atomic_word = *reinterpret_cast<std::atomic<std::uint64_t> *>(entry_word);
+	atomic_word.compare_exchange_strong(expected, desired);
+	memory_manager.set_access(page, page_size, page_access);
+
+	memory_manager.flush_instruction_cache(entry_word, sizeof(*entry_word));
+	serialize_instruction_streams();
+	return expected;
+}
+
+bool is_hot_patch_supported()
+{
+#ifdef LIBLOAD_HAS_HOT_PATCH
+	return true;
+#else
+	return false;
+#endif
+}
+
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef LOAD_SRC_HOTPATCH_HPP_
+#define LOAD_SRC_HOTPATCH_HPP_
+
+#include "abi_bridge.hpp"
+#include "code_arena.hpp"
+
+#include <load/module/function_hook.hpp>
+#include <load/module/module.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace load::detail {
+
+class HotPatch
+{
+public:
+	HotPatch(void * target, const void * replacement, ModuleAbi target_abi);
+	HotPatch(const HotPatch &) = delete;
+	HotPatch & operator=(const HotPatch &) = delete;
+	~HotPatch();
+
+	const void * original() const;
+
+	// Fails when the patched bytes were overwritten by someone else
+	bool restore();
+
+private:
+	void patch_entry(const void * replacement, ModuleAbi target_abi);
+	void release_code();
+
+	static std::uint64_t exchange_entry_word(std::uint64_t * entry_word, std::uint64_t expected,
+	                                         std::uint64_t desired);
+
+	std::uintptr_t             _target;
+	std::uint64_t            * _entry_word;
+	std::uint64_t              _original_word;
+	std::uint64_t              _patched_word;
+	std::unique_ptr<AbiBridge> _abi_bridge;
+	CodeStub                   _trampoline;
+	void                     * _relay;
+	const void               * _original;
+};
+
+bool is_hot_patch_supported();
+
+}
+
+#endif
\ No newline at end of file
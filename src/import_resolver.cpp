@@ -0,0 +1,41 @@
+#include <load/module/import_resolver.hpp>
+
+#include <algorithm>
+#include <cctype>
+
+namespace load {
+
+namespace {
+
+std::string lowercase_module_name(std::string_view module_name)
+{
+	std::string lowercase_name { module_name };
+	std::transform(lowercase_name.begin(), lowercase_name.end(), lowercase_name.begin(),
+	               [] (unsigned char c) { return char(std::tolower(c)); });
+	return lowercase_name;
+}
+
+}
+
+void ImportOverrides::add(std::string_view symbol_name, const void * address)
+{
+	_overrides.insert_or_assign(override_key(std::string(), symbol_name), address);
+}
+
+void ImportOverrides::add(std::string_view module_name, std::string_view symbol_name, const void * address)
+{
+	_overrides.insert_or_assign(override_key(lowercase_module_name(module_name), symbol_name), address);
+}
+
+const void * ImportOverrides::resolve_import(std::string_view module_name,
+                                             std::string_view symbol_name,
+                                             const void     * default_address)
+{
+	auto override_it = _overrides.find(override_key(lowercase_module_name(module_name), symbol_name));
+	if (override_it == _overrides.end())
+		override_it = _overrides.find(override_key(std::string(), symbol_name));
+
+	return override_it != _overrides.end() ? override_it->second : default_address;
+}
+
+}
\ No newline at end of file
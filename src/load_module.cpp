@@ -1,29 +1,59 @@
-#include <config.hpp>
 #include <load/module/load_module.hpp>
-
-#if defined(LIBLOAD_ENABLE_FORMAT_PE64) || defined(LIBLOAD_ENABLE_FORMAT_PE32)
-#	include "pe/module.hpp"
-#endif
+#include <load/module/module_format.hpp>
 
 namespace load {
 
-using namespace detail;
+namespace {
+
+LoadError format_load_error(ModuleFormatError error)
+{
+	switch (error) {
+		case ModuleFormatError::None:               return LoadError::None;
+		case ModuleFormatError::UnknownFormat:      return LoadError::UnknownFormat;
+		case ModuleFormatError::TruncatedHeaders:   return LoadError::TruncatedHeaders;
+		case ModuleFormatError::UnsupportedImage:   return LoadError::UnsupportedImage;
+		case ModuleFormatError::UnsupportedMachine: return LoadError::UnsupportedMachine;
+	}
+
+	return LoadError::UnknownFormat;
+}
+
+}
 
 std::shared_ptr<Module> load_module(const MemoryBuffer & module_data,
                                     ModuleProvider     & module_provider,
                                     Process            & into_process)
 {
-#ifdef LIBLOAD_ENABLE_FORMAT_PE64
-	if (is_valid_pe_module_64(module_data))
-		return load_pe_module_64(module_data, module_provider, into_process);
-#endif
+	return load_module(module_data, LoadOptions(), module_provider, into_process);
+}
 
-#ifdef LIBLOAD_ENABLE_FORMAT_PE32
-	if (is_valid_pe_module_32(module_data))
-		return load_pe_module_32(module_data, module_provider, into_process);
-#endif
+std::shared_ptr<Module> load_module(const MemoryBuffer & module_data,
+                                    const LoadOptions  & options,
+                                    ModuleProvider     & module_provider,
+                                    Process            & into_process)
+{
+	const ModuleFormatMatch match = detect_module_format(module_data);
+	if (!match) return nullptr;
+
+	return match.format->load(module_data, options, module_provider, into_process);
+}
+
+LoadResult try_load_module(const MemoryBuffer & module_data,
+                           ModuleProvider     & module_provider,
+                           Process            & into_process)
+{
+	return try_load_module(module_data, LoadOptions(), module_provider, into_process);
+}
+
+LoadResult try_load_module(const MemoryBuffer & module_data,
+                           const LoadOptions  & options,
+                           ModuleProvider     & module_provider,
+                           Process            & into_process)
+{
+	const ModuleFormatMatch match = detect_module_format(module_data);
+	if (!match) return LoadFailure(format_load_error(match.error));
 
-	return nullptr;
+	return match.format->try_load(module_data, options, module_provider, into_process);
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "load_observer.hpp"
+
+#include <load/module/load_observer.hpp>
+#include <load/process/process.hpp>
+
+#include <functional>
+#include <ostream>
+#include <thread>
+
+namespace load {
+
+namespace {
+
+void write_json_string(std::ostream & stream, std::string_view str)
+{
+	stream << '"';
+	for (const char c : str) {
+		switch (c) {
+			case '"':  stream << "\\\""; break;
+			case '\\': stream << "\\\\"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20)
+					stream << ' ';
+				else
+					stream << c;
+		}
+	}
+	stream << '"';
+}
+
+}
+
+std::string_view load_phase_name(LoadPhase phase)
+{
+	switch (phase) {
+		case LoadPhase::CopyHeaders:      return "copy_headers";
+		case LoadPhase::MapSections:      return "map_sections";
+		case LoadPhase::ApplyRelocations: return "apply_relocations";
+		case LoadPhase::ResolveImports:   return "resolve_imports";
+		case LoadPhase::ApplyPermissions: return "apply_permissions";
+		case LoadPhase::DiscardSections:  return "discard_sections";
+		case LoadPhase::Initialize:       return "initialize";
+	}
+
+	return "unknown";
+}
+
+ChromeTraceObserver::ChromeTraceObserver(std::ostream & trace_stream)
+	: _trace_stream { &trace_stream }
+	, _start_time { std::chrono::steady_clock::now() }
+	, _first_event { true }
+{
+	*_trace_stream << "{\"traceEvents\":[";
+}
+
+ChromeTraceObserver::~ChromeTraceObserver()
+{
+	*_trace_stream << "\n]}\n";
+	_trace_stream->flush();
+}
+
+void ChromeTraceObserver::phase_begin(LoadPhase phase)
+{
+	begin_event('B', load_phase_name(phase), "load");
+	*_trace_stream << '}';
+}
+
+void ChromeTraceObserver::phase_end(LoadPhase phase, const LoadPhaseStats & stats)
+{
+	begin_event('E', load_phase_name(phase), "load");
+	*_trace_stream << ",\"args\":{"
+	               << "\"bytes\":" << stats.bytes
+	               << ",\"relocations\":" << stats.relocations
+	               << ",\"imports\":" << stats.imports
+	               << ",\"minor_faults\":" << stats.minor_faults
+	               << ",\"major_faults\":" << stats.major_faults
+	               << "}}";
+}
+
+void ChromeTraceObserver::dependency_begin(std::string_view name)
+{
+	begin_event('B', name, "dependency");
+	*_trace_stream << '}';
+}
+
+void ChromeTraceObserver::dependency_end(std::string_view name, bool resolved)
+{
+	begin_event('E', name, "dependency");
+	*_trace_stream << ",\"args\":{\"resolved\":" << (resolved ? "true" : "false") << "}}";
+}
+
+void ChromeTraceObserver::begin_event(char type, std::string_view name, std::string_view category)
+{
+	using namespace std::chrono;
+
+	const auto timestamp = duration_cast<microseconds>(steady_clock::now() - _start_time);
+	const auto thread_id = std::hash<std::thread::id>()(std::this_thread::get_id());
+
+	*_trace_stream << (_first_event ? "\n" : ",\n") << "{\"name\":";
+	write_json_string(*_trace_stream, name);
+	*_trace_stream << ",\"cat\":\"" << category << "\",\"ph\":\"" << type << '"'
+	               << ",\"ts\":" << timestamp.count()
+	               << ",\"pid\":" << current_process().process_id()
+	               << ",\"tid\":" << thread_id;
+	_first_event = false;
+}
+
+namespace detail {
+
+LoadPhaseState & load_phase_state()
+{
+	thread_local LoadPhaseState phase_state;
+	return phase_state;
+}
+
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#ifndef LOAD_SRC_LOADOBSERVER_HPP_
+#define LOAD_SRC_LOADOBSERVER_HPP_
+
+#include "platform/page_faults.hpp"
+
+#include <load/module/load_observer.hpp>
+
+#include <exception>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+namespace load::detail {
+
+// The phase this thread runs, and the innermost phase that an exception left; load failures record them
+struct LoadPhaseState
+{
+	std::optional<LoadPhase> current;
+	std::optional<LoadPhase> unwound;
+};
+
+LoadPhaseState & load_phase_state();
+
+class LoadPhaseScope
+{
+public:
+	LoadPhaseScope(LoadObserver * observer, LoadPhase phase);
+	~LoadPhaseScope();
+
+	LoadPhaseScope(const LoadPhaseScope &) = delete;
+	LoadPhaseScope & operator=(const LoadPhaseScope &) = delete;
+
+	LoadPhaseStats stats;
+
+private:
+	LoadObserver           * _observer;
+	LoadPhase                _phase;
+	std::optional<LoadPhase> _outer_phase;
+	int                      _uncaught_exceptions;
+	PageFaultCount           _start_faults;
+};
+
+class DependencyScope
+{
+public:
+	DependencyScope(LoadObserver * observer, std::string_view name);
+	~DependencyScope();
+
+	DependencyScope(const DependencyScope &) = delete;
+	DependencyScope & operator=(const DependencyScope &) = delete;
+
+	bool resolved = false;
+
+private:
+	LoadObserver   * _observer;
+	std::string_view _name;
+};
+
+inline LoadPhaseScope::LoadPhaseScope(LoadObserver * observer, LoadPhase phase)
+	: _observer { observer }, _phase { phase }
+	, _outer_phase { std::exchange(load_phase_state().current, phase) }
+	, _uncaught_exceptions { std::uncaught_exceptions() }
+{
+	if (_observer != nullptr) {
+		_observer->phase_begin(_phase);
+		_start_faults = current_page_fault_count();
+	}
+}
+
+inline LoadPhaseScope::~LoadPhaseScope()
+{
+	LoadPhaseState & phase_state = load_phase_state();
+	if (std::uncaught_exceptions() > _uncaught_exceptions && !phase_state.unwound)
+		phase_state.unwound = _phase;
+	phase_state.current = _outer_phase;
+
+	if (_observer != nullptr) {
+		const PageFaultCount end_faults = current_page_fault_count();
+		stats.minor_faults = end_faults.minor_faults - _start_faults.minor_faults;
+		stats.major_faults = end_faults.major_faults - _start_faults.major_faults;
+		_observer->phase_end(_phase, stats);
+	}
+}
+
+inline DependencyScope::DependencyScope(LoadObserver * observer, std::string_view name)
+	: _observer { observer }, _name { name }
+{
+	if (_observer != nullptr)
+		_observer->dependency_begin(_name);
+}
+
+inline DependencyScope::~DependencyScope()
+{
+	if (_observer != nullptr)
+		_observer->dependency_end(_name, resolved);
+}
+
+}
+
+#endif
\ No newline at end of file
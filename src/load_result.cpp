@@ -0,0 +1,82 @@
+#include "load_result.hpp"
+
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+namespace load {
+
+std::string_view load_error_name(LoadError error)
+{
+	switch (error) {
+		case LoadError::None:                 return "none";
+		case LoadError::UnknownFormat:        return "unknown_format";
+		case LoadError::TruncatedHeaders:     return "truncated_headers";
+		case LoadError::UnsupportedImage:     return "unsupported_image";
+		case LoadError::UnsupportedMachine:   return "unsupported_machine";
+		case LoadError::MalformedImage:       return "malformed_image";
+		case LoadError::UnsupportedFeature:   return "unsupported_feature";
+		case LoadError::UnsupportedOptions:   return "unsupported_options";
+		case LoadError::MissingModule:        return "missing_module";
+		case LoadError::MissingSymbol:        return "missing_symbol";
+		case LoadError::InitializationFailed: return "initialization_failed";
+		case LoadError::OutOfMemory:          return "out_of_memory";
+		case LoadError::SystemError:          return "system_error";
+	}
+
+	return "unknown";
+}
+
+namespace detail {
+
+LoadError report_load_failure(LoadFailure    * failure,
+                              LoadError        error,
+                              const char     * message,
+                              std::string_view module_name,
+                              std::string_view symbol_name)
+{
+	if (failure != nullptr) {
+		failure->error = error;
+		failure->module_name = module_name;
+		failure->symbol_name = symbol_name;
+		failure->message = message;
+		failure->phase = load_phase_state().current;
+	}
+	return error;
+}
+
+void throw_load_failure(const LoadFailure & failure)
+{
+	throw std::runtime_error(failure.message);
+}
+
+LoadFailure current_load_failure()
+{
+	const auto make_failure = [] (LoadError error, const std::exception & ex) {
+		LoadFailure failure { error };
+		failure.message = ex.what();
+		failure.phase = std::exchange(load_phase_state().unwound, std::nullopt);
+		return failure;
+	};
+
+	try {
+		throw;
+	} catch (const std::bad_alloc & ex) {
+		return make_failure(LoadError::OutOfMemory, ex);
+	} catch (const std::system_error & ex) {
+		return make_failure(LoadError::SystemError, ex);
+	} catch (const std::logic_error & ex) {
+		return make_failure(LoadError::UnsupportedOptions, ex);
+	} catch (const std::runtime_error & ex) {
+		return make_failure(LoadError::MalformedImage, ex);
+	} catch (const std::exception & ex) {
+		return make_failure(LoadError::SystemError, ex);
+	}
+}
+
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#ifndef LOAD_SRC_LOADRESULT_HPP_
+#define LOAD_SRC_LOADRESULT_HPP_
+
+#include "load_observer.hpp"
+
+#include <load/module/load_result.hpp>
+
+#include <memory>
+#include <string_view>
+#include <utility>
+
+namespace load::detail {
+
+inline bool has_load_failure(const LoadFailure * failure)
+{
+	return failure != nullptr && failure->error != LoadError::None;
+}
+
+// Records the failure with the phase being run and returns its error; the caller then abandons the load
+LoadError report_load_failure(LoadFailure    * failure,
+                              LoadError        error,
+                              const char     * message,
+                              std::string_view module_name = {},
+                              std::string_view symbol_name = {});
+
+// Throws a reported failure as a runtime_error with its message, for the loads that throw
+[[noreturn]] void throw_load_failure(const LoadFailure & failure);
+
+// Translates the exception being handled; exceptions that are not std::exceptions are rethrown
+LoadFailure current_load_failure();
+
+template <class LoadFunction>
+auto load_or_throw(LoadFunction && load)
+{
+	LoadFailure failure;
+	auto module = load(&failure);
+	if (has_load_failure(&failure))
+		throw_load_failure(failure);
+	return module;
+}
+
+template <class LoadFunction>
+LoadResult catch_load_failure(LoadFunction && load)
+{
+	LoadFailure failure;
+	load_phase_state().unwound.reset();
+	try {
+		if (std::shared_ptr<Module> module = load(&failure))
+			return module;
+	} catch (...) {
+		return current_load_failure();
+	}
+
+	if (failure.error == LoadError::None)
+		failure.error = LoadError::UnsupportedImage;
+	return failure;
+}
+
+}
+
+#endif
\ No newline at end of file
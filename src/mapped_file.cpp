@@ -14,4 +14,14 @@ std::size_t MappedFile::read(std::size_t offset, std::size_t size, void * into_b
 	return bytes_to_read;
 }
 
+const char * MappedFile::contiguous_data() const
+{
+	return _mm_file.data();
+}
+
+std::size_t MappedFile::contiguous_size() const
+{
+	return _mm_file.size();
+}
+
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include <boost/endian/conversion.hpp>
 
 #include <algorithm>
+#include <cstring>
 #include <functional>
 #include <stdexcept>
 #include <type_traits>
@@ -25,6 +26,27 @@ struct any_buffer
 	}
 };
 
+struct MemorySpan
+{
+	const char  * data;
+	std::size_t   size;
+};
+
+struct span_buffer
+{
+	using value_type = MemorySpan;
+
+	static std::size_t read(MemorySpan from_span,
+	                        std::size_t offset, std::size_t size,
+	                        void * into_buffer)
+	{
+		if (offset >= from_span.size) return 0;
+		const std::size_t bytes_to_read = std::min(from_span.size - offset, size);
+		std::memcpy(into_buffer, from_span.data + offset, bytes_to_read);
+		return bytes_to_read;
+	}
+};
+
 struct owned_memory
 {
 	static void dispose(MemoryManager & mem_manager,
@@ -94,19 +116,18 @@ BorrowedMemoryBlock get_memory_block_slice(MemoryBlock & mem_block,
                                            std::size_t   offset,
                                            std::size_t   size)
 {
-	if (offset + size >= mem_block.size())
+	if (offset + size > mem_block.size())
 		throw std::out_of_range("Memory range not withing block");
 	
 	MemoryManager & mem_manager = mem_block.memory_manager();
 	const std::size_t slice_size = std::min(size, mem_block.size() - offset);
-	return BorrowedMemoryBlock(mem_manager, mem_block.data(), slice_size);
+	return BorrowedMemoryBlock(mem_manager, mem_block.data() + offset, slice_size);
 }
 
 template <class MemoryBlock>
-OwnedMemoryBlock copy_into_local_memory(const MemoryBlock & mem_block)
+OwnedMemoryBlock copy_into_local_memory(const MemoryBlock & mem_block, MemoryManager & mem_manager)
 {
 	const std::size_t mem_size = mem_block.size();
-	MemoryManager & mem_manager = current_process().memory_manager();
 	OwnedMemoryBlock mem_copy { mem_manager, mem_manager.allocate(0, mem_size), mem_size };
 	mem_block.read(0, mem_size, mem_copy.data());
 	return mem_copy;
@@ -120,6 +141,14 @@ T read_le_value_from(const MemoryBuffer & mem_buffer, std::size_t offset)
 	return boost::endian::little_to_native(value);
 }
 
+template <typename T, typename = std::enable_if_t<std::is_trivial_v<T>>>
+T read_le_value_from(const char * mem_ptr, std::size_t offset)
+{
+	T value;
+	std::memcpy(&value, mem_ptr + offset, sizeof(T));
+	return boost::endian::little_to_native(value);
+}
+
 template <typename T, typename = std::enable_if_t<std::is_trivial_v<T>>>
 void write_le_value_into(T value, MutableMemoryBuffer & mem_buffer, std::size_t offset)
 {
@@ -127,8 +156,15 @@ void write_le_value_into(T value, MutableMemoryBuffer & mem_buffer, std::size_t
 	mem_buffer.write(offset, &value, sizeof(T));
 }
 
-template <typename T, typename Fn, typename = std::enable_if_t<std::is_trivial_v<T>>>
-void modify_le_value_at(MutableMemoryBuffer & mem_buffer, std::size_t offset, Fn && fn)
+template <typename T, typename = std::enable_if_t<std::is_trivial_v<T>>>
+void write_le_value_into(T value, char * mem_ptr, std::size_t offset)
+{
+	boost::endian::native_to_little_inplace(value);
+	std::memcpy(mem_ptr + offset, &value, sizeof(T));
+}
+
+template <typename T, typename MemBuffer, typename Fn, typename = std::enable_if_t<std::is_trivial_v<T>>>
+void modify_le_value_at(MemBuffer & mem_buffer, std::size_t offset, Fn && fn)
 {
 	T value = read_le_value_from<T>(mem_buffer, offset);
 	value = std::invoke<Fn>(std::forward<Fn>(fn), value);
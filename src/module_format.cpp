@@ -0,0 +1,119 @@
+#include "module_format.hpp"
+#include "load_result.hpp"
+
+#include <load/memory/memory_buffer.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+
+namespace load {
+
+using namespace detail;
+
+void register_module_format(const ModuleFormat & format)
+{
+	module_format_registry().add(format);
+}
+
+void unregister_module_format(const ModuleFormat & format)
+{
+	module_format_registry().remove(format);
+}
+
+ModuleFormatMatch detect_module_format(const MemoryBuffer & module_data)
+{
+	if (const char * const data = module_data.contiguous_data()) {
+		const std::size_t header_size = std::min(module_data.contiguous_size(), ModuleFormat::HEADER_PAGE_SIZE);
+		return module_format_registry().detect(data, header_size);
+	}
+
+	char header[ModuleFormat::HEADER_PAGE_SIZE];
+	const std::size_t header_size = module_data.read(0, sizeof(header), header);
+	return module_format_registry().detect(header, header_size);
+}
+
+LoadResult ModuleFormat::try_load(const MemoryBuffer & module_data,
+                                  const LoadOptions  & options,
+                                  ModuleProvider     & module_provider,
+                                  Process            & into_process) const
+{
+	return catch_load_failure([&] (LoadFailure *) {
+		return load(module_data, options, module_provider, into_process);
+	});
+}
+
+std::string_view module_format_error_name(ModuleFormatError error)
+{
+	switch (error) {
+		case ModuleFormatError::None:               return "none";
+		case ModuleFormatError::UnknownFormat:      return "unknown_format";
+		case ModuleFormatError::TruncatedHeaders:   return "truncated_headers";
+		case ModuleFormatError::UnsupportedImage:   return "unsupported_image";
+		case ModuleFormatError::UnsupportedMachine: return "unsupported_machine";
+	}
+
+	return "unknown";
+}
+
+namespace detail {
+
+ModuleFormatRegistry & module_format_registry()
+{
+	static ModuleFormatRegistry registry;
+	return registry;
+}
+
+ModuleFormatRegistry::ModuleFormatRegistry()
+{
+#ifdef LIBLOAD_ENABLE_FORMAT_PE64
+	_formats.push_back(&pe64_module_format());
+#endif
+#ifdef LIBLOAD_ENABLE_FORMAT_PE32
+	_formats.push_back(&pe32_module_format());
+#endif
+#ifdef LIBLOAD_ENABLE_FORMAT_ELF64
+	_formats.push_back(&elf64_module_format());
+#endif
+}
+
+void ModuleFormatRegistry::add(const ModuleFormat & format)
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+	if (std::find(_formats.begin(), _formats.end(), &format) != _formats.end())
+		throw std::invalid_argument("Module format is already registered");
+	_formats.push_back(&format);
+}
+
+void ModuleFormatRegistry::remove(const ModuleFormat & format)
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+	_formats.erase(std::remove(_formats.begin(), _formats.end(), &format), _formats.end());
+}
+
+ModuleFormatMatch ModuleFormatRegistry::detect(const char * header, std::size_t header_size) const
+{
+	const std::string_view header_bytes { header, header_size };
+	ModuleFormatMatch match;
+
+	// Probes run unlocked, so a slow probe does not hold up registrations or other detections
+	std::vector<const ModuleFormat *> formats;
+	{
+		const std::lock_guard<std::mutex> lock { _mutex };
+		formats = _formats;
+	}
+
+	for (const ModuleFormat * const format : formats) {
+		const std::string_view magic = format->magic();
+		if (header_bytes.substr(0, magic.size()) != magic) continue;
+
+		const ModuleFormatError error = format->probe(header, header_size);
+		if (error == ModuleFormatError::None) return { format, error };
+		match.error = std::max(match.error, error);
+	}
+	return match;
+}
+
+}
+
+}
\ No newline at end of file
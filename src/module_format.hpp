@@ -0,0 +1,46 @@
+#ifndef LOAD_SRC_MODULEFORMAT_HPP_
+#define LOAD_SRC_MODULEFORMAT_HPP_
+
+#include <config.hpp>
+#include <load/module/module_format.hpp>
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace load::detail {
+
+class ModuleFormatRegistry
+{
+public:
+	ModuleFormatRegistry();
+	ModuleFormatRegistry(const ModuleFormatRegistry &) = delete;
+	ModuleFormatRegistry & operator=(const ModuleFormatRegistry &) = delete;
+
+	void add(const ModuleFormat & format);
+	void remove(const ModuleFormat & format);
+
+	ModuleFormatMatch detect(const char * header, std::size_t header_size) const;
+
+private:
+	mutable std::mutex                _mutex;
+	std::vector<const ModuleFormat *> _formats;
+};
+
+ModuleFormatRegistry & module_format_registry();
+
+#ifdef LIBLOAD_ENABLE_FORMAT_PE64
+	const ModuleFormat & pe64_module_format();
+#endif
+
+#ifdef LIBLOAD_ENABLE_FORMAT_PE32
+	const ModuleFormat & pe32_module_format();
+#endif
+
+#ifdef LIBLOAD_ENABLE_FORMAT_ELF64
+	const ModuleFormat & elf64_module_format();
+#endif
+
+}
+
+#endif
\ No newline at end of file
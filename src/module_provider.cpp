@@ -17,4 +17,15 @@ std::shared_ptr<Module> ModuleCache::get_module(std::string_view name)
 	return module_sp;
 }
 
+std::size_t ModuleCache::memory_footprint() const
+{
+	using module_node = module_map::value_type;
+
+	std::size_t footprint = sizeof(*this);
+	footprint += _module_entries.bucket_count() * sizeof(void *);
+	for (const auto & [name, module_sp] : _module_entries)
+		footprint += sizeof(module_node) + sizeof(void *) + name.capacity();
+	return footprint;
+}
+
 }
\ No newline at end of file
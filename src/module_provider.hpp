@@ -30,6 +30,8 @@ public:
 
 	virtual std::shared_ptr<Module> get_module(std::string_view name) override;
 
+	std::size_t memory_footprint() const;
+
 private:
 	using module_map = std::unordered_map<std::string, std::shared_ptr<Module>>;
 
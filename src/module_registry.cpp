@@ -0,0 +1,209 @@
+#include "module_registry.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+namespace load {
+
+using namespace detail;
+
+bool find_module_range(std::uintptr_t address, ModuleRange & range)
+{
+	return module_registry().find(address, range);
+}
+
+const RuntimeFunction * find_runtime_function(std::uintptr_t address)
+{
+	return module_registry().find_runtime_function(address);
+}
+
+int iterate_module_ranges(ModuleRangeCallback callback, void * data)
+{
+	return module_registry().iterate(callback, data);
+}
+
+void add_module_event_listener(ModuleEventListener listener, void * data)
+{
+	module_registry().add_listener(listener, data);
+}
+
+void remove_module_event_listener(ModuleEventListener listener, void * data)
+{
+	module_registry().remove_listener(listener, data);
+}
+
+namespace detail {
+
+ModuleRegistry & module_registry()
+{
+	static ModuleRegistry registry;
+	return registry;
+}
+
+ModuleRegistry::ReadGuard::ReadGuard(const ModuleRegistry & registry)
+	: _registry { &registry }
+{
+	_registry->_active_readers.fetch_add(1);
+	_snapshot = _registry->_snapshot.load();
+}
+
+ModuleRegistry::ReadGuard::~ReadGuard()
+{
+	_registry->_active_readers.fetch_sub(1);
+}
+
+ModuleRegistry::~ModuleRegistry()
+{
+	delete _snapshot.load();
+	for (Snapshot * const snapshot : _retired)
+		delete snapshot;
+}
+
+void ModuleRegistry::add(const ModuleRange & range)
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+
+	const Snapshot * const snapshot = _snapshot.load();
+	std::vector<ModuleRange> ranges;
+	if (snapshot != nullptr) ranges = snapshot->ranges;
+
+	const auto range_it = std::lower_bound(ranges.begin(), ranges.end(), range.base_address,
+		[] (const ModuleRange & lhs, std::uintptr_t base) { return lhs.base_address < base; });
+	if (range_it != ranges.end() && range_it->base_address < range.base_address + range.size)
+		throw std::invalid_argument("Module range overlaps a registered module");
+	if (range_it != ranges.begin() && std::prev(range_it)->base_address + std::prev(range_it)->size > range.base_address)
+		throw std::invalid_argument("Module range overlaps a registered module");
+
+	ranges.insert(range_it, range);
+	publish(std::move(ranges), false);
+	notify(ModuleEvent::Loaded, range);
+}
+
+void ModuleRegistry::remove(std::uintptr_t base_address)
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+
+	const Snapshot * const snapshot = _snapshot.load();
+	if (snapshot == nullptr) return;
+
+	std::vector<ModuleRange> ranges = snapshot->ranges;
+	const auto range_it = std::find_if(ranges.begin(), ranges.end(),
+		[=] (const ModuleRange & range) { return range.base_address == base_address; });
+	if (range_it == ranges.end()) return;
+
+	notify(ModuleEvent::Unloaded, *range_it);
+	ranges.erase(range_it);
+	publish(std::move(ranges), true);
+}
+
+void ModuleRegistry::set_module(std::uintptr_t base_address, const Module * module)
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+
+	const Snapshot * const snapshot = _snapshot.load();
+	if (snapshot == nullptr) return;
+
+	std::vector<ModuleRange> ranges = snapshot->ranges;
+	const auto range_it = std::find_if(ranges.begin(), ranges.end(),
+		[=] (const ModuleRange & range) { return range.base_address == base_address; });
+	if (range_it == ranges.end()) return;
+
+	range_it->module = module;
+	publish(std::move(ranges), false);
+}
+
+bool ModuleRegistry::find(std::uintptr_t address, ModuleRange & range) const
+{
+	const ReadGuard read_guard { *this };
+	const ModuleRange * const found_range = find_range(read_guard.snapshot(), address);
+	if (found_range == nullptr) return false;
+
+	range = *found_range;
+	return true;
+}
+
+const RuntimeFunction * ModuleRegistry::find_runtime_function(std::uintptr_t address) const
+{
+	const ReadGuard read_guard { *this };
+	const ModuleRange * const range = find_range(read_guard.snapshot(), address);
+	if (range == nullptr || range->runtime_functions == nullptr) return nullptr;
+
+	const auto rva = static_cast<std::uint32_t>(address - range->base_address);
+	const RuntimeFunction * const rfs_begin = range->runtime_functions;
+	const RuntimeFunction * const rfs_end = rfs_begin + range->runtime_function_count;
+	const RuntimeFunction * const rf = std::upper_bound(rfs_begin, rfs_end, rva,
+		[] (std::uint32_t rva, const RuntimeFunction & rf) { return rva < rf.begin_address; });
+	if (rf == rfs_begin) return nullptr;
+
+	const RuntimeFunction * const candidate = std::prev(rf);
+	return rva < candidate->end_address ? candidate : nullptr;
+}
+
+int ModuleRegistry::iterate(ModuleRangeCallback callback, void * data) const
+{
+	const ReadGuard read_guard { *this };
+	if (read_guard.snapshot() == nullptr) return 0;
+
+	for (const ModuleRange & range : read_guard.snapshot()->ranges) {
+		if (const int result = callback(range, data))
+			return result;
+	}
+	return 0;
+}
+
+void ModuleRegistry::add_listener(ModuleEventListener listener, void * data)
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+	_listeners.emplace_back(listener, data);
+}
+
+void ModuleRegistry::remove_listener(ModuleEventListener listener, void * data)
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+	const auto listener_it = std::find(_listeners.begin(), _listeners.end(), Listener(listener, data));
+	if (listener_it != _listeners.end())
+		_listeners.erase(listener_it);
+}
+
+const ModuleRange * ModuleRegistry::find_range(const Snapshot * snapshot, std::uintptr_t address)
+{
+	if (snapshot == nullptr) return nullptr;
+
+	const auto & ranges = snapshot->ranges;
+	const auto range_it = std::upper_bound(ranges.begin(), ranges.end(), address,
+		[] (std::uintptr_t address, const ModuleRange & range) { return address < range.base_address; });
+	if (range_it == ranges.begin()) return nullptr;
+
+	const ModuleRange & range = *std::prev(range_it);
+	return address - range.base_address < range.size ? &range : nullptr;
+}
+
+void ModuleRegistry::publish(std::vector<ModuleRange> ranges, bool wait_for_readers)
+{
+	Snapshot * const old_snapshot = _snapshot.exchange(new Snapshot { std::move(ranges) });
+	if (old_snapshot != nullptr)
+		_retired.push_back(old_snapshot);
+
+	// Readers that arrive after the exchange can only observe the new snapshot
+	if (wait_for_readers) {
+		while (_active_readers.load() != 0)
+			std::this_thread::yield();
+	} else if (_active_readers.load() != 0) {
+		return;
+	}
+
+	for (Snapshot * const snapshot : _retired)
+		delete snapshot;
+	_retired.clear();
+}
+
+void ModuleRegistry::notify(ModuleEvent event, const ModuleRange & range)
+{
+	for (const auto & [listener, data] : _listeners)
+		listener(event, range, data);
+}
+
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#ifndef LOAD_SRC_MODULEREGISTRY_HPP_
+#define LOAD_SRC_MODULEREGISTRY_HPP_
+
+#include <load/module/module_registry.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace load::detail {
+
+class ModuleRegistry
+{
+public:
+	ModuleRegistry() = default;
+	ModuleRegistry(const ModuleRegistry &) = delete;
+	ModuleRegistry & operator=(const ModuleRegistry &) = delete;
+	~ModuleRegistry();
+
+	void add(const ModuleRange & range);
+	void remove(std::uintptr_t base_address);
+	// Hands a range over to a module that was moved, without unload and load events
+	void set_module(std::uintptr_t base_address, const Module * module);
+
+	bool find(std::uintptr_t address, ModuleRange & range) const;
+	const RuntimeFunction * find_runtime_function(std::uintptr_t address) const;
+	int iterate(ModuleRangeCallback callback, void * data) const;
+
+	void add_listener(ModuleEventListener listener, void * data);
+	void remove_listener(ModuleEventListener listener, void * data);
+
+private:
+	struct Snapshot
+	{
+		std::vector<ModuleRange> ranges;
+	};
+
+	class ReadGuard
+	{
+	public:
+		explicit ReadGuard(const ModuleRegistry & registry);
+		~ReadGuard();
+
+		const Snapshot * snapshot() const { return _snapshot; }
+
+	private:
+		const ModuleRegistry * _registry;
+		const Snapshot       * _snapshot;
+	};
+
+	static const ModuleRange * find_range(const Snapshot * snapshot, std::uintptr_t address);
+
+	void publish(std::vector<ModuleRange> ranges, bool wait_for_readers);
+	void notify(ModuleEvent event, const ModuleRange & range);
+
+	using Listener = std::pair<ModuleEventListener, void *>;
+
+	std::mutex                        _mutex;
+	std::atomic<Snapshot *>           _snapshot { nullptr };
+	mutable std::atomic<unsigned int> _active_readers { 0 };
+	std::vector<Snapshot *>           _retired;
+	std::vector<Listener>             _listeners;
+};
+
+ModuleRegistry & module_registry();
+
+}
+
+#endif
\ No newline at end of file
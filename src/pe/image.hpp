@@ -1,21 +1,45 @@
 #ifndef LOAD_SRC_PE_IMAGE_HPP_
 #define LOAD_SRC_PE_IMAGE_HPP_
 
+#include "image_layout.hpp"
+#include "image_tables.hpp"
+#include "../abi_bridge.hpp"
+#include "../call_counters.hpp"
+#include "../code_chunk.hpp"
+#include "../load_observer.hpp"
+#include "../load_result.hpp"
 #include "../memory_block.hpp"
+#include "../perf_map.hpp"
+#include "../remote_call_batch.hpp"
+#include "../tls_registry.hpp"
 
 #include <load/codegen/code_chunk.hpp>
 #include <load/codegen/code_generator.hpp>
+#include <load/module/import_resolver.hpp>
+#include <load/module/memory_stats.hpp>
 #include <load/module/module.hpp>
 #include <load/module/module_provider.hpp>
+#include <load/module/module_registry.hpp>
 #include <load/process/process.hpp>
 
 #include <peplus/file_image.hpp>
 #include <peplus/virtual_image.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <map>
+#include <sstream>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace load::detail {
 
@@ -32,52 +56,57 @@ using HINSTANCE = void *;
 using DllMain = bool (__stdcall *)(HINSTANCE, DWORD, void *);
 using TlsCallback = void (__stdcall *)(HINSTANCE, DWORD, void *);
 
-template <class PEImage>
-OwnedMemoryBlock allocate_pe_image(const PEImage & image, MemoryManager & memory_manager)
+inline OwnedMemoryBlock allocate_pe_image(const ImageLayout & layout, MemoryManager & memory_manager)
 {
-	const auto opt_header = image.optional_header();
-	const std::size_t image_size = opt_header.size_of_image;
-	const std::uintptr_t image_base = opt_header.image_base;
+	const std::size_t image_size = layout.image_size;
+	const auto image_base = static_cast<std::uintptr_t>(layout.image_base);
 
 	void * const image_mem = memory_manager.allocate(image_base, image_size);
 	return OwnedMemoryBlock(memory_manager, image_mem, image_size);
 }
 
 template <class PEFileImage, class MemoryBlock>
-void copy_pe_image_headers_indirect(const PEFileImage & image, MemoryBlock & into_memory)
+std::size_t copy_pe_image_headers_indirect(const PEFileImage  & image,
+                                           const ImageLayout  & layout,
+                                           MemoryBlock        & into_memory)
 {
 	using namespace peplus::literals::offset_literals;
 
-	const auto opt_header = image.optional_header();
-	std::vector<char> hdrdata_buf (opt_header.size_of_headers);
+	std::vector<char> hdrdata_buf (layout.headers_size);
 	image.read(0_offs, hdrdata_buf.size(), hdrdata_buf.data());
 
 	into_memory.memory_manager().commit(into_memory.data(), hdrdata_buf.size());
 	into_memory.write(0, hdrdata_buf.data(), hdrdata_buf.size());
+	return hdrdata_buf.size();
 }
 
 template <class PEFileImage, class MemoryBlock>
-void copy_pe_image_headers_direct(const PEFileImage & image, MemoryBlock & into_memory)
+std::size_t copy_pe_image_headers_direct(const PEFileImage  & image,
+                                         const ImageLayout  & layout,
+                                         MemoryBlock        & into_memory)
 {
 	using namespace peplus::literals::offset_literals;
 
 	assert(into_memory.memory_manager().allows_direct_addressing());
 
-	const auto opt_header = image.optional_header();
-	const std::size_t hdrs_size = opt_header.size_of_headers;
+	const std::size_t hdrs_size = layout.headers_size;
 	if (hdrs_size > into_memory.size())
 		throw std::runtime_error("Malformed image headers");
 
 	into_memory.memory_manager().commit(into_memory.data(), hdrs_size);
 	image.read(0_offs, hdrs_size, into_memory.data());
+	return hdrs_size;
 }
 
 template <class PEFileImage, class MemoryBlock>
-void map_pe_image_sections_indirect(const PEFileImage & image, MemoryBlock & into_memory)
+std::size_t map_pe_image_sections_indirect(const PEFileImage  & image,
+                                           const ImageLayout  & layout,
+                                           MemoryBlock        & into_memory)
 {
+	std::size_t bytes_mapped = 0;
 	std::vector<char> rdata_buf;
 	MemoryManager & memory_manager = into_memory.memory_manager();
-	for (const auto & sect_header : image.section_headers()) {
+	for (const SectionLayout & sect_header : layout.sections) {
 		rdata_buf.resize(sect_header.size_of_raw_data);
 		const peplus::FileOffset rdata_offs { sect_header.pointer_to_raw_data };
 		image.read(rdata_offs, rdata_buf.size(), rdata_buf.data());
@@ -86,16 +115,22 @@ void map_pe_image_sections_indirect(const PEFileImage & image, MemoryBlock & int
 		void * const outmem_ptr = into_memory.data() + vdata_offs;
 		memory_manager.commit(outmem_ptr, sect_header.virtual_size);
 		into_memory.write(vdata_offs, rdata_buf.data(), rdata_buf.size());
+		bytes_mapped += rdata_buf.size();
 	}
+
+	return bytes_mapped;
 }
 
 template <class PEFileImage, class MemoryBlock>
-void map_pe_image_sections_direct(const PEFileImage & image, MemoryBlock & into_memory)
+std::size_t map_pe_image_sections_direct(const PEFileImage  & image,
+                                         const ImageLayout  & layout,
+                                         MemoryBlock        & into_memory)
 {
 	assert(into_memory.memory_manager().allows_direct_addressing());
 
+	std::size_t bytes_mapped = 0;
 	MemoryManager & memory_manager = into_memory.memory_manager();
-	for (const auto & sect_header : image.section_headers()) {
+	for (const SectionLayout & sect_header : layout.sections) {
 		const std::size_t vdata_offs = sect_header.virtual_address;
 		const peplus::FileOffset rdata_offs { sect_header.pointer_to_raw_data };
 
@@ -106,31 +141,37 @@ void map_pe_image_sections_direct(const PEFileImage & image, MemoryBlock & into_
 
 		memory_manager.commit(outmem_ptr, sect_header.virtual_size);
 		image.read(rdata_offs, sect_header.size_of_raw_data, outmem_ptr);
+		bytes_mapped += sect_header.size_of_raw_data;
 	}
+
+	return bytes_mapped;
 }
 
-template <class PEVirtualImage, class MemoryBlock>
-void apply_pe_relocation_entry(const PEVirtualImage          & image,
-                               const peplus::BaseRelocation  & base_reloc,
-                               const peplus::RelocationEntry & reloc_entry,
-                               std::uintptr_t                  base_address,
-                               MemoryBlock                   & relblock_mem)
+template <class MemoryBlock>
+void apply_pe_relocation_entry(std::uint16_t   reloc_entry,
+                               std::ptrdiff_t  base_diff,
+                               MemoryBlock   & relblock_mem,
+                               std::size_t     relblock_size)
 {
-	const auto reloc_offs = reloc_entry.address - base_reloc.virtual_address;
-	const std::uintptr_t preferred_base = image.optional_header().image_base;
-	const std::ptrdiff_t base_diff = base_address - preferred_base;
+	const std::size_t reloc_offs = reloc_entry & 0xfff;
+	const auto check_entry_bounds = [&] (std::size_t value_size) {
+		if (reloc_offs > relblock_size || relblock_size - reloc_offs < value_size)
+			throw std::runtime_error("Invalid relocation entry");
+	};
 
-	switch (reloc_entry.type) {
+	switch (reloc_entry >> 12) {
 		case peplus::REL_BASED_ABSOLUTE:
 			break;
 
 		case peplus::REL_BASED_HIGHLOW:
-			modify_le_value_at<std::uint32_t>(relblock_mem, reloc_offs.value(),
+			check_entry_bounds(sizeof(std::uint32_t));
+			modify_le_value_at<std::uint32_t>(relblock_mem, reloc_offs,
 				[=] (auto x) { return x + std::int32_t(base_diff); });
 			break;
 
 		case peplus::REL_BASED_DIR64:
-			modify_le_value_at<std::uint64_t>(relblock_mem, reloc_offs.value(),
+			check_entry_bounds(sizeof(std::uint64_t));
+			modify_le_value_at<std::uint64_t>(relblock_mem, reloc_offs,
 				[=] (auto x) { return x + std::int64_t(base_diff); });
 			break;
 
@@ -139,67 +180,142 @@ void apply_pe_relocation_entry(const PEVirtualImage          & image,
 	}
 }
 
-template <class PEImage, class MemoryBlock>
-void apply_pe_image_relocations_direct(const PEImage & image, MemoryBlock & image_mem)
+inline std::ptrdiff_t pe_image_base_delta(const ImageLayout & layout, const void * image_base)
+{
+	const auto base_address = reinterpret_cast<std::uintptr_t>(image_base);
+	return base_address - static_cast<std::uintptr_t>(layout.image_base);
+}
+
+inline std::size_t pe_relocation_block_size(const ImageLayout & layout, std::uint32_t block_rva)
+{
+	constexpr std::size_t max_block_size = 0x1000 + sizeof(std::uint64_t);
+	if (block_rva >= layout.image_size)
+		throw std::runtime_error("Invalid relocation block");
+	return std::min<std::size_t>(max_block_size, layout.image_size - block_rva);
+}
+
+template <class MemoryBlock>
+std::size_t apply_pe_image_relocations_direct(const ImageLayout & layout, MemoryBlock & image_mem)
 {
 	assert(image_mem.memory_manager().allows_direct_addressing());
 
-	const auto base_address = reinterpret_cast<std::uintptr_t>(image_mem.data());
-	for (const auto & base_reloc : image.base_relocations()) {
-		const std::size_t relblock_size = base_reloc.size_of_block;
-		auto relblock_slice = get_memory_block_slice(image_mem, base_reloc.virtual_address, relblock_size);
-		for (const auto & reloc_entry : base_reloc.entries())
-			apply_pe_relocation_entry(image, base_reloc, reloc_entry, base_address, relblock_slice);
-	}
+	const std::ptrdiff_t base_diff = pe_image_base_delta(layout, image_mem.data());
+	if (base_diff == 0) return 0;
+
+	std::size_t reloc_count = 0;
+	char * const image_ptr = image_mem.data();
+	for_each_pe_relocation_block(image_ptr, layout,
+		[&] (std::uint32_t block_rva, const char * entries, std::size_t entry_count) {
+			const std::size_t relblock_size = pe_relocation_block_size(layout, block_rva);
+			char * relblock_ptr = image_ptr + block_rva;
+			for (std::size_t i = 0; i < entry_count; ++i) {
+				const auto reloc_entry = read_le_value_from<std::uint16_t>(entries, 2 * i);
+				apply_pe_relocation_entry(reloc_entry, base_diff, relblock_ptr, relblock_size);
+			}
+			reloc_count += entry_count;
+		});
+
+	return reloc_count;
 }
 
-template <class PEImage, class MemoryBlock>
-void apply_pe_image_relocations_indirect(const PEImage & image, MemoryBlock & image_mem)
+template <class ImageData, class MemoryBlock>
+std::size_t apply_pe_image_relocations_indirect(const ImageData   & image,
+                                                const ImageLayout & layout,
+                                                MemoryBlock       & image_mem)
 {
-	const auto base_address = reinterpret_cast<std::uintptr_t>(image_mem.data());
-	for (const auto & base_reloc : image.base_relocations()) {
-		const std::size_t relblock_size = base_reloc.size_of_block;
-		auto relblock_slice = get_memory_block_slice(image_mem, base_reloc.virtual_address, relblock_size);
-		OwnedMemoryBlock relblock_copy = copy_into_local_memory(relblock_slice);
-		for (const auto & reloc_entry : base_reloc.entries())
-			apply_pe_relocation_entry(image, base_reloc, reloc_entry, base_address, relblock_copy);
-		relblock_slice.write(0, relblock_copy.data(), relblock_size);
-	}
+	const std::ptrdiff_t base_diff = pe_image_base_delta(layout, image_mem.data());
+	if (base_diff == 0) return 0;
+
+	std::size_t reloc_count = 0;
+	for_each_pe_relocation_block(image, layout,
+		[&] (std::uint32_t block_rva, const char * entries, std::size_t entry_count) {
+			const std::size_t relblock_size = pe_relocation_block_size(layout, block_rva);
+			auto relblock_slice = get_memory_block_slice(image_mem, block_rva, relblock_size);
+			OwnedMemoryBlock relblock_copy = copy_into_local_memory(relblock_slice,
+			                                                        current_process().memory_manager());
+			for (std::size_t i = 0; i < entry_count; ++i) {
+				const auto reloc_entry = read_le_value_from<std::uint16_t>(entries, 2 * i);
+				apply_pe_relocation_entry(reloc_entry, base_diff, relblock_copy, relblock_size);
+			}
+			relblock_slice.write(0, relblock_copy.data(), relblock_size);
+			reloc_count += entry_count;
+		});
+
+	return reloc_count;
 }
 
-template <class PEImportDescriptor, class MemoryBlock>
-void resolve_pe_imported_symbols(const PEImportDescriptor & import_dtor,
-                                 const Module & module, MemoryBlock & image_mem)
+template <unsigned int XX, class ImageData, class MemoryBlock>
+std::size_t resolve_pe_imported_symbols(const ImageData          & image,
+                                        const ImageLayout        & layout,
+                                        const PEImportDescriptor & import_dtor,
+                                        const std::string        & mod_name,
+                                        const Module & module, MemoryBlock & image_mem,
+                                        AbiBridge * abi_bridge = nullptr,
+                                        ImportCallCounters * call_counters = nullptr,
+                                        ImportResolver * import_resolver = nullptr,
+                                        LoadFailure * failure = nullptr)
 {
-	auto thunks_it = import_dtor.thunks().begin();
-	for (const auto & import_entry : import_dtor.entries()) {
-		std::visit([&] (const auto & import_info) {
-			if constexpr (import_dtor.template is_unnamed_import<decltype(import_info)>()) {
-				throw std::runtime_error("Imports by ordinal are not supported");
-			} else {
-				const void * const import_addr = module.get_data<void>(import_info.name);
-				if (!import_addr) throw std::runtime_error("Image has unresolved imports");
+	using VA = std::conditional_t<XX == 64, std::uint64_t, std::uint32_t>;
 
-				const std::size_t thunk_rva = thunks_it->offset().value();
-				write_le_value_into(import_addr, image_mem, thunk_rva);
-				++thunks_it;
-			}
-		}, import_entry);
+	if (abi_bridge != nullptr && module.abi() == abi_bridge->module_abi())
+		abi_bridge = nullptr;
+
+	std::size_t import_count = 0;
+	for (const PEImportEntry & import_entry : read_pe_import_entries<XX>(image, layout, import_dtor)) {
+		if (import_entry.ordinal) {
+			report_load_failure(failure, LoadError::UnsupportedFeature, "Imports by ordinal are not supported",
+			                    mod_name);
+			break;
+		}
+
+		const void * import_addr = module.get_data<void>(import_entry.name);
+		if (import_resolver)
+			import_addr = import_resolver->resolve_import(mod_name, import_entry.name, import_addr);
+		if (!import_addr) {
+			report_load_failure(failure, LoadError::MissingSymbol, "Image has unresolved imports",
+			                    mod_name, import_entry.name);
+			break;
+		}
+		if (call_counters)
+			import_addr = call_counters->import_thunk(mod_name, import_entry.name, import_addr, abi_bridge);
+		else if (abi_bridge)
+			import_addr = abi_bridge->import_thunk(import_addr);
+
+		write_le_value_into(static_cast<VA>(reinterpret_cast<std::uintptr_t>(import_addr)), image_mem,
+		                    import_entry.thunk_rva);
+		++import_count;
 	}
+
+	return import_count;
 }
 
-template <class PEImage, class MemoryBlock>
-void resolve_pe_image_imports(const PEImage  & image,
-                              ModuleProvider & mod_provider,
-                              MemoryBlock    & image_mem)
+template <unsigned int XX, class ImageData, class MemoryBlock>
+std::size_t resolve_pe_image_imports(const ImageData    & image,
+                                     const ImageLayout  & layout,
+                                     ModuleProvider     & mod_provider,
+                                     MemoryBlock        & image_mem,
+                                     LoadObserver       * observer = nullptr,
+                                     AbiBridge          * abi_bridge = nullptr,
+                                     ImportCallCounters * call_counters = nullptr,
+                                     ImportResolver     * import_resolver = nullptr,
+                                     LoadFailure        * failure = nullptr)
 {
-	for (const auto & import_dtor : image.import_descriptors()) {
-		const std::string mod_name = import_dtor.name_str();
+	std::size_t import_count = 0;
+	for (const PEImportDescriptor & import_dtor : read_pe_import_descriptors(image, layout)) {
+		const std::string mod_name = read_pe_image_string(image, layout, import_dtor.name_rva);
+		DependencyScope dependency_scope { observer, mod_name };
 		const auto mod_sp = mod_provider.get_module(mod_name);
-		if (!mod_sp)
-			throw std::runtime_error("Image has unresolved imports");
-		resolve_pe_imported_symbols(import_dtor, *mod_sp, image_mem);
+		if (!mod_sp) {
+			report_load_failure(failure, LoadError::MissingModule, "Image has unresolved imports", mod_name);
+			break;
+		}
+		dependency_scope.resolved = true;
+		import_count += resolve_pe_imported_symbols<XX>(image, layout, import_dtor, mod_name, *mod_sp, image_mem,
+		                                                abi_bridge, call_counters, import_resolver, failure);
+		if (has_load_failure(failure)) break;
 	}
+
+	return import_count;
 }
 
 constexpr int pe_section_memory_access(int characteristics)
@@ -211,190 +327,540 @@ constexpr int pe_section_memory_access(int characteristics)
 	return mem_access;
 }
 
-template <class PEImage, class MemoryBlock>
-void apply_pe_memory_permissions(const PEImage & image, MemoryBlock & image_mem)
+template <class MemoryBlock>
+std::size_t apply_pe_memory_permissions(const ImageLayout & layout, MemoryBlock & image_mem)
 {
+	std::size_t bytes_protected = 0;
 	MemoryManager & memory_manager = image_mem.memory_manager();
-	for (const auto & sect_header : image.section_headers()) {
+	for (const SectionLayout & sect_header : layout.sections) {
 		const std::size_t vdata_offs = sect_header.virtual_address;
 		void * const mem_ptr = image_mem.data() + vdata_offs;
 
 		const int mem_access = pe_section_memory_access(sect_header.characteristics);
 		memory_manager.set_access(mem_ptr, sect_header.virtual_size, mem_access);
+		bytes_protected += sect_header.virtual_size;
 	}
+
+	return bytes_protected;
 }
 
-template <class PEImage, class MemoryBlock>
-void remove_pe_discardable_sections(const PEImage & image, MemoryBlock & image_mem)
+template <class MemoryBlock>
+std::size_t remove_pe_discardable_sections(const ImageLayout & layout, MemoryBlock & image_mem)
 {
+	std::size_t bytes_discarded = 0;
 	MemoryManager & memory_manager = image_mem.memory_manager();
-	for (const auto & section_header : image.section_headers()) {
+	for (const SectionLayout & section_header : layout.sections) {
 		if (section_header.characteristics & peplus::SCN_MEM_DISCARDABLE) {
 			const std::size_t vdata_size = section_header.virtual_size;
 			const std::size_t vdata_offs = section_header.virtual_address;
 			void * const vdata_ptr = image_mem.data() + vdata_offs;
 			memory_manager.decommit(vdata_ptr, vdata_size);
+			bytes_discarded += vdata_size;
 		}
 	}
+
+	return bytes_discarded;
+}
+
+inline std::size_t align_to_page(std::size_t size, std::size_t page_size)
+{
+	return (size + page_size - 1) & ~(page_size - 1);
 }
 
+template <class MemoryBlock>
+ModuleMemoryStats pe_image_memory_stats(const ImageLayout & layout, const MemoryBlock & image_mem)
+{
+	const MemoryManager & memory_manager = image_mem.memory_manager();
+	const std::size_t page_size = memory_manager.page_size();
+
+	ModuleMemoryStats mem_stats;
+	mem_stats.reserved_size = image_mem.size();
+
+	// Access and commitment are queried rather than taken from the section headers, since the loader
+	// decommits discarded sections and a module may reprotect its pages
+	const auto query_section_stats = [&] (const char * vdata_ptr, std::size_t vdata_size) {
+		const MemoryManager::MemoryState mem_state = memory_manager.memory_state(vdata_ptr, vdata_size);
+
+		SectionMemoryStats sect_stats;
+		sect_stats.address = reinterpret_cast<std::uintptr_t>(vdata_ptr);
+		sect_stats.reserved_size = vdata_size;
+		sect_stats.committed_size = mem_state.committed_size;
+		sect_stats.resident_size = mem_state.committed_size != 0
+		                         ? memory_manager.resident_size(vdata_ptr, vdata_size) : 0;
+		sect_stats.access = mem_state.access;
+		sect_stats.discarded = mem_state.committed_size == 0;
+		return sect_stats;
+	};
+
+	const std::size_t hdrs_size = align_to_page(layout.headers_size, page_size);
+	mem_stats.sections.push_back(query_section_stats(image_mem.data(), hdrs_size));
+
+	for (const SectionLayout & sect_header : layout.sections) {
+		const std::size_t vdata_size = align_to_page(sect_header.virtual_size, page_size);
+		SectionMemoryStats sect_stats = query_section_stats(image_mem.data() + sect_header.virtual_address,
+		                                                    vdata_size);
+		sect_stats.name = section_name(sect_header);
+		mem_stats.sections.push_back(std::move(sect_stats));
+	}
+
+	for (const SectionMemoryStats & sect_stats : mem_stats.sections) {
+		mem_stats.committed_size += sect_stats.committed_size;
+		mem_stats.resident_size += sect_stats.resident_size;
+		if (sect_stats.discarded)
+			mem_stats.discarded_size += sect_stats.reserved_size;
+	}
+
+	return mem_stats;
+}
+
+// Tables of images mapped elsewhere are read from their source file, which saves a read from the target
+// process per table entry
+template <unsigned int XX, class PEFileImage, class MemoryBlock>
+void link_pe_image(const PEFileImage    & src_image,
+                   const ImageLayout    & layout,
+                   MemoryBlock          & image_mem,
+                   ModuleProvider       & mod_provider,
+                   LoadObserver         * observer = nullptr,
+                   AbiBridge            * abi_bridge = nullptr,
+                   ImportCallCounters   * call_counters = nullptr,
+                   ImportResolver       * import_resolver = nullptr,
+                   LoadFailure          * failure = nullptr)
+{
+	const bool direct_access = image_mem.memory_manager().allows_direct_addressing();
+	const PESourceImage<PEFileImage> src_tables { src_image, layout };
+	{
+		LoadPhaseScope reloc_phase { observer, LoadPhase::ApplyRelocations };
+		reloc_phase.stats.relocations = direct_access
+			? detail::apply_pe_image_relocations_direct(layout, image_mem)
+			: detail::apply_pe_image_relocations_indirect(src_tables, layout, image_mem);
+	}
+	{
+		LoadPhaseScope import_phase { observer, LoadPhase::ResolveImports };
+		char * image_ptr = image_mem.data();
+		import_phase.stats.imports = direct_access
+			? detail::resolve_pe_image_imports<XX>(image_ptr, layout, mod_provider, image_ptr, observer,
+			                                       abi_bridge, call_counters, import_resolver, failure)
+			: detail::resolve_pe_image_imports<XX>(src_tables, layout, mod_provider, image_mem, observer,
+			                                       abi_bridge, call_counters, import_resolver, failure);
+	}
+}
+
+constexpr std::size_t pe_tls_alignment(std::uint32_t characteristics)
+{
+	const unsigned int align_bits = (characteristics >> 20) & 0xf;
+	return align_bits != 0 ? std::size_t(1) << (align_bits - 1) : 1;
+}
+
+// The slot delivers DLL_THREAD_ATTACH and DLL_THREAD_DETACH to the module, and keeps a host-side copy of the
+// TLS template per thread. Module code addresses its TLS through the TEB, which the loader does not set up,
+// so the index in the TLS directory is left untouched.
 template <unsigned int XX>
-OwnedMemoryBlock load_pe_image(const MemoryBuffer & image_data,
-                               MemoryManager      & memory_manager,
-                               ModuleProvider     & mod_provider)
-{
-	const peplus::FileImage<XX, any_buffer> src_image { image_data };
-	auto image_mem = detail::allocate_pe_image(src_image, memory_manager);
-	if (memory_manager.allows_direct_addressing()) {
-		detail::copy_pe_image_headers_direct(src_image, image_mem);
-		detail::map_pe_image_sections_direct(src_image, image_mem);
-	} else {
-		detail::copy_pe_image_headers_indirect(src_image, image_mem);
-		detail::map_pe_image_sections_indirect(src_image, image_mem);
+TlsSlot allocate_pe_tls_slot(const ImageLayout & layout, void * image_base)
+{
+	char * const image_ptr = static_cast<char *>(image_base);
+	const auto image_addr = reinterpret_cast<std::uintptr_t>(image_base);
+
+	std::vector<std::uintptr_t> tls_callbacks;
+	TlsSlotInfo slot_info;
+	if (layout.directory(peplus::DIRECTORY_ENTRY_TLS)) {
+		const PETlsDirectory tls_info = read_pe_tls_directory<XX>(image_ptr, layout);
+		const std::uint64_t raw_data_offset = tls_info.raw_data_begin - image_addr;
+		if (tls_info.raw_data_end < tls_info.raw_data_begin || tls_info.raw_data_begin < image_addr
+		 || raw_data_offset > layout.image_size
+		 || tls_info.raw_data_end - tls_info.raw_data_begin > layout.image_size - raw_data_offset)
+			throw std::runtime_error("Invalid TLS directory");
+
+		const char * const raw_data = image_ptr + raw_data_offset;
+		slot_info.init_data.assign(raw_data, raw_data + (tls_info.raw_data_end - tls_info.raw_data_begin));
+		slot_info.zero_fill_size = tls_info.zero_fill_size;
+		slot_info.alignment = pe_tls_alignment(tls_info.characteristics);
+		tls_callbacks = read_pe_tls_callbacks<XX>(image_ptr, layout, image_addr);
 	}
 
-	const peplus::VirtualImage<XX, any_buffer> dst_image { image_mem };
-	if (memory_manager.allows_direct_addressing()) {
-		detail::apply_pe_image_relocations_direct(dst_image, image_mem);
-	} else {
-		detail::apply_pe_image_relocations_indirect(dst_image, image_mem);
+	const std::uintptr_t entry_point = layout.entry_point ? image_addr + layout.entry_point : 0;
+	if (tls_callbacks.empty() && entry_point == 0 && !layout.directory(peplus::DIRECTORY_ENTRY_TLS))
+		return TlsSlot();
+
+	const auto notify_thread_event = [image_base, tls_callbacks, entry_point] (DWORD event) {
+		for (const std::uintptr_t tls_callback : tls_callbacks)
+			reinterpret_cast<TlsCallback>(tls_callback)(image_base, event, nullptr);
+		if (entry_point != 0)
+			reinterpret_cast<DllMain>(entry_point)(image_base, event, nullptr);
+	};
+
+	slot_info.thread_attach = [notify_thread_event] { notify_thread_event(DLL_THREAD_ATTACH); };
+	slot_info.thread_detach = [notify_thread_event] { notify_thread_event(DLL_THREAD_DETACH); };
+
+	return TlsSlot { std::move(slot_info) };
+}
+
+template <unsigned int XX, class Buffer>
+OwnedMemoryBlock load_pe_image(const peplus::FileImage<XX, Buffer> & src_image,
+                               const ImageLayout                   & layout,
+                               MemoryManager                       & memory_manager,
+                               ModuleProvider                      & mod_provider,
+                               LoadObserver                        * observer = nullptr,
+                               AbiBridge                           * abi_bridge = nullptr,
+                               TlsSlot                             * tls_slot = nullptr,
+                               ImportCallCounters                  * call_counters = nullptr,
+                               ImportResolver                      * import_resolver = nullptr,
+                               LoadFailure                         * failure = nullptr)
+{
+	const bool direct_access = memory_manager.allows_direct_addressing();
+	auto image_mem = detail::allocate_pe_image(layout, memory_manager);
+	{
+		LoadPhaseScope copy_phase { observer, LoadPhase::CopyHeaders };
+		copy_phase.stats.bytes = direct_access
+			? detail::copy_pe_image_headers_direct(src_image, layout, image_mem)
+			: detail::copy_pe_image_headers_indirect(src_image, layout, image_mem);
+	}
+	{
+		LoadPhaseScope map_phase { observer, LoadPhase::MapSections };
+		map_phase.stats.bytes = direct_access
+			? detail::map_pe_image_sections_direct(src_image, layout, image_mem)
+			: detail::map_pe_image_sections_indirect(src_image, layout, image_mem);
+	}
+
+	detail::link_pe_image<XX>(src_image, layout, image_mem, mod_provider, observer, abi_bridge,
+	                          call_counters, import_resolver, failure);
+	if (has_load_failure(failure)) return image_mem;
+	if (direct_access && tls_slot != nullptr)
+		*tls_slot = detail::allocate_pe_tls_slot<XX>(layout, image_mem.data());
+	{
+		LoadPhaseScope access_phase { observer, LoadPhase::ApplyPermissions };
+		access_phase.stats.bytes = detail::apply_pe_memory_permissions(layout, image_mem);
+	}
+	{
+		LoadPhaseScope discard_phase { observer, LoadPhase::DiscardSections };
+		discard_phase.stats.bytes = detail::remove_pe_discardable_sections(layout, image_mem);
 	}
-	detail::resolve_pe_image_imports(dst_image, mod_provider, image_mem);
-	detail::apply_pe_memory_permissions(dst_image, image_mem);
-	detail::remove_pe_discardable_sections(dst_image, image_mem);
+
 	return image_mem;
 }
 
-template <class PEImage>
-inline std::size_t pe_image_exception_table_size(const PEImage & image)
+inline const DirectoryRange & pe_image_exception_table(const ImageLayout & layout)
+{
+	return layout.directory(peplus::DIRECTORY_ENTRY_EXCEPTION);
+}
+
+inline ModuleRange pe_image_module_range(const ImageLayout & layout, void * image_mem, const Module * module)
 {
-	const auto except_dir = image.data_directory(peplus::DIRECTORY_ENTRY_EXCEPTION);
-	return except_dir ? except_dir->size : 0;
+	ModuleRange range { reinterpret_cast<std::uintptr_t>(image_mem), layout.image_size, module, nullptr, 0 };
+	if (const DirectoryRange & rftable = pe_image_exception_table(layout)) {
+		const char * const rftable_ptr = static_cast<const char *>(image_mem) + rftable.virtual_address;
+		range.runtime_functions = reinterpret_cast<const RuntimeFunction *>(rftable_ptr);
+		range.runtime_function_count = rftable.size / sizeof(RuntimeFunction);
+	}
+	return range;
 }
 
-template <class PEImage>
-void register_pe_image_exception_table(const PEImage & image,
-                                       Process       & process,
-                                       void          * image_mem)
+inline std::vector<PerfMapEntry> pe_image_perf_map_entries(const ImageLayout & layout, const void * image_base)
 {
-	if (const auto rftable = image.exception_entries()) {
-		const auto rftable_offset = rftable.begin()->offset();
+	const char * const image_ptr = static_cast<const char *>(image_base);
+	const auto is_code_rva = [&] (std::uint32_t rva) {
+		const SectionLayout * const section = layout.section_containing(rva);
+		return section != nullptr && (section->characteristics & peplus::SCN_MEM_EXECUTE) != 0;
+	};
+
+	std::string module_name = "libload_module";
+	std::map<std::uint32_t, std::string> export_names;
+	try {
+		if (const auto export_dir = read_pe_export_directory(image_ptr, layout)) {
+			if (std::string name = read_pe_image_string(image_ptr, layout, export_dir->name_rva); !name.empty())
+				module_name = std::move(name);
+
+			for (std::uint32_t i = 0; i < export_dir->name_count; ++i) {
+				const auto function_rva = pe_named_export_rva(image_ptr, layout, *export_dir, i);
+				if (!function_rva || export_dir->range.contains(*function_rva) || !is_code_rva(*function_rva))
+					continue;
+
+				const auto name_rva = read_pe_image_value<std::uint32_t>(image_ptr, layout, export_dir->names_rva + i * 4);
+				export_names.emplace(*function_rva, module_name + '!' + read_pe_image_string(image_ptr, layout, name_rva));
+			}
+		}
+	} catch (const std::runtime_error &) {
+		// The names only label the entries; a malformed export table leaves the functions unnamed
+	}
+
+	std::map<std::uint32_t, std::uint32_t> function_ends;
+	for (const auto & [function_rva, name] : export_names)
+		function_ends.emplace(function_rva, 0);
+	if (const DirectoryRange & rftable = pe_image_exception_table(layout)) {
+		const char * const rftable_ptr = image_ptr + rftable.virtual_address;
+		for (std::uint32_t offs = 0; offs + sizeof(RuntimeFunction) <= rftable.size; offs += sizeof(RuntimeFunction)) {
+			const auto begin_rva = read_le_value_from<std::uint32_t>(rftable_ptr, offs);
+			const auto end_rva = read_le_value_from<std::uint32_t>(rftable_ptr, offs + 4);
+			if (begin_rva < end_rva && is_code_rva(begin_rva))
+				function_ends[begin_rva] = end_rva;
+		}
+	}
+
+	const auto image_addr = reinterpret_cast<std::uintptr_t>(image_base);
+	std::vector<PerfMapEntry> entries;
+	entries.reserve(function_ends.size());
+	for (auto func_it = function_ends.begin(); func_it != function_ends.end(); ++func_it) {
+		const auto [begin_rva, pdata_end_rva] = *func_it;
+		std::uint32_t end_rva = pdata_end_rva;
+		if (end_rva == 0) {
+			const SectionLayout * const section = layout.section_containing(begin_rva);
+			end_rva = section->virtual_address + std::max(section->virtual_size, section->size_of_raw_data);
+			if (const auto next_it = std::next(func_it); next_it != function_ends.end())
+				end_rva = std::min(end_rva, next_it->first);
+		}
+
+		const auto name_it = export_names.find(begin_rva);
+		std::ostringstream name_stream;
+		if (name_it != export_names.end())
+			name_stream << name_it->second;
+		else
+			name_stream << module_name << "+0x" << std::hex << begin_rva;
+		entries.push_back({ image_addr + begin_rva, std::size_t(end_rva - begin_rva), name_stream.str() });
+	}
+
+	return entries;
+}
+
+inline void register_pe_image_exception_table(const ImageLayout & layout,
+                                              Process           & process,
+                                              void              * image_mem)
+{
+	if (const DirectoryRange & rftable = pe_image_exception_table(layout)) {
 		const auto image_base = reinterpret_cast<std::uintptr_t>(image_mem);
-		const std::size_t rftable_size = pe_image_exception_table_size(image);
-		const auto rftable_ptr = static_cast<char *>(image_mem) + rftable_offset.value();
-		process.register_exception_table(image_base, rftable_ptr, rftable_size);
+		const auto rftable_ptr = static_cast<char *>(image_mem) + rftable.virtual_address;
+		process.register_exception_table(image_base, rftable_ptr, rftable.size);
 	}
 }
 
-template <class PEVirtualImage>
-void invoke_pe_tls_callbacks_direct(const PEVirtualImage & image,
+template <unsigned int XX>
+void invoke_pe_tls_callbacks_direct(const ImageLayout & layout,
                                     void * image_base, DWORD event,
                                     void * reserved)
 {
-	char * const image_ptr = static_cast<char *>(image_base);
-	if (const auto tls_dir = image.tls_directory()) {
-		for (const auto fn_rva : tls_dir->callbacks()) {
-			void * const fn_ptr = image_ptr + fn_rva.value();
-			const auto tls_fn = reinterpret_cast<TlsCallback>(fn_ptr);
-			tls_fn(image_base, event, reserved);
-		}
+	const char * const image_ptr = static_cast<const char *>(image_base);
+	const auto image_addr = reinterpret_cast<std::uintptr_t>(image_base);
+	for (const std::uintptr_t tls_callback : read_pe_tls_callbacks<XX>(image_ptr, layout, image_addr)) {
+		const auto tls_fn = reinterpret_cast<TlsCallback>(tls_callback);
+		tls_fn(image_base, event, reserved);
 	}
 }
 
-template <class PEVirtualImage>
-void * pe_image_entry_point(const PEVirtualImage & image, void * image_base)
+inline void * pe_image_entry_point(const ImageLayout & layout, void * image_base)
 {
-	const auto opt_header = image.optional_header();
 	char * const image_ptr = static_cast<char *>(image_base);
-	return image_ptr + opt_header.address_of_entry_point;
+	return image_ptr + layout.entry_point;
 }
 
-template <class PEVirtualImage>
-int invoke_dll_entry_point_direct(const PEVirtualImage & image,
-                                  void * image_base, DWORD event,
-                                  void * reserved)
+inline int invoke_dll_entry_point_direct(const ImageLayout & layout,
+                                         void * image_base, DWORD event,
+                                         void * reserved)
 {
-	assert(image.type() == peplus::ImageType::Dynamic);
+	assert(layout.is_dll);
 
-	const void * entry_point = pe_image_entry_point(image, image_base);
+	if (layout.entry_point == 0) return true;
+
+	const void * entry_point = pe_image_entry_point(layout, image_base);
 	const auto dll_main = reinterpret_cast<DllMain>(entry_point);
 	return dll_main(image_base, event, reserved);
 }
 
-template <class PEImage>
-int notify_dll_event_direct(const PEImage & image, void * image_base,
-                            DWORD event, void * reserved = nullptr)
+template <unsigned int XX>
+int notify_dll_event_direct(const ImageLayout & layout, void * image_base, DWORD event, void * reserved = nullptr)
+{
+	invoke_pe_tls_callbacks_direct<XX>(layout, image_base, event, reserved);
+	return invoke_dll_entry_point_direct(layout, image_base, event, reserved);
+}
+
+// Batches the notifications of several modules into a single injected call. The routine stops at the first
+// DLL_PROCESS_ATTACH that fails, so the modules after it are never notified.
+class DllNotifyBatch
+{
+public:
+	template <unsigned int XX, class MemoryBlock>
+	void add_module(const MemoryBlock & image_mem, const ImageLayout & layout,
+	                std::initializer_list<DWORD> events);
+
+	std::size_t module_count() const { return _attach_calls.size(); }
+
+	// Returns the index of the module whose DllMain failed, or module_count() when none did
+	std::size_t run(Process & process) const;
+
+private:
+	RemoteCallBatch                       _call_batch;
+	std::vector<std::vector<std::size_t>> _attach_calls;
+};
+
+template <unsigned int XX, class MemoryBlock>
+void DllNotifyBatch::add_module(const MemoryBlock & image_mem, const ImageLayout & layout,
+                                std::initializer_list<DWORD> events)
+{
+	assert(layout.is_dll);
+
+	const auto image_addr = reinterpret_cast<std::uintptr_t>(image_mem.data());
+	const std::vector<std::uintptr_t> tls_callbacks = read_pe_tls_callbacks<XX>(image_mem, layout, image_addr);
+
+	std::vector<std::size_t> & attach_calls = _attach_calls.emplace_back();
+	for (const DWORD event : events) {
+		const ParameterList params = make_proc_params(image_addr, event, std::uintptr_t(0));
+		for (const std::uintptr_t tls_callback : tls_callbacks)
+			_call_batch.add_call(tls_callback, params);
+		if (layout.entry_point == 0) continue;
+
+		const std::uintptr_t entry_point = image_addr + layout.entry_point;
+		if (event == DLL_PROCESS_ATTACH)
+			attach_calls.push_back(_call_batch.add_checked_call(entry_point, params));
+		else
+			_call_batch.add_call(entry_point, params);
+	}
+}
+
+inline std::size_t DllNotifyBatch::run(Process & process) const
 {
-	invoke_pe_tls_callbacks_direct(image, image_base, event, reserved);
-	return invoke_dll_entry_point_direct(image, image_base, event, reserved);
+	const std::vector<std::uint64_t> results = _call_batch.run(process);
+
+	for (std::size_t module_index = 0; module_index < _attach_calls.size(); ++module_index) {
+		for (const std::size_t call_index : _attach_calls[module_index]) {
+			if (call_index >= results.size() || static_cast<std::uint32_t>(results[call_index]) == 0)
+				return module_index;
+		}
+	}
+	return _attach_calls.size();
 }
 
-template <class PEVirtualImage>
-std::unique_ptr<CodeChunk> notify_dll_event_indirect(const PEVirtualImage & image,
-                                                     void                 * image_base,
-                                                     CodeGenerator        & code_generator,
-                                                     DWORD                  event,
-                                                     void                 * reserved = nullptr)
+// Modules loaded into a process without direct addressing are initialized by one injected routine per top-level
+// load. Dependencies load from within the top-level load on the same thread, so they join its batch ahead of the
+// modules that import them.
+class DllInitScope
 {
-	const AbsoluteCodeLocation dll_main = pe_image_entry_point(image, image_base);
-	const CallingConvention & stdcall_cconv = code_generator.get_calling_convention("stdcall");
-	return stdcall_cconv.invoke_proc(dll_main, make_proc_params(image_base, event, reserved));
+public:
+	explicit DllInitScope(Process & process);
+	DllInitScope(const DllInitScope &) = delete;
+	DllInitScope & operator=(const DllInitScope &) = delete;
+	~DllInitScope();
+
+	bool is_outermost() const { return _root == this; }
+	std::size_t module_count() const { return _root->_notify_batch.module_count(); }
+
+	// mark_initialized keeps the module alive until the batch runs, and is called once its DllMain succeeded
+	template <unsigned int XX, class MemoryBlock>
+	void add_module(const MemoryBlock & image_mem, const ImageLayout & layout,
+	                std::function<void ()> mark_initialized);
+
+	// Runs the batch of the outermost scope; returns the index of the module whose DllMain failed, or the
+	// module count when none did
+	std::size_t run();
+
+private:
+	static DllInitScope *& active_scope();
+
+	Process                           * _process;
+	DllInitScope                      * _previous;
+	DllInitScope                      * _root;
+	DllNotifyBatch                      _notify_batch;
+	std::vector<std::function<void ()>> _mark_initialized;
+};
+
+inline DllInitScope *& DllInitScope::active_scope()
+{
+	static thread_local DllInitScope * scope = nullptr;
+	return scope;
 }
 
-template <class PEImage>
-bool initialize_dll_direct(const PEImage & image, Process & process, void * image_base)
+inline DllInitScope::DllInitScope(Process & process)
+	: _process { &process }
+	, _previous { active_scope() }
+	, _root { _previous != nullptr && _previous->_process == &process ? _previous->_root : this }
+{
+	active_scope() = this;
+}
+
+inline DllInitScope::~DllInitScope()
+{
+	active_scope() = _previous;
+}
+
+template <unsigned int XX, class MemoryBlock>
+void DllInitScope::add_module(const MemoryBlock & image_mem, const ImageLayout & layout,
+                              std::function<void ()> mark_initialized)
+{
+	_root->_notify_batch.add_module<XX>(image_mem, layout, { DLL_PROCESS_ATTACH, DLL_THREAD_ATTACH });
+	_root->_mark_initialized.push_back(std::move(mark_initialized));
+}
+
+inline std::size_t DllInitScope::run()
+{
+	assert(is_outermost());
+
+	const std::size_t failed_index = _notify_batch.run(*_process);
+	for (std::size_t module_index = 0; module_index < failed_index; ++module_index)
+		_mark_initialized[module_index]();
+	_mark_initialized.clear();
+	return failed_index;
+}
+
+// The loading thread attaches through the slot, which then sends DLL_THREAD_DETACH when it unloads the module
+// or exits; other threads attach when they first enter the module
+template <unsigned int XX>
+bool initialize_dll_direct(const ImageLayout & layout, Process & process, void * image_base,
+                           const TlsSlot & tls_slot)
 {
 	assert(process.memory_manager().allows_direct_addressing());
 
-	return notify_dll_event_direct(image, image_base, DLL_PROCESS_ATTACH)
-	    && notify_dll_event_direct(image, image_base, DLL_THREAD_ATTACH);
+	if (!notify_dll_event_direct<XX>(layout, image_base, DLL_PROCESS_ATTACH)) return false;
+	tls_slot.attach_thread();
+	return true;
 }
 
-template <class PEImage, class MemoryBlock>
-bool initialize_dll(const PEImage & image, Process & process, MemoryBlock & image_mem)
+template <unsigned int XX, class MemoryBlock>
+bool initialize_dll(const ImageLayout & layout, Process & process, MemoryBlock & image_mem,
+                    const TlsSlot & tls_slot = TlsSlot())
 {
-	register_pe_image_exception_table(image, process, image_mem.data());
+	register_pe_image_exception_table(layout, process, image_mem.data());
 
 	if (process.memory_manager().allows_direct_addressing()) {
-		return initialize_dll_direct(image, process, image_mem.data());
+		return initialize_dll_direct<XX>(layout, process, image_mem.data(), tls_slot);
 	} else {
-		// initialize_dll_indirect(image, process, image_mem);
+		DllNotifyBatch notify_batch;
+		notify_batch.add_module<XX>(image_mem, layout, { DLL_PROCESS_ATTACH, DLL_THREAD_ATTACH });
+		return notify_batch.run(process) == notify_batch.module_count();
 	}
 }
 
-template <class PEImage>
-void deinitialize_dll_direct(const PEImage & image, Process & process, void * image_base)
+// Releasing the slot sends DLL_THREAD_DETACH to the unloading thread and waits for other threads' notifications
+template <unsigned int XX>
+void deinitialize_dll_direct(const ImageLayout & layout, Process & process, void * image_base,
+                             TlsSlot & tls_slot)
 {
 	assert(process.memory_manager().allows_direct_addressing());
 
-	notify_dll_event_direct(image, image_base, DLL_THREAD_DETACH);
-	notify_dll_event_direct(image, image_base, DLL_PROCESS_DETACH);
+	tls_slot.reset();
+	notify_dll_event_direct<XX>(layout, image_base, DLL_PROCESS_DETACH);
 }
 
-template <class PEImage>
-void deregister_pe_image_exception_table(const PEImage & image,
-                                         Process       & process,
-                                         void          * image_mem)
+inline void deregister_pe_image_exception_table(const ImageLayout & layout,
+                                                Process           & process,
+                                                void              * image_mem)
 {
-	if (const auto rftable = image.exception_entries()) {
-		const auto rftable_offset = rftable.begin()->offset();
-		const auto rftable_ptr = static_cast<char *>(image_mem) + rftable_offset.value();
+	if (const DirectoryRange & rftable = pe_image_exception_table(layout)) {
+		const auto rftable_ptr = static_cast<char *>(image_mem) + rftable.virtual_address;
 		process.deregister_exception_table(rftable_ptr);
 	}
 }
 
-template <class PEImage, class MemoryBlock>
-void deinitialize_dll(const PEImage & image, Process & process, MemoryBlock & image_mem)
+template <unsigned int XX, class MemoryBlock>
+void deinitialize_dll(const ImageLayout & layout, Process & process, MemoryBlock & image_mem,
+                      TlsSlot & tls_slot)
 {
 	if (process.memory_manager().allows_direct_addressing()) {
-		deinitialize_dll_direct(image, process, image_mem.data());
+		deinitialize_dll_direct<XX>(layout, process, image_mem.data(), tls_slot);
 	} else {
-		// deinitialize_dll_indirect(image, process, image_mem);
+		DllNotifyBatch notify_batch;
+		notify_batch.add_module<XX>(image_mem, layout, { DLL_THREAD_DETACH, DLL_PROCESS_DETACH });
+		notify_batch.run(process);
 	}
 
-	deregister_pe_image_exception_table(image, process, image_mem.data());
+	deregister_pe_image_exception_table(layout, process, image_mem.data());
 }
 
 }
 
-#endif
+#endif
\ No newline at end of file
@@ -0,0 +1,141 @@
+#ifndef LOAD_SRC_PE_IMAGELAYOUT_HPP_
+#define LOAD_SRC_PE_IMAGELAYOUT_HPP_
+
+#include <peplus/file_image.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace load::detail {
+
+struct SectionLayout
+{
+	std::uint32_t virtual_address;
+	std::uint32_t virtual_size;
+	std::uint32_t pointer_to_raw_data;
+	std::uint32_t size_of_raw_data;
+	std::uint32_t characteristics;
+	char          name[8];
+};
+
+struct DirectoryRange
+{
+	std::uint32_t virtual_address = 0;
+	std::uint32_t size            = 0;
+
+	explicit operator bool() const { return size != 0; }
+	bool contains(std::uint32_t rva) const { return rva - virtual_address < size; }
+};
+
+struct ImageLayout
+{
+	enum { DIRECTORY_COUNT = 16 };
+
+	std::uint64_t              image_base;
+	std::uint32_t              image_size;
+	std::uint32_t              headers_size;
+	std::uint32_t              entry_point;
+	bool                       is_dll;
+	DirectoryRange             directories[DIRECTORY_COUNT];
+	std::vector<SectionLayout> sections;
+
+	const DirectoryRange & directory(int index) const;
+	const SectionLayout * section_containing(std::uint32_t rva) const;
+	std::optional<std::size_t> rva_to_file_offset(std::uint32_t rva) const;
+	std::size_t memory_footprint() const;
+};
+
+inline std::string section_name(const SectionLayout & section)
+{
+	return std::string(section.name, strnlen(section.name, sizeof(section.name)));
+}
+
+inline const DirectoryRange & ImageLayout::directory(int index) const
+{
+	return directories[index];
+}
+
+inline const SectionLayout * ImageLayout::section_containing(std::uint32_t rva) const
+{
+	const auto sect_it = std::upper_bound(sections.begin(), sections.end(), rva,
+		[] (std::uint32_t rva, const SectionLayout & section) { return rva < section.virtual_address; });
+	if (sect_it == sections.begin()) return nullptr;
+
+	const SectionLayout & section = *std::prev(sect_it);
+	const std::uint32_t section_size = std::max(section.virtual_size, section.size_of_raw_data);
+	return rva - section.virtual_address < section_size ? &section : nullptr;
+}
+
+inline std::optional<std::size_t> ImageLayout::rva_to_file_offset(std::uint32_t rva) const
+{
+	if (rva < headers_size) return rva;
+	const SectionLayout * const section = section_containing(rva);
+	if (section == nullptr) return std::nullopt;
+	const std::uint32_t section_offs = rva - section->virtual_address;
+	if (section_offs >= section->size_of_raw_data) return std::nullopt;
+	return section->pointer_to_raw_data + section_offs;
+}
+
+inline std::size_t ImageLayout::memory_footprint() const
+{
+	return sizeof(*this) + sections.capacity() * sizeof(SectionLayout);
+}
+
+template <class PEImage>
+ImageLayout decode_pe_image_layout(const PEImage & image)
+{
+	const auto opt_header = image.optional_header();
+
+	ImageLayout layout;
+	layout.image_base = opt_header.image_base;
+	layout.image_size = opt_header.size_of_image;
+	layout.headers_size = opt_header.size_of_headers;
+	layout.entry_point = opt_header.address_of_entry_point;
+	layout.is_dll = image.type() == peplus::ImageType::Dynamic;
+	if (layout.headers_size > layout.image_size)
+		throw std::runtime_error("Malformed image headers");
+
+	for (int i = 0; i < ImageLayout::DIRECTORY_COUNT; ++i) {
+		if (const auto data_dir = image.data_directory(i)) {
+			DirectoryRange & dir_range = layout.directories[i];
+			dir_range.virtual_address = data_dir->virtual_address;
+			dir_range.size = data_dir->size;
+			if (dir_range.virtual_address + std::uint64_t(dir_range.size) > layout.image_size)
+				throw std::runtime_error("Invalid data directory");
+		}
+	}
+
+	for (const auto & sect_header : image.section_headers()) {
+		SectionLayout & section = layout.sections.emplace_back();
+		section.virtual_address = sect_header.virtual_address;
+		section.virtual_size = sect_header.virtual_size;
+		section.pointer_to_raw_data = sect_header.pointer_to_raw_data;
+		section.size_of_raw_data = sect_header.size_of_raw_data;
+		section.characteristics = sect_header.characteristics;
+		std::memcpy(section.name, sect_header.name, sizeof(section.name));
+
+		const std::uint64_t vdata_end = std::uint64_t(section.virtual_address)
+		                              + std::max(section.virtual_size, section.size_of_raw_data);
+		if (vdata_end > layout.image_size)
+			throw std::runtime_error("Invalid section header");
+	}
+
+	std::sort(layout.sections.begin(), layout.sections.end(),
+		[] (const auto & lhs, const auto & rhs) { return lhs.virtual_address < rhs.virtual_address; });
+	layout.sections.shrink_to_fit();
+
+	if (layout.entry_point >= layout.image_size)
+		throw std::runtime_error("Invalid image entry point");
+
+	return layout;
+}
+
+}
+
+#endif
\ No newline at end of file
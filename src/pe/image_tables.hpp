@@ -0,0 +1,330 @@
+#ifndef LOAD_SRC_PE_IMAGETABLES_HPP_
+#define LOAD_SRC_PE_IMAGETABLES_HPP_
+
+#include "image_layout.hpp"
+#include "../memory_block.hpp"
+
+#include <load/memory/memory_buffer.hpp>
+
+#include <peplus/file_image.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace load::detail {
+
+// The tables are found through the directory ranges of the ImageLayout. Images mapped into this process are
+// read through their pointer, images mapped elsewhere through the MemoryBuffer of their memory block, or
+// through their source file when the loader has not modified the table.
+
+template <class PEFileImage>
+struct PESourceImage
+{
+	const PEFileImage & file;
+	const ImageLayout & layout;
+};
+
+inline void read_pe_image_bytes(const char * image_ptr, std::size_t rva, std::size_t size, void * into_buffer)
+{
+	std::memcpy(into_buffer, image_ptr + rva, size);
+}
+
+inline void read_pe_image_bytes(const MemoryBuffer & image_mem, std::size_t rva, std::size_t size,
+                                void * into_buffer)
+{
+	if (image_mem.read(rva, size, into_buffer) != size)
+		throw std::runtime_error("Truncated image");
+}
+
+// Reads the bytes as they are once mapped: those past a section's raw data are zero
+template <class PEFileImage>
+void read_pe_image_bytes(const PESourceImage<PEFileImage> & image, std::size_t rva, std::size_t size,
+                         void * into_buffer)
+{
+	const ImageLayout & layout = image.layout;
+	char * const buffer = static_cast<char *>(into_buffer);
+	std::memset(buffer, 0, size);
+
+	for (std::size_t offs = 0; offs < size; ) {
+		const auto run_rva = static_cast<std::uint32_t>(rva + offs);
+		const SectionLayout * const section = layout.section_containing(run_rva);
+		if (section == nullptr && run_rva >= layout.headers_size)
+			throw std::runtime_error("Image table out of bounds");
+
+		const std::size_t run_end = section != nullptr
+			? section->virtual_address + std::max(section->virtual_size, section->size_of_raw_data)
+			: layout.headers_size;
+		const std::size_t run_size = std::min<std::size_t>(size - offs, run_end - run_rva);
+		if (const auto file_offs = layout.rva_to_file_offset(run_rva)) {
+			const std::size_t backed_size = section != nullptr
+				? std::min<std::size_t>(run_size, section->virtual_address + section->size_of_raw_data - run_rva)
+				: run_size;
+			image.file.read(peplus::FileOffset { *file_offs }, backed_size, buffer + offs);
+		}
+		offs += run_size;
+	}
+}
+
+inline void check_pe_image_range(const ImageLayout & layout, std::uint64_t rva, std::uint64_t size)
+{
+	if (rva > layout.image_size || size > layout.image_size - rva)
+		throw std::runtime_error("Image table out of bounds");
+}
+
+template <typename T, class ImageData>
+T read_pe_image_value(const ImageData & image, const ImageLayout & layout, std::uint64_t rva)
+{
+	check_pe_image_range(layout, rva, sizeof(T));
+
+	T value;
+	read_pe_image_bytes(image, rva, sizeof(T), &value);
+	return boost::endian::little_to_native(value);
+}
+
+template <class ImageData>
+std::string read_pe_image_string(const ImageData & image, const ImageLayout & layout, std::uint32_t rva)
+{
+	check_pe_image_range(layout, rva, 0);
+
+	std::string str;
+	char chunk[64];
+	for (std::size_t offs = rva; offs < layout.image_size; offs += sizeof(chunk)) {
+		const std::size_t chunk_size = std::min<std::size_t>(sizeof(chunk), layout.image_size - offs);
+		read_pe_image_bytes(image, offs, chunk_size, chunk);
+
+		const std::size_t str_size = strnlen(chunk, chunk_size);
+		str.append(chunk, str_size);
+		if (str_size < chunk_size) break;
+	}
+
+	return str;
+}
+
+template <class ImageData>
+std::vector<char> read_pe_directory(const ImageData & image, const ImageLayout & layout, int index)
+{
+	const DirectoryRange & dir_range = layout.directory(index);
+	std::vector<char> dir_data (dir_range.size);
+	read_pe_image_bytes(image, dir_range.virtual_address, dir_data.size(), dir_data.data());
+	return dir_data;
+}
+
+// Calls fn(block_rva, entries, entry_count) for every block of the relocation directory
+template <class ImageData, class Fn>
+void for_each_pe_relocation_block(const ImageData & image, const ImageLayout & layout, Fn && fn)
+{
+	constexpr std::size_t block_header_size = 8;
+
+	const std::vector<char> reloc_data = read_pe_directory(image, layout, peplus::DIRECTORY_ENTRY_BASERELOC);
+	for (std::size_t offs = 0; reloc_data.size() - offs >= block_header_size; ) {
+		const auto block_rva = read_le_value_from<std::uint32_t>(reloc_data.data(), offs);
+		const auto block_size = read_le_value_from<std::uint32_t>(reloc_data.data(), offs + 4);
+		if (block_size < block_header_size || block_size > reloc_data.size() - offs)
+			throw std::runtime_error("Invalid relocation block");
+
+		fn(block_rva, reloc_data.data() + offs + block_header_size, (block_size - block_header_size) / 2);
+		offs += block_size;
+	}
+}
+
+struct PEImportDescriptor
+{
+	std::uint32_t lookup_rva;
+	std::uint32_t name_rva;
+	std::uint32_t thunks_rva;
+};
+
+template <class ImageData>
+std::vector<PEImportDescriptor> read_pe_import_descriptors(const ImageData & image, const ImageLayout & layout)
+{
+	constexpr std::size_t descriptor_size = 20;
+
+	const std::vector<char> import_data = read_pe_directory(image, layout, peplus::DIRECTORY_ENTRY_IMPORT);
+	std::vector<PEImportDescriptor> descriptors;
+	for (std::size_t offs = 0; import_data.size() - offs >= descriptor_size; offs += descriptor_size) {
+		const auto original_thunks_rva = read_le_value_from<std::uint32_t>(import_data.data(), offs);
+		const auto name_rva = read_le_value_from<std::uint32_t>(import_data.data(), offs + 12);
+		const auto thunks_rva = read_le_value_from<std::uint32_t>(import_data.data(), offs + 16);
+		if (name_rva == 0 && thunks_rva == 0) break;
+
+		descriptors.push_back({ original_thunks_rva ? original_thunks_rva : thunks_rva, name_rva, thunks_rva });
+	}
+
+	return descriptors;
+}
+
+struct PEImportEntry
+{
+	std::uint32_t                thunk_rva;
+	std::optional<std::uint16_t> ordinal;
+	std::string                  name;
+};
+
+template <unsigned int XX, class ImageData>
+std::vector<PEImportEntry> read_pe_import_entries(const ImageData          & image,
+                                                  const ImageLayout        & layout,
+                                                  const PEImportDescriptor & descriptor)
+{
+	using VA = std::conditional_t<XX == 64, std::uint64_t, std::uint32_t>;
+	constexpr VA ordinal_flag = VA(1) << (8 * sizeof(VA) - 1);
+
+	std::vector<PEImportEntry> entries;
+	for (std::uint64_t i = 0; ; ++i) {
+		const auto lookup_value = read_pe_image_value<VA>(image, layout, descriptor.lookup_rva + i * sizeof(VA));
+		if (lookup_value == 0) break;
+
+		PEImportEntry & entry = entries.emplace_back();
+		entry.thunk_rva = static_cast<std::uint32_t>(descriptor.thunks_rva + i * sizeof(VA));
+		check_pe_image_range(layout, entry.thunk_rva, sizeof(VA));
+		if (lookup_value & ordinal_flag)
+			entry.ordinal = static_cast<std::uint16_t>(lookup_value);
+		else
+			entry.name = read_pe_image_string(image, layout, static_cast<std::uint32_t>(lookup_value + 2));
+	}
+
+	return entries;
+}
+
+struct PEExportDirectory
+{
+	DirectoryRange range;
+	std::uint32_t  name_rva;
+	std::uint32_t  function_count;
+	std::uint32_t  name_count;
+	std::uint32_t  functions_rva;
+	std::uint32_t  names_rva;
+	std::uint32_t  ordinals_rva;
+};
+
+template <class ImageData>
+std::optional<PEExportDirectory> read_pe_export_directory(const ImageData & image, const ImageLayout & layout)
+{
+	const DirectoryRange & export_range = layout.directory(peplus::DIRECTORY_ENTRY_EXPORT);
+	if (export_range.size < 40) return std::nullopt;
+
+	char export_dir[40];
+	read_pe_image_bytes(image, export_range.virtual_address, sizeof(export_dir), export_dir);
+
+	PEExportDirectory export_info;
+	export_info.range = export_range;
+	export_info.name_rva = read_le_value_from<std::uint32_t>(export_dir, 12);
+	export_info.function_count = read_le_value_from<std::uint32_t>(export_dir, 20);
+	export_info.name_count = read_le_value_from<std::uint32_t>(export_dir, 24);
+	export_info.functions_rva = read_le_value_from<std::uint32_t>(export_dir, 28);
+	export_info.names_rva = read_le_value_from<std::uint32_t>(export_dir, 32);
+	export_info.ordinals_rva = read_le_value_from<std::uint32_t>(export_dir, 36);
+	check_pe_image_range(layout, export_info.functions_rva, std::uint64_t(export_info.function_count) * 4);
+	check_pe_image_range(layout, export_info.names_rva, std::uint64_t(export_info.name_count) * 4);
+	check_pe_image_range(layout, export_info.ordinals_rva, std::uint64_t(export_info.name_count) * 2);
+	return export_info;
+}
+
+// Returns the RVA of the n-th named export's function, or nothing when its ordinal is out of range
+template <class ImageData>
+std::optional<std::uint32_t> pe_named_export_rva(const ImageData         & image,
+                                                 const ImageLayout       & layout,
+                                                 const PEExportDirectory & export_dir,
+                                                 std::uint32_t             name_index)
+{
+	const auto ordinal = read_pe_image_value<std::uint16_t>(image, layout, export_dir.ordinals_rva + name_index * 2);
+	if (ordinal >= export_dir.function_count) return std::nullopt;
+	return read_pe_image_value<std::uint32_t>(image, layout, export_dir.functions_rva + ordinal * 4);
+}
+
+// Export names are sorted, so the lookup is a binary search over the name pointer table
+template <class ImageData>
+std::optional<std::uint32_t> find_pe_export_rva(const ImageData         & image,
+                                                const ImageLayout       & layout,
+                                                const PEExportDirectory & export_dir,
+                                                std::string_view          name)
+{
+	std::uint32_t first = 0;
+	std::uint32_t count = export_dir.name_count;
+	while (count > 0) {
+		const std::uint32_t step = count / 2;
+		const auto name_rva = read_pe_image_value<std::uint32_t>(image, layout,
+		                                                         export_dir.names_rva + (first + step) * 4);
+		const int order = read_pe_image_string(image, layout, name_rva).compare(name);
+		if (order == 0)
+			return pe_named_export_rva(image, layout, export_dir, first + step);
+
+		if (order < 0) {
+			first += step + 1;
+			count -= step + 1;
+		} else {
+			count = step;
+		}
+	}
+
+	return std::nullopt;
+}
+
+struct PETlsDirectory
+{
+	std::uint64_t raw_data_begin;
+	std::uint64_t raw_data_end;
+	std::uint64_t callbacks_address;
+	std::uint32_t zero_fill_size;
+	std::uint32_t characteristics;
+};
+
+template <unsigned int XX, class ImageData>
+PETlsDirectory read_pe_tls_directory(const ImageData & image, const ImageLayout & layout)
+{
+	using VA = std::conditional_t<XX == 64, std::uint64_t, std::uint32_t>;
+
+	const DirectoryRange & tls_range = layout.directory(peplus::DIRECTORY_ENTRY_TLS);
+	if (tls_range.size < 4 * sizeof(VA) + 8)
+		throw std::runtime_error("Invalid TLS directory");
+
+	char tls_dir[4 * sizeof(VA) + 8];
+	read_pe_image_bytes(image, tls_range.virtual_address, sizeof(tls_dir), tls_dir);
+
+	PETlsDirectory tls_info;
+	tls_info.raw_data_begin = read_le_value_from<VA>(tls_dir, 0);
+	tls_info.raw_data_end = read_le_value_from<VA>(tls_dir, sizeof(VA));
+	tls_info.callbacks_address = read_le_value_from<VA>(tls_dir, 3 * sizeof(VA));
+	tls_info.zero_fill_size = read_le_value_from<std::uint32_t>(tls_dir, 4 * sizeof(VA));
+	tls_info.characteristics = read_le_value_from<std::uint32_t>(tls_dir, 4 * sizeof(VA) + 4);
+	return tls_info;
+}
+
+// Reads the callback addresses of a relocated image, which are absolute within the image's own mapping
+template <unsigned int XX, class ImageData>
+std::vector<std::uintptr_t> read_pe_tls_callbacks(const ImageData   & image,
+                                                  const ImageLayout & layout,
+                                                  std::uintptr_t      image_addr)
+{
+	using VA = std::conditional_t<XX == 64, std::uint64_t, std::uint32_t>;
+
+	std::vector<std::uintptr_t> tls_callbacks;
+	if (!layout.directory(peplus::DIRECTORY_ENTRY_TLS)) return tls_callbacks;
+
+	const PETlsDirectory tls_info = read_pe_tls_directory<XX>(image, layout);
+	if (tls_info.callbacks_address == 0) return tls_callbacks;
+	if (tls_info.callbacks_address < image_addr)
+		throw std::runtime_error("Invalid TLS directory");
+
+	const std::uint64_t callbacks_rva = tls_info.callbacks_address - image_addr;
+	for (std::uint64_t i = 0; ; ++i) {
+		const auto callback_addr = read_pe_image_value<VA>(image, layout, callbacks_rva + i * sizeof(VA));
+		if (callback_addr == 0) break;
+		if (callback_addr < image_addr || callback_addr - image_addr >= layout.image_size)
+			throw std::runtime_error("Invalid TLS callback");
+		tls_callbacks.push_back(static_cast<std::uintptr_t>(callback_addr));
+	}
+
+	return tls_callbacks;
+}
+
+}
+
+#endif
\ No newline at end of file
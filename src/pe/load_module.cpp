@@ -1,52 +1,210 @@
 #include "image.hpp"
 #include "module.hpp"
+#include "../load_result.hpp"
+#include "../module_format.hpp"
+
+#include <cstring>
 
 namespace load::detail {
 
-template <unsigned int XX>
-std::shared_ptr<OwnedPEModule<XX>> load_pe_module(const MemoryBuffer & image_data,
-                                                  ModuleProvider     & module_provider,
-                                                  Process            & into_process)
+template <unsigned int XX, class Buffer>
+std::shared_ptr<OwnedPEModule<XX>> load_pe_module(const peplus::FileImage<XX, Buffer> & src_image,
+                                                  const LoadOptions                   & options,
+                                                  ModuleProvider                      & module_provider,
+                                                  Process                             & into_process,
+                                                  LoadFailure                         * failure)
 {
+	ImageLayout image_layout = decode_pe_image_layout(src_image);
+
 	ModuleCache module_cache { module_provider };
 	MemoryManager & mem_manager = into_process.memory_manager();
-	OwnedMemoryBlock image_mem = load_pe_image<XX>(image_data, mem_manager, module_cache);
-	initialize_dll(peplus::VirtualImage<XX, any_buffer>(image_mem), into_process, image_mem);
 
-	auto module = std::make_shared<OwnedPEModule<XX>>(into_process, image_mem.data(),
-	                                                  image_mem.size(), std::move(module_cache));
+	std::unique_ptr<AbiBridge> abi_bridge;
+	if (XX == 64 && mem_manager.allows_direct_addressing())
+		abi_bridge = make_abi_bridge(ModuleAbi::Windows, native_module_abi);
+
+	std::unique_ptr<ImportCallCounters> call_counters;
+	if (options.call_instrumentation != CallInstrumentation::None) {
+		if (XX != 64 || !mem_manager.allows_direct_addressing())
+			throw std::logic_error("Unsupported call instrumentation");
+		call_counters = make_import_call_counters(options.call_instrumentation);
+	}
+
+	// Dependencies loaded while linking the image join this scope's batch when the process is remote
+	DllInitScope init_scope { into_process };
+
+	TlsSlot tls_slot;
+	OwnedMemoryBlock image_mem = load_pe_image<XX>(src_image, image_layout, mem_manager, module_cache,
+	                                               options.observer, abi_bridge.get(), &tls_slot,
+	                                               call_counters.get(), options.import_resolver, failure);
+	if (has_load_failure(failure)) return nullptr;
+
+	const bool direct_access = mem_manager.allows_direct_addressing();
+	if (direct_access) {
+		LoadPhaseScope init_phase { options.observer, LoadPhase::Initialize };
+		if (!initialize_dll<XX>(image_layout, into_process, image_mem, tls_slot)) {
+			deregister_pe_image_exception_table(image_layout, into_process, image_mem.data());
+			report_load_failure(failure, LoadError::InitializationFailed, "DLL initialization failed");
+			return nullptr;
+		}
+	} else {
+		register_pe_image_exception_table(image_layout, into_process, image_mem.data());
+	}
+
+	// A remote load queues DllMain after the module takes the layout, so it keeps a copy
+	auto module = std::make_shared<OwnedPEModule<XX>>(into_process, image_mem.data(), image_mem.size(),
+	                                                  direct_access ? std::move(image_layout) : image_layout,
+	                                                  std::move(module_cache), std::move(abi_bridge),
+	                                                  std::move(tls_slot), std::move(call_counters));
+	if (!direct_access) {
+		module->set_initialized(false);
+		init_scope.add_module<XX>(image_mem, image_layout, [module] { module->set_initialized(true); });
+	}
 	image_mem.release();
+	if (direct_access || !init_scope.is_outermost()) return module;
+
+	LoadPhaseScope init_phase { options.observer, LoadPhase::Initialize };
+	const std::size_t module_count = init_scope.module_count();
+	if (init_scope.run() != module_count) {
+		report_load_failure(failure, LoadError::InitializationFailed, "DLL initialization failed");
+		return nullptr;
+	}
 	return module;
 }
 
+template <unsigned int XX>
+std::shared_ptr<OwnedPEModule<XX>> load_pe_module(const MemoryBuffer & image_data,
+                                                  const LoadOptions  & options,
+                                                  ModuleProvider     & module_provider,
+                                                  Process            & into_process,
+                                                  LoadFailure        * failure)
+{
+	if (const char * const data = image_data.contiguous_data()) {
+		const MemorySpan image_span { data, image_data.contiguous_size() };
+		const peplus::FileImage<XX, span_buffer> src_image { image_span };
+		return load_pe_module(src_image, options, module_provider, into_process, failure);
+	} else {
+		const peplus::FileImage<XX, any_buffer> src_image { image_data };
+		return load_pe_module(src_image, options, module_provider, into_process, failure);
+	}
+}
+
+namespace {
+
+constexpr std::size_t   PE_NT_HEADERS_OFFSET     = 0x3c;
+constexpr std::size_t   PE_MACHINE_OFFSET        = 4;
+constexpr std::size_t   PE_OPTIONAL_MAGIC_OFFSET = 4 + 20;
+constexpr std::uint16_t PE32_OPTIONAL_MAGIC      = 0x10b;
+constexpr std::uint16_t PE64_OPTIONAL_MAGIC      = 0x20b;
+constexpr std::uint16_t PE_MACHINE_I386          = 0x14c;
+constexpr std::uint16_t PE_MACHINE_AMD64         = 0x8664;
+
+template <typename T>
+T read_header_field(const char * header, std::size_t offset)
+{
+	T value;
+	std::memcpy(&value, header + offset, sizeof(value));
+	return value;
+}
+
+// Only looks at the signature, optional header magic and machine; the loader validates the rest
+template <unsigned int XX>
+ModuleFormatError probe_pe_header(const char * header, std::size_t header_size)
+{
+	if (header_size < PE_NT_HEADERS_OFFSET + 4) return ModuleFormatError::TruncatedHeaders;
+	const std::uint32_t nt_offset = read_header_field<std::uint32_t>(header, PE_NT_HEADERS_OFFSET);
+	if (nt_offset > header_size - PE_OPTIONAL_MAGIC_OFFSET - 2) return ModuleFormatError::TruncatedHeaders;
+	if (std::memcmp(header + nt_offset, "PE\0\0", 4) != 0) return ModuleFormatError::UnknownFormat;
+
+	const auto optional_magic = read_header_field<std::uint16_t>(header, nt_offset + PE_OPTIONAL_MAGIC_OFFSET);
+	if (optional_magic != PE32_OPTIONAL_MAGIC && optional_magic != PE64_OPTIONAL_MAGIC)
+		return ModuleFormatError::UnknownFormat;
+
+	const auto machine = read_header_field<std::uint16_t>(header, nt_offset + PE_MACHINE_OFFSET);
+	if (optional_magic != (XX == 64 ? PE64_OPTIONAL_MAGIC : PE32_OPTIONAL_MAGIC) ||
+	    machine != (XX == 64 ? PE_MACHINE_AMD64 : PE_MACHINE_I386))
+		return ModuleFormatError::UnsupportedMachine;
+	return ModuleFormatError::None;
+}
+
+template <unsigned int XX>
+class PEModuleFormat final : public ModuleFormat
+{
+public:
+	virtual std::string_view name() const override
+	{
+		return XX == 64 ? "pe64" : "pe32";
+	}
+
+	virtual std::string_view magic() const override
+	{
+		return "MZ";
+	}
+
+	virtual ModuleFormatError probe(const char * header, std::size_t header_size) const override
+	{
+		return probe_pe_header<XX>(header, header_size);
+	}
+
+	virtual std::shared_ptr<Module> load(const MemoryBuffer & module_data,
+	                                     const LoadOptions  & options,
+	                                     ModuleProvider     & module_provider,
+	                                     Process            & into_process) const override
+	{
+		return load_or_throw([&] (LoadFailure * failure) {
+			return load_pe_module<XX>(module_data, options, module_provider, into_process, failure);
+		});
+	}
+
+	virtual LoadResult try_load(const MemoryBuffer & module_data,
+	                            const LoadOptions  & options,
+	                            ModuleProvider     & module_provider,
+	                            Process            & into_process) const override
+	{
+		return catch_load_failure([&] (LoadFailure * failure) {
+			return load_pe_module<XX>(module_data, options, module_provider, into_process, failure);
+		});
+	}
+};
+
+}
+
 #ifdef LIBLOAD_ENABLE_FORMAT_PE64
 
-bool is_valid_pe_module_64(const MemoryBuffer & image_data)
+const ModuleFormat & pe64_module_format()
 {
-	return peplus::FileImage64<any_buffer>::is_valid(image_data);
+	static const PEModuleFormat<64> format;
+	return format;
 }
 
 std::shared_ptr<OwnedPEModule<64>> load_pe_module_64(const MemoryBuffer & image_data,
+                                                     const LoadOptions  & options,
                                                      ModuleProvider     & mod_provider,
                                                      Process            & into_process)
 {
-	return load_pe_module<64>(image_data, mod_provider, into_process);
+	return load_or_throw([&] (LoadFailure * failure) {
+		return load_pe_module<64>(image_data, options, mod_provider, into_process, failure);
+	});
 }
 
 #endif
 
 #ifdef LIBLOAD_ENABLE_FORMAT_PE32
 
-bool is_valid_pe_module_32(const MemoryBuffer & image_data)
+const ModuleFormat & pe32_module_format()
 {
-	return peplus::FileImage32<any_buffer>::is_valid(image_data);
+	static const PEModuleFormat<32> format;
+	return format;
 }
 
 std::shared_ptr<OwnedPEModule<32>> load_pe_module_32(const MemoryBuffer & image_data,
+                                                     const LoadOptions  & options,
                                                      ModuleProvider     & mod_provider,
                                                      Process            & into_process)
 {
-	return load_pe_module<32>(image_data, mod_provider, into_process);
+	return load_or_throw([&] (LoadFailure * failure) {
+		return load_pe_module<32>(image_data, options, mod_provider, into_process, failure);
+	});
 }
 
 #endif
@@ -3,7 +3,11 @@
 
 #include "image.hpp"
 #include "../memory_block.hpp"
+#include "../module_registry.hpp"
+#include "../perf_map.hpp"
 #include "../module_provider.hpp"
+#include "../tls_entry_thunks.hpp"
+#include <load/module/load_options.hpp>
 #include <load/module/module.hpp>
 
 #include <peplus/any_buffer.hpp>
@@ -26,34 +30,63 @@ class PEBasicModule : public Module
 public:
 	using module_memory = MemoryBlock<MemoryOwnership>;
 
-	PEBasicModule(module_memory module_memory,
-	              ModuleCache   module_cache);
+	PEBasicModule(module_memory              module_memory,
+	              ImageLayout                image_layout,
+	              ModuleCache                module_cache,
+	              std::unique_ptr<AbiBridge> abi_bridge = nullptr,
+	              TlsSlot                    tls_slot = TlsSlot());
+
+	virtual ModuleMemoryStats memory_stats() const override;
+	virtual ModuleAbi abi() const override;
+	virtual void * tls_data() const override;
 
 protected:
 	virtual DataPtr get_data_address(std::string_view name) const override;
 	virtual ProcPtr get_proc_address(std::string_view name) const override;
 
-	const void * find_symbol(std::string_view name) const;
+	const void * find_symbol(std::string_view name, bool is_proc) const;
+
+	MemoryBlock<MemoryOwnership>    _image_mem;
+	ImageLayout                     _image_layout;
+	mutable ModuleCache             _module_cache;
+	std::unique_ptr<AbiBridge>      _abi_bridge;
+	TlsSlot                         _tls_slot;
+	std::unique_ptr<TlsEntryThunks> _entry_thunks;
 
-	MemoryBlock<MemoryOwnership>         _image_mem;
-	peplus::VirtualImage<XX, any_buffer> _module_image;
-	mutable ModuleCache                  _module_cache;
+private:
+	template <class ImageData>
+	const void * find_symbol(const ImageData & image, std::string_view name, bool is_proc) const;
 };
 
 template <unsigned int XX>
 class OwnedPEModule final : public PEBasicModule<XX, owned_memory>
 {
 public:
-	OwnedPEModule(Process   & process,
-	              void      * image_ptr,
-	              std::size_t image_size,
-	              ModuleCache module_cache);
+	OwnedPEModule(Process                           & process,
+	              void                              * image_ptr,
+	              std::size_t                         image_size,
+	              ImageLayout                         image_layout,
+	              ModuleCache                         module_cache,
+	              std::unique_ptr<AbiBridge>          abi_bridge,
+	              TlsSlot                             tls_slot,
+	              std::unique_ptr<ImportCallCounters> call_counters = nullptr);
 
 	OwnedPEModule(OwnedPEModule && other);
 	virtual ~OwnedPEModule();
 
+	virtual ModuleCallStats call_stats() const override;
+	virtual FunctionHook hook_proc(std::string_view name, const void * replacement) override;
+
+	// Modules initialized by a deferred DllInitScope batch are not notified on unload unless it succeeded
+	void set_initialized(bool initialized) { _initialized = initialized; }
+
 private:
-	Process * _process;
+	void register_module_range();
+
+	Process                           * _process;
+	bool                                _initialized;
+	bool                                _registered;
+	std::unique_ptr<ImportCallCounters> _call_counters;
 };
 
 template <unsigned int XX>
@@ -68,9 +101,8 @@ public:
 
 #ifdef LIBLOAD_ENABLE_FORMAT_PE64
 
-	bool is_valid_pe_module_64(const MemoryBuffer & image_data);
-
 	std::shared_ptr<OwnedPEModule<64>> load_pe_module_64(const MemoryBuffer & image_data,
+	                                                     const LoadOptions  & options,
 	                                                     ModuleProvider     & module_provider,
 	                                                     Process            & into_process);
 
@@ -78,9 +110,8 @@ public:
 
 #ifdef LIBLOAD_ENABLE_FORMAT_PE32
 
-	bool is_valid_pe_module_32(const MemoryBuffer & image_data);
-
 	std::shared_ptr<OwnedPEModule<32>> load_pe_module_32(const MemoryBuffer & image_data,
+	                                                     const LoadOptions  & options,
 	                                                     ModuleProvider     & module_provider,
 	                                                     Process            & into_process);
 
@@ -90,38 +121,80 @@ std::optional<std::pair<std::string, std::string>>
 	parse_pe_forwarder_string(std::string_view fwd_string);
 
 template <unsigned int XX, class MO>
-PEBasicModule<XX, MO>::PEBasicModule(module_memory module_data,
-                                     ModuleCache   module_cache)
+PEBasicModule<XX, MO>::PEBasicModule(module_memory              module_data,
+                                     ImageLayout                image_layout,
+                                     ModuleCache                module_cache,
+                                     std::unique_ptr<AbiBridge> abi_bridge,
+                                     TlsSlot                    tls_slot)
 	: _image_mem { std::move(module_data) }
-	, _module_image { _image_mem }
+	, _image_layout { std::move(image_layout) }
 	, _module_cache { std::move(module_cache) }
+	, _abi_bridge { std::move(abi_bridge) }
+	, _tls_slot { std::move(tls_slot) }
+	, _entry_thunks { _tls_slot ? make_tls_entry_thunks(_tls_slot.index()) : nullptr }
 {}
 
+template <unsigned int XX, class MO>
+ModuleMemoryStats PEBasicModule<XX, MO>::memory_stats() const
+{
+	ModuleMemoryStats mem_stats = pe_image_memory_stats(_image_layout, _image_mem);
+	mem_stats.metadata_size = sizeof(*this) - sizeof(_image_layout) - sizeof(_module_cache)
+	                        + _image_layout.memory_footprint() + _module_cache.memory_footprint();
+	return mem_stats;
+}
+
+template <unsigned int XX, class MO>
+ModuleAbi PEBasicModule<XX, MO>::abi() const
+{
+	return ModuleAbi::Windows;
+}
+
+template <unsigned int XX, class MO>
+void * PEBasicModule<XX, MO>::tls_data() const
+{
+	if (!_image_layout.directory(peplus::DIRECTORY_ENTRY_TLS)) return nullptr;
+	return _tls_slot.thread_block();
+}
+
 template <unsigned int XX, class MO>
 DataPtr PEBasicModule<XX, MO>::get_data_address(std::string_view name) const
 {
-	return reinterpret_cast<DataPtr>(find_symbol(name));
+	return reinterpret_cast<DataPtr>(find_symbol(name, false));
 }
 
 template <unsigned int XX, class MO>
 ProcPtr PEBasicModule<XX, MO>::get_proc_address(std::string_view name) const
 {
-	return reinterpret_cast<ProcPtr>(find_symbol(name));
+	return reinterpret_cast<ProcPtr>(find_symbol(name, true));
+}
+
+template <unsigned int XX, class MO>
+const void * PEBasicModule<XX, MO>::find_symbol(std::string_view name, bool is_proc) const
+{
+	if (_image_mem.memory_manager().allows_direct_addressing())
+		return find_symbol(static_cast<const char *>(_image_mem.data()), name, is_proc);
+	return find_symbol(_image_mem, name, is_proc);
 }
 
 template <unsigned int XX, class MO>
-const void * PEBasicModule<XX, MO>::find_symbol(std::string_view name) const
+template <class ImageData>
+const void * PEBasicModule<XX, MO>::find_symbol(const ImageData & image, std::string_view name, bool is_proc) const
 {
-	const auto export_dir = _module_image.export_directory();
+	const auto export_dir = read_pe_export_directory(image, _image_layout);
 	if (!export_dir) return nullptr;
 
-	const auto export_info = export_dir->find(name);
-	if (!export_info) return nullptr;
+	const auto symbol_rva = find_pe_export_rva(image, _image_layout, *export_dir, name);
+	if (!symbol_rva || *symbol_rva == 0) return nullptr;
 
-	if (!export_info->is_forwarded) {
-		return _image_mem.data() + export_info->address.value();
+	if (!export_dir->range.contains(*symbol_rva)) {
+		const void * symbol_addr = _image_mem.data() + *symbol_rva;
+		if (!is_proc) return symbol_addr;
+
+		if (_entry_thunks)
+			symbol_addr = _entry_thunks->entry_thunk(symbol_addr);
+		return _abi_bridge ? _abi_bridge->export_thunk(symbol_addr) : symbol_addr;
 	} else {
-		const std::string_view fwd_string = *export_info->forwarder_string;
+		const std::string fwd_string = read_pe_image_string(image, _image_layout, *symbol_rva);
 		const auto fwd_string_parts = parse_pe_forwarder_string(fwd_string);
 		if (!fwd_string_parts) return nullptr;
 
@@ -129,35 +202,103 @@ const void * PEBasicModule<XX, MO>::find_symbol(std::string_view name) const
 		const auto fwd_modsp = _module_cache.get_module(fwd_name);
 		if (fwd_modsp == nullptr) return nullptr;
 
-		return fwd_modsp->get_data<void>(fwd_sym);
+		if (is_proc)
+			return reinterpret_cast<const void *>(fwd_modsp->template get_proc<void ()>(fwd_sym));
+
+		// Importers of this module call the forwarded procedure with the module's calling convention
+		const void * const fwd_addr = fwd_modsp->get_data<void>(fwd_sym);
+		if (fwd_addr && _abi_bridge && fwd_modsp->abi() != _abi_bridge->module_abi())
+			return _abi_bridge->import_thunk(fwd_addr);
+		return fwd_addr;
 	}
 }
 
 template <unsigned int XX>
-OwnedPEModule<XX>::OwnedPEModule(Process   & process,
-                                 void      * image_ptr,
-                                 std::size_t image_size,
-                                 ModuleCache module_cache)
+OwnedPEModule<XX>::OwnedPEModule(Process                           & process,
+                                 void                              * image_ptr,
+                                 std::size_t                         image_size,
+                                 ImageLayout                         image_layout,
+                                 ModuleCache                         module_cache,
+                                 std::unique_ptr<AbiBridge>          abi_bridge,
+                                 TlsSlot                             tls_slot,
+                                 std::unique_ptr<ImportCallCounters> call_counters)
 	: PEBasicModule {
 		OwnedMemoryBlock(process.memory_manager(), image_ptr, image_size),
-		std::move(module_cache)
+		std::move(image_layout),
+		std::move(module_cache),
+		std::move(abi_bridge),
+		std::move(tls_slot)
 	  }
 	, _process { &process }
-{}
+	, _initialized { true }
+	, _registered { false }
+	, _call_counters { std::move(call_counters) }
+{
+	register_module_range();
+}
 
 template <unsigned int XX>
 OwnedPEModule<XX>::OwnedPEModule(OwnedPEModule && other)
 	: PEBasicModule { std::move(other) }
 	, _process { other._process }
+	, _initialized { other._initialized }
+	, _registered { false }
+	, _call_counters { std::move(other._call_counters) }
 {
 	other._process = nullptr;
+	if (std::exchange(other._registered, false)) {
+		module_registry().set_module(reinterpret_cast<std::uintptr_t>(this->_image_mem.data()), this);
+		if (PerfMap * const map = perf_map())
+			map->transfer(&other, this);
+		_registered = true;
+	}
 }
 
 template <unsigned int XX>
 OwnedPEModule<XX>::~OwnedPEModule()
 {
-	if (_process != nullptr)
-		deinitialize_dll(_module_image, *_process, _image_mem);
+	if (_process != nullptr && _initialized)
+		deinitialize_dll<XX>(this->_image_layout, *_process, this->_image_mem, this->_tls_slot);
+	else if (_process != nullptr)
+		deregister_pe_image_exception_table(this->_image_layout, *_process, this->_image_mem.data());
+	if (_registered) {
+		module_registry().remove(reinterpret_cast<std::uintptr_t>(this->_image_mem.data()));
+		if (PerfMap * const map = perf_map())
+			map->remove(this);
+	}
+}
+
+template <unsigned int XX>
+ModuleCallStats OwnedPEModule<XX>::call_stats() const
+{
+	return _call_counters ? _call_counters->stats() : ModuleCallStats();
+}
+
+template <unsigned int XX>
+FunctionHook OwnedPEModule<XX>::hook_proc(std::string_view name, const void * replacement)
+{
+	if (_process == nullptr)
+		throw std::logic_error("Module was moved from");
+	if (!_process->memory_manager().allows_direct_addressing())
+		throw std::logic_error("Only modules mapped into the current process can be patched");
+
+	const void * const proc = this->find_symbol(name, false);
+	if (proc == nullptr)
+		throw std::invalid_argument("Procedure not found");
+
+	return hook_function(const_cast<void *>(proc), replacement, this->abi());
+}
+
+template <unsigned int XX>
+void OwnedPEModule<XX>::register_module_range()
+{
+	if (!_process->memory_manager().allows_direct_addressing()) return;
+
+	module_registry().add(pe_image_module_range(this->_image_layout, this->_image_mem.data(), this));
+	_registered = true;
+
+	if (PerfMap * const map = perf_map())
+		map->add(this, pe_image_perf_map_entries(this->_image_layout, this->_image_mem.data()));
 }
 
 template <unsigned int XX>
@@ -167,6 +308,9 @@ BorrowedPEModule<XX>::BorrowedPEModule(const Process  & process,
                                        ModuleProvider & module_provider)
 	: PEBasicModule<XX, borrowed_memory> {
 		BorrowedMemoryBlock(process.memory_manager(), image_ptr, image_size),
+		decode_pe_image_layout(peplus::VirtualImage<XX, any_buffer> {
+			BorrowedMemoryBlock(process.memory_manager(), image_ptr, image_size)
+		}),
 		ModuleCache(module_provider)
 	}
 {}
@@ -0,0 +1,155 @@
+#include "perf_map.hpp"
+
+#include <load/process/process.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+#include <utility>
+
+namespace load {
+
+using namespace detail;
+
+namespace {
+
+std::atomic<bool> & perf_map_enabled()
+{
+	static std::atomic<bool> enabled { [] {
+		const char * const env_value = std::getenv("LIBLOAD_PERF_MAP");
+		return env_value != nullptr && *env_value != '\0' && std::string_view(env_value) != "0";
+	}() };
+	return enabled;
+}
+
+PerfMap & process_perf_map()
+{
+	static PerfMap perf_map { default_perf_map_path() };
+	return perf_map;
+}
+
+void write_perf_map_entries(std::ostream & stream, const std::vector<PerfMapEntry> & entries)
+{
+	for (const PerfMapEntry & entry : entries)
+		stream << std::hex << entry.address << ' ' << entry.size << std::dec << ' ' << entry.name << '\n';
+}
+
+}
+
+void enable_perf_map()
+{
+	perf_map_enabled() = true;
+}
+
+void disable_perf_map()
+{
+	if (perf_map_enabled().exchange(false))
+		process_perf_map().clear();
+}
+
+bool is_perf_map_enabled()
+{
+	return perf_map_enabled();
+}
+
+namespace detail {
+
+PerfMap::PerfMap(std::string path)
+	: _path { std::move(path) } {}
+
+const std::string & PerfMap::path() const
+{
+	return _path;
+}
+
+void PerfMap::add(const void * owner, std::vector<PerfMapEntry> entries)
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+
+	std::ofstream map_stream { _path, std::ios::app };
+	write_perf_map_entries(map_stream, entries);
+
+	std::vector<PerfMapEntry> & owner_entries = _entries[owner];
+	owner_entries.insert(owner_entries.end(), std::make_move_iterator(entries.begin()),
+	                     std::make_move_iterator(entries.end()));
+}
+
+void PerfMap::remove(const void * owner)
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+	if (_entries.erase(owner) != 0)
+		rewrite();
+}
+
+void PerfMap::remove(const void * owner, std::uintptr_t address)
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+
+	const auto owner_it = _entries.find(owner);
+	if (owner_it == _entries.end()) return;
+
+	std::vector<PerfMapEntry> & owner_entries = owner_it->second;
+	const auto entry_it = std::find_if(owner_entries.begin(), owner_entries.end(),
+		[=] (const PerfMapEntry & entry) { return entry.address == address; });
+	if (entry_it == owner_entries.end()) return;
+
+	owner_entries.erase(entry_it);
+	if (owner_entries.empty())
+		_entries.erase(owner_it);
+	rewrite();
+}
+
+void PerfMap::transfer(const void * from_owner, const void * to_owner)
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+
+	auto owner_node = _entries.extract(from_owner);
+	if (owner_node.empty()) return;
+
+	std::vector<PerfMapEntry> & owner_entries = _entries[to_owner];
+	owner_entries.insert(owner_entries.end(), std::make_move_iterator(owner_node.mapped().begin()),
+	                     std::make_move_iterator(owner_node.mapped().end()));
+}
+
+void PerfMap::clear()
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+	_entries.clear();
+}
+
+void PerfMap::rewrite() const
+{
+	// perf has no notion of retired symbols, so the map is replaced by the live entries.
+	// Runs during unloads, so failures leave the previous map in place instead of throwing.
+	const std::string temp_path = _path + ".tmp";
+	std::ofstream map_stream { temp_path, std::ios::trunc };
+	for (const auto & [owner, entries] : _entries)
+		write_perf_map_entries(map_stream, entries);
+	map_stream.close();
+
+	if (!map_stream || std::rename(temp_path.c_str(), _path.c_str()) != 0)
+		std::remove(temp_path.c_str());
+}
+
+std::string default_perf_map_path()
+{
+	const std::string file_name = "perf-" + std::to_string(current_process().process_id()) + ".map";
+#if defined(__linux__)
+	return "/tmp/" + file_name;
+#else
+	return (std::filesystem::temp_directory_path() / file_name).string();
+#endif
+}
+
+PerfMap * perf_map()
+{
+	return perf_map_enabled() ? &process_perf_map() : nullptr;
+}
+
+}
+
+}
\ No newline at end of file
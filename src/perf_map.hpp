@@ -0,0 +1,54 @@
+#ifndef LOAD_SRC_PERFMAP_HPP_
+#define LOAD_SRC_PERFMAP_HPP_
+
+#include <load/module/perf_map.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace load::detail {
+
+struct PerfMapEntry
+{
+	std::uintptr_t address;
+	std::size_t    size;
+	std::string    name;
+};
+
+class PerfMap
+{
+public:
+	explicit PerfMap(std::string path);
+	PerfMap(const PerfMap &) = delete;
+	PerfMap & operator=(const PerfMap &) = delete;
+
+	const std::string & path() const;
+
+	void add(const void * owner, std::vector<PerfMapEntry> entries);
+	void remove(const void * owner);
+	void remove(const void * owner, std::uintptr_t address);
+	// Moves the entries of one owner to another; the map file is unchanged
+	void transfer(const void * from_owner, const void * to_owner);
+	void clear();
+
+private:
+	void rewrite() const;
+
+	mutable std::mutex                                          _mutex;
+	std::string                                                 _path;
+	std::unordered_map<const void *, std::vector<PerfMapEntry>> _entries;
+};
+
+std::string default_perf_map_path();
+
+// The process-wide map while enabled, otherwise nullptr
+PerfMap * perf_map();
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,10 @@
+#ifndef LOAD_SRC_PLATFORM_CODEADDRESS_HPP_
+#define LOAD_SRC_PLATFORM_CODEADDRESS_HPP_
+
+namespace load::detail {
+
+bool is_code_address(const void * address);
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,14 @@
+#ifndef LOAD_SRC_PLATFORM_CODEPATCHING_HPP_
+#define LOAD_SRC_PLATFORM_CODEPATCHING_HPP_
+
+namespace load::detail {
+
+// Makes every thread of the process refetch instructions before it runs patched code
+void serialize_instruction_streams();
+
+// Returns the MemoryManager access flags the page containing the address is mapped with
+int code_page_access(const void * address);
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,20 @@
+#ifndef LOAD_SRC_PLATFORM_DUALMAPPING_HPP_
+#define LOAD_SRC_PLATFORM_DUALMAPPING_HPP_
+
+#include <cstddef>
+
+namespace load::detail {
+
+struct DualMapping
+{
+	char        * writable;
+	char        * executable;
+	std::size_t   size;
+};
+
+DualMapping create_dual_mapping(std::size_t size);
+void release_dual_mapping(const DualMapping & mapping);
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,20 @@
+#include "../code_address.hpp"
+
+#include <dlfcn.h>
+#include <link.h>
+
+namespace load::detail {
+
+bool is_code_address(const void * address)
+{
+	Dl_info symbol_info;
+	void * symbol_entry = nullptr;
+	if (!dladdr1(address, &symbol_info, &symbol_entry, RTLD_DL_SYMENT) || symbol_entry == nullptr)
+		return false;
+
+	const auto symbol = static_cast<const ElfW(Sym) *>(symbol_entry);
+	const unsigned char symbol_type = ELF64_ST_TYPE(symbol->st_info);
+	return symbol_type == STT_FUNC || symbol_type == STT_GNU_IFUNC;
+}
+
+}
\ No newline at end of file
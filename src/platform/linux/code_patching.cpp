@@ -0,0 +1,47 @@
+#include "../code_patching.hpp"
+#include "memory_access.hpp"
+
+#include <load/memory/memory_manager.hpp>
+
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace load::detail {
+
+void serialize_instruction_streams()
+{
+	static const bool registered =
+		syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED_SYNC_CORE, 0, 0) == 0;
+
+	// Without sync-core membarriers the aligned patch store is still observed atomically
+	if (registered)
+		syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED_SYNC_CORE, 0, 0);
+}
+
+int code_page_access(const void * address)
+{
+	const auto addr = reinterpret_cast<std::uintptr_t>(address);
+	std::ifstream maps { "/proc/self/maps" };
+	std::string line;
+	while (std::getline(maps, line)) {
+		std::istringstream fields { line };
+		std::uintptr_t begin, end;
+		char separator;
+		std::string permissions;
+		fields >> std::hex >> begin >> separator >> end >> permissions;
+		if (addr < begin || addr >= end || permissions.size() < 3) continue;
+
+		return memory_access_from_permissions(permissions);
+	}
+
+	throw std::invalid_argument("Address is not mapped");
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include <load/memory/memory_manager.hpp>
+#include <load/module/module_provider.hpp>
+
+#include "system_module.hpp"
+#include "memory_access.hpp"
+#include "current_process.hpp"
+#include "../../arch/code_generator.hpp"
+
+#include <dlfcn.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <memory>
+#include <system_error>
+
+namespace load {
+
+using namespace detail;
+
+Process & current_process()
+{
+	static CurrentProcess current_process;
+	return current_process;
+}
+
+std::unique_ptr<Process> open_process(ProcessId process_id)
+{
+	if (process_id == static_cast<ProcessId>(getpid()))
+		return std::make_unique<CurrentProcess>();
+
+	throw std::system_error(std::make_error_code(std::errc::not_supported));
+}
+
+namespace detail {
+
+class CurrentProcessMemory final : public MemoryManager
+{
+public:
+	virtual bool allows_direct_addressing() const override;
+	virtual std::size_t page_size() const override;
+
+	virtual void * allocate(std::uintptr_t base, std::size_t size) override;
+	virtual void set_access(void * mem, std::size_t size, int access) override;
+	virtual std::size_t resident_size(const void * mem, std::size_t size) const override;
+	virtual MemoryState memory_state(const void * mem, std::size_t size) const override;
+	virtual void release(void * mem, std::size_t size) override;
+
+	virtual std::size_t copy_from(const void * mem, std::size_t size, void * into_buffer) override;
+	virtual std::size_t copy_into(const void * data, std::size_t size, void * into_mem) override;
+	virtual void flush_instruction_cache(const void * mem, std::size_t size) override;
+
+	virtual void commit(void * mem, std::size_t size) override;
+	virtual void decommit(void * mem, std::size_t size) override;
+};
+
+class CurrentProcessModuleProvider final : public ModuleProvider
+{
+public:
+	virtual std::shared_ptr<Module> get_module(std::string_view name) override;
+};
+
+ProcessId CurrentProcess::process_id() const
+{
+	return getpid();
+}
+
+ProcessHandle CurrentProcess::native_handle()
+{
+	return nullptr;
+}
+
+namespace {
+	CurrentProcessMemory current_process_memory;
+}
+
+const MemoryManager & CurrentProcess::memory_manager() const
+{
+	return current_process_memory;
+}
+
+MemoryManager & CurrentProcess::memory_manager()
+{
+	return current_process_memory;
+}
+
+const CodeGenerator & CurrentProcess::code_generator() const
+{
+	return native_code_generator();
+}
+
+ModuleProvider & CurrentProcess::module_provider() const
+{
+	static CurrentProcessModuleProvider module_provider;
+	return module_provider;
+}
+
+void CurrentProcess::register_exception_table(std::uintptr_t, void *, std::size_t)
+{
+	// Win64 unwind tables have no meaning to the Linux unwinder
+}
+
+void CurrentProcess::deregister_exception_table(void *)
+{
+	// Win64 unwind tables have no meaning to the Linux unwinder
+}
+
+std::uint32_t CurrentProcess::execute(const void * proc, void * param)
+{
+#ifdef __x86_64__
+	using ThreadProc = std::uint32_t (__attribute__((ms_abi)) *)(void *);
+#else
+	using ThreadProc = std::uint32_t (*)(void *);
+#endif
+	return reinterpret_cast<ThreadProc>(const_cast<void *>(proc))(param);
+}
+
+bool CurrentProcessMemory::allows_direct_addressing() const
+{
+	return true;
+}
+
+std::size_t CurrentProcessMemory::page_size() const
+{
+	return system_page_size();
+}
+
+void * CurrentProcessMemory::allocate(std::uintptr_t base, std::size_t size)
+{
+	void * const base_ptr = reinterpret_cast<void *>(base);
+	const int mmap_flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+	void * const mem = mmap(base_ptr, size, PROT_NONE, mmap_flags, -1, 0);
+	if (mem == MAP_FAILED) throw std::system_error(errno, std::system_category());
+	return mem;
+}
+
+void CurrentProcessMemory::release(void * mem, std::size_t size)
+{
+	if (munmap(mem, size) != 0)
+		throw std::system_error(errno, std::system_category());
+}
+
+void CurrentProcessMemory::commit(void * mem, std::size_t size)
+{
+	const auto [pages_ptr, pages_size] = page_aligned_range(mem, size);
+	if (mprotect(pages_ptr, pages_size, PROT_READ | PROT_WRITE) != 0)
+		throw std::system_error(errno, std::system_category());
+}
+
+void CurrentProcessMemory::decommit(void * mem, std::size_t size)
+{
+	const auto [pages_ptr, pages_size] = page_aligned_range(mem, size);
+	if (madvise(pages_ptr, pages_size, MADV_DONTNEED) != 0)
+		throw std::system_error(errno, std::system_category());
+	if (mprotect(pages_ptr, pages_size, PROT_NONE) != 0)
+		throw std::system_error(errno, std::system_category());
+}
+
+void CurrentProcessMemory::set_access(void * mem, std::size_t size, int access)
+{
+	const auto [pages_ptr, pages_size] = page_aligned_range(mem, size);
+	if (mprotect(pages_ptr, pages_size, memory_access_to_posix(access)) != 0)
+		throw std::system_error(errno, std::system_category());
+}
+
+std::size_t CurrentProcessMemory::resident_size(const void * mem, std::size_t size) const
+{
+	return query_resident_size(mem, size);
+}
+
+MemoryManager::MemoryState CurrentProcessMemory::memory_state(const void * mem, std::size_t size) const
+{
+	return query_memory_state(mem, size);
+}
+
+std::size_t CurrentProcessMemory::copy_from(const void * mem, std::size_t size, void * into_buffer)
+{
+	std::copy_n(static_cast<const char *>(mem), size, static_cast<char *>(into_buffer));
+	return size;
+}
+
+std::size_t CurrentProcessMemory::copy_into(const void * data, std::size_t size, void * into_mem)
+{
+	std::copy_n(static_cast<const char *>(data), size, static_cast<char *>(into_mem));
+	return size;
+}
+
+void CurrentProcessMemory::flush_instruction_cache(const void * mem, std::size_t size)
+{
+	char * const begin = static_cast<char *>(const_cast<void *>(mem));
+	__builtin___clear_cache(begin, begin + size);
+}
+
+std::shared_ptr<Module> CurrentProcessModuleProvider::get_module(std::string_view name)
+{
+	const std::string name_s { name };
+	void * const handle = dlopen(name_s.c_str(), RTLD_NOW | RTLD_NOLOAD);
+	return handle ? std::make_shared<SystemModule>(handle) : nullptr;
+}
+
+} }
\ No newline at end of file
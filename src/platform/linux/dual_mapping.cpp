@@ -0,0 +1,50 @@
+#include "../dual_mapping.hpp"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+
+namespace load::detail {
+
+namespace {
+
+struct FileDescriptor
+{
+	~FileDescriptor() { if (fd != -1) close(fd); }
+	int fd;
+};
+
+void * map_shared_view(int fd, std::size_t size, int prot)
+{
+	void * const view = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+	if (view == MAP_FAILED) throw std::system_error(errno, std::system_category());
+	return view;
+}
+
+}
+
+DualMapping create_dual_mapping(std::size_t size)
+{
+	const FileDescriptor mem_fd { memfd_create("libload-code", MFD_CLOEXEC) };
+	if (mem_fd.fd == -1) throw std::system_error(errno, std::system_category());
+	if (ftruncate(mem_fd.fd, size) != 0) throw std::system_error(errno, std::system_category());
+
+	void * const writable = map_shared_view(mem_fd.fd, size, PROT_READ | PROT_WRITE);
+	try {
+		void * const executable = map_shared_view(mem_fd.fd, size, PROT_READ | PROT_EXEC);
+		return { static_cast<char *>(writable), static_cast<char *>(executable), size };
+	} catch (...) {
+		munmap(writable, size);
+		throw;
+	}
+}
+
+void release_dual_mapping(const DualMapping & mapping)
+{
+	munmap(mapping.writable, mapping.size);
+	munmap(mapping.executable, mapping.size);
+}
+
+}
\ No newline at end of file
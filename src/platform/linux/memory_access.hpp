@@ -0,0 +1,99 @@
+#ifndef LOAD_SRC_PLATFORM_LINUX_MEMORYACCESS_HPP_
+#define LOAD_SRC_PLATFORM_LINUX_MEMORYACCESS_HPP_
+
+#include <load/memory/memory_manager.hpp>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace load::detail {
+
+constexpr int memory_access_to_posix(int mem_access)
+{
+	int prot_flags = PROT_NONE;
+	if (mem_access & MemoryManager::ReadAccess)    prot_flags |= PROT_READ;
+	if (mem_access & MemoryManager::WriteAccess)   prot_flags |= PROT_WRITE;
+	if (mem_access & MemoryManager::ExecuteAccess) prot_flags |= PROT_EXEC;
+	return prot_flags;
+}
+
+inline int memory_access_from_permissions(const std::string & permissions)
+{
+	int mem_access = 0;
+	if (permissions.size() < 3) return mem_access;
+	if (permissions[0] == 'r') mem_access |= MemoryManager::ReadAccess;
+	if (permissions[1] == 'w') mem_access |= MemoryManager::WriteAccess;
+	if (permissions[2] == 'x') mem_access |= MemoryManager::ExecuteAccess;
+	return mem_access;
+}
+
+inline std::size_t system_page_size()
+{
+	static const std::size_t page_size = sysconf(_SC_PAGESIZE);
+	return page_size;
+}
+
+inline std::pair<void *, std::size_t> page_aligned_range(const void * mem, std::size_t size)
+{
+	const std::size_t page_size = system_page_size();
+	const auto first_page = reinterpret_cast<std::uintptr_t>(mem) & ~(page_size - 1);
+	const auto end_addr = reinterpret_cast<std::uintptr_t>(mem) + size;
+	const auto end_page = (end_addr + page_size - 1) & ~(page_size - 1);
+	return { reinterpret_cast<void *>(first_page), end_page - first_page };
+}
+
+inline std::size_t query_resident_size(const void * mem, std::size_t size)
+{
+	const std::size_t page_size = system_page_size();
+	const auto [pages_ptr, pages_size] = page_aligned_range(mem, size);
+
+	std::vector<unsigned char> page_vec (pages_size / page_size);
+	if (mincore(pages_ptr, pages_size, page_vec.data()) != 0)
+		throw std::system_error(errno, std::system_category());
+
+	std::size_t resident_pages = 0;
+	for (const unsigned char page_info : page_vec)
+		resident_pages += page_info & 1;
+	return resident_pages * page_size;
+}
+
+
+// Decommitted pages are mapped without access, so only pages with some access count as committed
+inline MemoryManager::MemoryState query_memory_state(const void * mem, std::size_t size)
+{
+	const auto [pages_ptr, pages_size] = page_aligned_range(mem, size);
+	const auto range_begin = reinterpret_cast<std::uintptr_t>(pages_ptr);
+	const auto range_end = range_begin + pages_size;
+
+	MemoryManager::MemoryState mem_state;
+	std::ifstream maps { "/proc/self/maps" };
+	std::string line;
+	while (std::getline(maps, line)) {
+		std::istringstream fields { line };
+		std::uintptr_t begin, end;
+		char separator;
+		std::string permissions;
+		fields >> std::hex >> begin >> separator >> end >> permissions;
+		if (end <= range_begin || begin >= range_end) continue;
+
+		const int mem_access = memory_access_from_permissions(permissions);
+		if (mem_access == 0) continue;
+		mem_state.committed_size += (end < range_end ? end : range_end) - (begin > range_begin ? begin : range_begin);
+		mem_state.access |= mem_access;
+	}
+
+	return mem_state;
+}
+}
+
+#endif
\ No newline at end of file
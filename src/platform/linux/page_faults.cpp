@@ -0,0 +1,18 @@
+#include "../page_faults.hpp"
+
+#include <sys/resource.h>
+
+#include <cerrno>
+#include <system_error>
+
+namespace load::detail {
+
+PageFaultCount current_page_fault_count()
+{
+	rusage usage;
+	if (getrusage(RUSAGE_THREAD, &usage) != 0)
+		throw std::system_error(errno, std::system_category());
+	return { usage.ru_minflt, usage.ru_majflt };
+}
+
+}
\ No newline at end of file
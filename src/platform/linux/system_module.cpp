@@ -0,0 +1,130 @@
+#include "system_module.hpp"
+#include "memory_access.hpp"
+#include "../../module_provider.hpp"
+
+#include <dlfcn.h>
+#include <link.h>
+
+#include <memory>
+#include <stdexcept>
+
+namespace load {
+
+using namespace detail;
+
+namespace {
+
+auto dlopen_module_provider =
+	make_module_provider([] (const std::string & name) {
+		std::shared_ptr<Module> module_sp;
+		if (void * const module_handle = dlopen(name.c_str(), RTLD_NOW | RTLD_LOCAL))
+			module_sp = std::make_shared<SystemModule>(module_handle);
+		return module_sp;
+	});
+
+}
+
+ModuleProvider & system_module_provider = dlopen_module_provider;
+
+namespace detail {
+
+namespace {
+
+constexpr int elf_segment_memory_access(ElfW(Word) flags)
+{
+	int mem_access = 0;
+	if (flags & PF_R) mem_access |= MemoryManager::ReadAccess;
+	if (flags & PF_W) mem_access |= MemoryManager::WriteAccess;
+	if (flags & PF_X) mem_access |= MemoryManager::ExecuteAccess;
+	return mem_access;
+}
+
+struct SegmentQuery
+{
+	ElfW(Addr)          base_address;
+	ModuleMemoryStats * mem_stats;
+};
+
+int collect_segment_memory_stats(dl_phdr_info * info, std::size_t, void * data)
+{
+	auto & query = *static_cast<SegmentQuery *>(data);
+	if (info->dlpi_addr != query.base_address)
+		return 0;
+
+	for (ElfW(Half) i = 0; i < info->dlpi_phnum; ++i) {
+		const ElfW(Phdr) & phdr = info->dlpi_phdr[i];
+		if (phdr.p_type != PT_LOAD) continue;
+
+		const auto seg_ptr = reinterpret_cast<const void *>(info->dlpi_addr + phdr.p_vaddr);
+		const std::size_t seg_size = page_aligned_range(seg_ptr, phdr.p_memsz).second;
+
+		SectionMemoryStats & seg_stats = query.mem_stats->sections.emplace_back();
+		seg_stats.name = "LOAD";
+		seg_stats.address = reinterpret_cast<std::uintptr_t>(seg_ptr);
+		seg_stats.reserved_size = seg_size;
+		seg_stats.committed_size = seg_size;
+		seg_stats.resident_size = query_resident_size(seg_ptr, phdr.p_memsz);
+		seg_stats.access = elf_segment_memory_access(phdr.p_flags);
+		seg_stats.discarded = false;
+
+		query.mem_stats->reserved_size += seg_stats.reserved_size;
+		query.mem_stats->committed_size += seg_stats.committed_size;
+		query.mem_stats->resident_size += seg_stats.resident_size;
+	}
+
+	return 1;
+}
+
+}
+
+SystemModule::SystemModule(void * handle)
+	: _handle { handle } {}
+
+SystemModule::SystemModule(SystemModule && other)
+	: _handle { other._handle }
+{
+	other._handle = nullptr;
+}
+
+SystemModule::~SystemModule()
+{
+	if (_handle != nullptr)
+		dlclose(_handle);
+}
+
+ModuleMemoryStats SystemModule::memory_stats() const
+{
+	link_map * module_map;
+	if (dlinfo(_handle, RTLD_DI_LINKMAP, &module_map) != 0)
+		throw std::runtime_error(dlerror());
+
+	ModuleMemoryStats mem_stats;
+	mem_stats.metadata_size = sizeof(*this);
+	SegmentQuery query { module_map->l_addr, &mem_stats };
+	dl_iterate_phdr(collect_segment_memory_stats, &query);
+	return mem_stats;
+}
+
+ModuleAbi SystemModule::abi() const
+{
+	return ModuleAbi::SystemV;
+}
+
+void * SystemModule::tls_data() const
+{
+	return nullptr;
+}
+
+ProcPtr SystemModule::get_proc_address(std::string_view name) const
+{
+	const DataPtr data_addr = get_data_address(name);
+	return reinterpret_cast<ProcPtr>(data_addr);
+}
+
+DataPtr SystemModule::get_data_address(std::string_view name) const
+{
+	const std::string name_s { name };
+	return dlsym(_handle, name_s.c_str());
+}
+
+} }
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef LOAD_SRC_PLATFORM_LINUX_SYSTEMMODULE_HPP_
+#define LOAD_SRC_PLATFORM_LINUX_SYSTEMMODULE_HPP_
+
+#include <load/module/module.hpp>
+
+namespace load::detail {
+
+class SystemModule final : public Module
+{
+public:
+	explicit SystemModule(void * handle);
+	SystemModule(SystemModule && other);
+	virtual ~SystemModule();
+
+	virtual ModuleMemoryStats memory_stats() const override;
+	virtual ModuleAbi abi() const override;
+	virtual void * tls_data() const override;
+
+protected:
+	virtual ProcPtr get_proc_address(std::string_view name) const override;
+	virtual DataPtr get_data_address(std::string_view name) const override;
+
+private:
+	void * _handle;
+};
+
+}
+
+#endif
\ No newline at end of file
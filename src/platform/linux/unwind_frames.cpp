@@ -0,0 +1,19 @@
+#include "../unwind_frames.hpp"
+
+extern "C" void __register_frame(void * begin);
+extern "C" void __deregister_frame(void * begin);
+
+namespace load::detail {
+
+bool register_unwind_frames(const char * eh_frame)
+{
+	__register_frame(const_cast<char *>(eh_frame));
+	return true;
+}
+
+void deregister_unwind_frames(const char * eh_frame)
+{
+	__deregister_frame(const_cast<char *>(eh_frame));
+}
+
+}
\ No newline at end of file
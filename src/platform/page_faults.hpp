@@ -0,0 +1,16 @@
+#ifndef LOAD_SRC_PLATFORM_PAGEFAULTS_HPP_
+#define LOAD_SRC_PLATFORM_PAGEFAULTS_HPP_
+
+namespace load::detail {
+
+struct PageFaultCount
+{
+	long minor_faults;
+	long major_faults;
+};
+
+PageFaultCount current_page_fault_count();
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,12 @@
+#ifndef LOAD_SRC_PLATFORM_UNWINDFRAMES_HPP_
+#define LOAD_SRC_PLATFORM_UNWINDFRAMES_HPP_
+
+namespace load::detail {
+
+// Takes a zero-terminated .eh_frame; returns false where the unwinder doesn't use DWARF CFI
+bool register_unwind_frames(const char * eh_frame);
+void deregister_unwind_frames(const char * eh_frame);
+
+}
+
+#endif
\ No newline at end of file
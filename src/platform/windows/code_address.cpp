@@ -0,0 +1,18 @@
+#include "../code_address.hpp"
+
+#include <windows.h>
+
+namespace load::detail {
+
+bool is_code_address(const void * address)
+{
+	MEMORY_BASIC_INFORMATION mem_info;
+	if (!VirtualQuery(address, &mem_info, sizeof(mem_info)))
+		return false;
+
+	constexpr DWORD exec_protect = PAGE_EXECUTE | PAGE_EXECUTE_READ
+	                             | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+	return mem_info.State == MEM_COMMIT && (mem_info.Protect & exec_protect) != 0;
+}
+
+}
\ No newline at end of file
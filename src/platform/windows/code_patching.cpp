@@ -0,0 +1,26 @@
+#include "../code_patching.hpp"
+#include "memory_access.hpp"
+
+#include <load/memory/memory_manager.hpp>
+
+#include <windows.h>
+
+#include <stdexcept>
+
+namespace load::detail {
+
+void serialize_instruction_streams()
+{
+	FlushProcessWriteBuffers();
+}
+
+int code_page_access(const void * address)
+{
+	MEMORY_BASIC_INFORMATION mem_info;
+	if (VirtualQuery(address, &mem_info, sizeof(mem_info)) == 0 || mem_info.State != MEM_COMMIT)
+		throw std::invalid_argument("Address is not mapped");
+
+	return memory_access_from_win32(mem_info.Protect);
+}
+
+}
\ No newline at end of file
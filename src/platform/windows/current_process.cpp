@@ -25,13 +25,17 @@ class CurrentProcessMemory final : public MemoryManager
 {
 public:
 	virtual bool allows_direct_addressing() const override;
+	virtual std::size_t page_size() const override;
 
 	virtual void * allocate(std::uintptr_t base, std::size_t size) override;
 	virtual void set_access(void * mem, std::size_t size, int access) override;
+	virtual std::size_t resident_size(const void * mem, std::size_t size) const override;
+	virtual MemoryState memory_state(const void * mem, std::size_t size) const override;
 	virtual void release(void * mem, std::size_t size) override;
 
 	virtual std::size_t copy_from(const void * mem, std::size_t size, void * into_buffer) override;
 	virtual std::size_t copy_into(const void * data, std::size_t size, void * into_mem) override;
+	virtual void flush_instruction_cache(const void * mem, std::size_t size) override;
 
 	virtual void commit(void * mem, std::size_t size) override;
 	virtual void decommit(void * mem, std::size_t size) override;
@@ -95,11 +99,22 @@ void CurrentProcess::deregister_exception_table(void * exception_table)
 		throw std::system_error(GetLastError(), std::system_category());
 }
 
+std::uint32_t CurrentProcess::execute(const void * proc, void * param)
+{
+	const auto thread_proc = reinterpret_cast<LPTHREAD_START_ROUTINE>(const_cast<void *>(proc));
+	return thread_proc(param);
+}
+
 bool CurrentProcessMemory::allows_direct_addressing() const
 {
 	return true;
 }
 
+std::size_t CurrentProcessMemory::page_size() const
+{
+	return system_page_size();
+}
+
 void * CurrentProcessMemory::allocate(std::uintptr_t base, std::size_t size)
 {
 	void * const base_ptr = reinterpret_cast<void *>(base);
@@ -134,6 +149,16 @@ void CurrentProcessMemory::set_access(void * mem, std::size_t size, int access)
 		throw std::system_error(GetLastError(), std::system_category());
 }
 
+std::size_t CurrentProcessMemory::resident_size(const void * mem, std::size_t size) const
+{
+	return query_resident_size(GetCurrentProcess(), mem, size);
+}
+
+MemoryManager::MemoryState CurrentProcessMemory::memory_state(const void * mem, std::size_t size) const
+{
+	return query_memory_state(GetCurrentProcess(), mem, size);
+}
+
 std::size_t CurrentProcessMemory::copy_from(const void * mem, std::size_t size, void * into_buffer)
 {
 	std::copy_n(static_cast<const char *>(mem), size, static_cast<char *>(into_buffer));
@@ -146,6 +171,12 @@ std::size_t CurrentProcessMemory::copy_into(const void * data, std::size_t size,
 	return size;
 }
 
+void CurrentProcessMemory::flush_instruction_cache(const void * mem, std::size_t size)
+{
+	if (!FlushInstructionCache(GetCurrentProcess(), mem, size))
+		throw std::system_error(GetLastError(), std::system_category());
+}
+
 std::shared_ptr<Module> CurrentProcessModuleProvider::get_module(std::string_view name)
 {
 	HMODULE handle;
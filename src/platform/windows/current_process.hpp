@@ -22,6 +22,8 @@ public:
 	                                      std::size_t    table_size) override;
 	
 	virtual void deregister_exception_table(void * exception_table) override;
+
+	virtual std::uint32_t execute(const void * proc, void * param) override;
 };
 
 }
@@ -0,0 +1,51 @@
+#include "../dual_mapping.hpp"
+
+#include <windows.h>
+
+#include <system_error>
+
+namespace load::detail {
+
+namespace {
+
+struct SectionHandle
+{
+	~SectionHandle() { if (handle != nullptr) CloseHandle(handle); }
+	HANDLE handle;
+};
+
+void * map_section_view(HANDLE section, DWORD access, std::size_t size)
+{
+	void * const view = MapViewOfFile(section, access, 0, 0, size);
+	if (view == nullptr) throw std::system_error(GetLastError(), std::system_category());
+	return view;
+}
+
+}
+
+DualMapping create_dual_mapping(std::size_t size)
+{
+	const auto size64 = static_cast<unsigned long long>(size);
+	const SectionHandle section {
+		CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_EXECUTE_READWRITE,
+		                   DWORD(size64 >> 32), DWORD(size64), nullptr)
+	};
+	if (section.handle == nullptr) throw std::system_error(GetLastError(), std::system_category());
+
+	void * const writable = map_section_view(section.handle, FILE_MAP_WRITE, size);
+	try {
+		void * const executable = map_section_view(section.handle, FILE_MAP_READ | FILE_MAP_EXECUTE, size);
+		return { static_cast<char *>(writable), static_cast<char *>(executable), size };
+	} catch (...) {
+		UnmapViewOfFile(writable);
+		throw;
+	}
+}
+
+void release_dual_mapping(const DualMapping & mapping)
+{
+	UnmapViewOfFile(mapping.writable);
+	UnmapViewOfFile(mapping.executable);
+}
+
+}
\ No newline at end of file
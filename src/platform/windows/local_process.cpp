@@ -3,6 +3,7 @@
 #include "local_process.hpp"
 #include "current_process.hpp"
 #include "../../arch/code_generator.hpp"
+#include "../../remote_call_batch.hpp"
 #include <load/module/module_provider.hpp>
 
 #ifdef LIBLOAD_ENABLE_ARCH_X86
@@ -29,7 +30,8 @@ std::unique_ptr<Process> open_process(ProcessId process_id)
 	if (process_id == GetCurrentProcessId())
 		return std::make_unique<CurrentProcess>();
 	
-	const DWORD access = PROCESS_VM_OPERATION | PROCESS_CREATE_THREAD;
+	const DWORD access = PROCESS_VM_OPERATION | PROCESS_VM_READ | PROCESS_VM_WRITE
+	                   | PROCESS_CREATE_THREAD | PROCESS_QUERY_INFORMATION;
 	const HANDLE process_handle = OpenProcess(access, FALSE, process_id);
 	if (!process_handle)
 		throw std::system_error(GetLastError(), std::system_category());
@@ -156,16 +158,54 @@ ModuleProvider & LocalProcess::module_provider() const
 	return *_module_provider;
 }
 
+std::uint64_t LocalProcess::call_function_table_proc(const void * proc, const ParameterList & params)
+{
+#if defined(_WIN64) && defined(LIBLOAD_ENABLE_ARCH_X86_64)
+	// ntdll is mapped at the same address in every process of the same architecture
+	if (dynamic_cast<const X64CodeGenerator *>(_code_generator) == nullptr)
+		throw std::runtime_error("Exception tables can only be registered in 64-bit processes");
+
+	RemoteCallBatch call_batch;
+	call_batch.add_call(reinterpret_cast<std::uintptr_t>(proc), params);
+	return call_batch.run(*this).front();
+#else
+	throw std::runtime_error("Exception table registration is not supported by this build");
+#endif
+}
+
 void LocalProcess::register_exception_table(std::uintptr_t base_address,
                                             void         * exception_table,
                                             std::size_t    table_size)
 {
-	// TODO: implement exception table registration
+	const std::size_t entry_count = table_size / sizeof(RUNTIME_FUNCTION);
+	const ParameterList params { reinterpret_cast<std::uintptr_t>(exception_table), entry_count, base_address };
+	if (!static_cast<BOOLEAN>(call_function_table_proc(reinterpret_cast<const void *>(&RtlAddFunctionTable), params)))
+		throw std::runtime_error("Unable to register exception table");
 }
 
 void LocalProcess::deregister_exception_table(void * exception_table)
 {
-	// TODO: implement exception table deregistration
+	const ParameterList params { reinterpret_cast<std::uintptr_t>(exception_table) };
+	if (!static_cast<BOOLEAN>(call_function_table_proc(reinterpret_cast<const void *>(&RtlDeleteFunctionTable), params)))
+		throw std::runtime_error("Unable to deregister exception table");
+}
+
+std::uint32_t LocalProcess::execute(const void * proc, void * param)
+{
+	const auto thread_proc = reinterpret_cast<LPTHREAD_START_ROUTINE>(const_cast<void *>(proc));
+	const HANDLE thread_handle = CreateRemoteThread(_handle, nullptr, 0, thread_proc, param, 0, nullptr);
+	if (!thread_handle)
+		throw std::system_error(GetLastError(), std::system_category());
+
+	DWORD exit_code = 0;
+	const bool finished = WaitForSingleObject(thread_handle, INFINITE) == WAIT_OBJECT_0
+	                   && GetExitCodeThread(thread_handle, &exit_code);
+	const DWORD error = GetLastError();
+	CloseHandle(thread_handle);
+	if (!finished)
+		throw std::system_error(error, std::system_category());
+
+	return exit_code;
 }
 
 LocalProcessMemory::LocalProcessMemory(HANDLE handle)
@@ -176,6 +216,11 @@ bool LocalProcessMemory::allows_direct_addressing() const
 	return false;
 }
 
+std::size_t LocalProcessMemory::page_size() const
+{
+	return system_page_size();
+}
+
 void * LocalProcessMemory::allocate(std::uintptr_t base, std::size_t size)
 {
 	void * const base_ptr = reinterpret_cast<void *>(base);
@@ -211,6 +256,16 @@ void LocalProcessMemory::set_access(void * mem, std::size_t size, int access)
 		throw std::system_error(GetLastError(), std::system_category());
 }
 
+std::size_t LocalProcessMemory::resident_size(const void * mem, std::size_t size) const
+{
+	return query_resident_size(_handle, mem, size);
+}
+
+MemoryManager::MemoryState LocalProcessMemory::memory_state(const void * mem, std::size_t size) const
+{
+	return query_memory_state(_handle, mem, size);
+}
+
 std::size_t LocalProcessMemory::copy_from(const void * mem, std::size_t size, void * into_buffer)
 {
 	SIZE_T bytes_read;
@@ -227,4 +282,10 @@ std::size_t LocalProcessMemory::copy_into(const void * from_buffer, std::size_t
 	return bytes_written;
 }
 
+void LocalProcessMemory::flush_instruction_cache(const void * mem, std::size_t size)
+{
+	if (!FlushInstructionCache(_handle, mem, size))
+		throw std::system_error(GetLastError(), std::system_category());
+}
+
 } }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef LOAD_SRC_PLATFORM_WINDOWS_LOCALPROCESS_HPP_
 #define LOAD_SRC_PLATFORM_WINDOWS_LOCALPROCESS_HPP_
 
+#include <load/codegen/common.hpp>
 #include <load/process/process.hpp>
 #include <load/memory/memory_manager.hpp>
 
@@ -16,13 +17,17 @@ public:
 	explicit LocalProcessMemory(HANDLE handle);
 
 	virtual bool allows_direct_addressing() const override;
+	virtual std::size_t page_size() const override;
 
 	virtual void * allocate(std::uintptr_t base, std::size_t size) override;
 	virtual void set_access(void * mem, std::size_t size, int access) override;
+	virtual std::size_t resident_size(const void * mem, std::size_t size) const override;
+	virtual MemoryState memory_state(const void * mem, std::size_t size) const override;
 	virtual void release(void * mem, std::size_t size) override;
 
 	virtual std::size_t copy_from(const void * mem, std::size_t size, void * into_buffer) override;
 	virtual std::size_t copy_into(const void * data, std::size_t size, void * into_mem) override;
+	virtual void flush_instruction_cache(const void * mem, std::size_t size) override;
 
 	virtual void commit(void * mem, std::size_t size) override;
 	virtual void decommit(void * mem, std::size_t size) override;
@@ -53,7 +58,11 @@ public:
 	
 	virtual void deregister_exception_table(void * exception_table) override;
 
+	virtual std::uint32_t execute(const void * proc, void * param) override;
+
 private:
+	std::uint64_t call_function_table_proc(const void * proc, const ParameterList & params);
+
 	HANDLE                          _handle;
 	const CodeGenerator           * _code_generator;
 	LocalProcessMemory              _memory_manager;
@@ -4,6 +4,12 @@
 #include <load/memory/memory_manager.hpp>
 
 #include <windows.h>
+#include <psapi.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <system_error>
+#include <vector>
 
 namespace load::detail {
 
@@ -26,6 +32,79 @@ constexpr DWORD memory_access_to_win32(int mem_access)
 	}
 }
 
+constexpr int memory_access_from_win32(DWORD protect)
+{
+	switch (protect & 0xff) {
+		case PAGE_EXECUTE_READWRITE:
+		case PAGE_EXECUTE_WRITECOPY:
+			return MemoryManager::ReadAccess | MemoryManager::WriteAccess | MemoryManager::ExecuteAccess;
+		case PAGE_EXECUTE_READ:
+			return MemoryManager::ReadAccess | MemoryManager::ExecuteAccess;
+		case PAGE_EXECUTE:
+			return MemoryManager::ExecuteAccess;
+		case PAGE_READWRITE:
+		case PAGE_WRITECOPY:
+			return MemoryManager::ReadAccess | MemoryManager::WriteAccess;
+		case PAGE_READONLY:
+			return MemoryManager::ReadAccess;
+	}
+
+	return 0;
+}
+
+inline std::size_t system_page_size()
+{
+	SYSTEM_INFO system_info;
+	GetSystemInfo(&system_info);
+	return system_info.dwPageSize;
+}
+
+inline std::size_t query_resident_size(HANDLE process, const void * mem, std::size_t size)
+{
+	const std::size_t page_size = system_page_size();
+	const auto first_page = reinterpret_cast<std::uintptr_t>(mem) & ~(page_size - 1);
+	const auto end_addr = reinterpret_cast<std::uintptr_t>(mem) + size;
+
+	std::vector<PSAPI_WORKING_SET_EX_INFORMATION> ws_info;
+	for (std::uintptr_t page = first_page; page < end_addr; page += page_size) {
+		PSAPI_WORKING_SET_EX_INFORMATION & page_info = ws_info.emplace_back();
+		page_info.VirtualAddress = reinterpret_cast<void *>(page);
+	}
+
+	const DWORD ws_info_size = static_cast<DWORD>(ws_info.size() * sizeof(ws_info[0]));
+	if (!QueryWorkingSetEx(process, ws_info.data(), ws_info_size))
+		throw std::system_error(GetLastError(), std::system_category());
+
+	std::size_t resident_pages = 0;
+	for (const auto & page_info : ws_info)
+		resident_pages += page_info.VirtualAttributes.Valid;
+	return resident_pages * page_size;
+}
+
+
+inline MemoryManager::MemoryState query_memory_state(HANDLE process, const void * mem, std::size_t size)
+{
+	const char * const range_ptr = static_cast<const char *>(mem);
+
+	MemoryManager::MemoryState mem_state;
+	for (std::size_t offset = 0; offset < size; ) {
+		MEMORY_BASIC_INFORMATION mem_info;
+		if (VirtualQueryEx(process, range_ptr + offset, &mem_info, sizeof(mem_info)) == 0)
+			throw std::system_error(GetLastError(), std::system_category());
+
+		const std::size_t region_offset = range_ptr + offset - static_cast<const char *>(mem_info.BaseAddress);
+		const std::size_t region_size = mem_info.RegionSize - region_offset;
+		const std::size_t remaining_size = size - offset;
+		const std::size_t range_size = region_size < remaining_size ? region_size : remaining_size;
+		if (mem_info.State == MEM_COMMIT) {
+			mem_state.committed_size += range_size;
+			mem_state.access |= memory_access_from_win32(mem_info.Protect);
+		}
+		offset += range_size;
+	}
+
+	return mem_state;
+}
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,18 @@
+#include "../page_faults.hpp"
+
+#include <windows.h>
+#include <psapi.h>
+
+#include <system_error>
+
+namespace load::detail {
+
+PageFaultCount current_page_fault_count()
+{
+	PROCESS_MEMORY_COUNTERS mem_counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &mem_counters, sizeof(mem_counters)))
+		throw std::system_error(GetLastError(), std::system_category());
+	return { static_cast<long>(mem_counters.PageFaultCount), 0 };
+}
+
+}
\ No newline at end of file
@@ -1,7 +1,15 @@
 #include "system_module.hpp"
+#include "memory_access.hpp"
 #include "../../module_provider.hpp"
 
+#include <load/memory/memory_manager.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <system_error>
+#include <utility>
 
 namespace load {
 
@@ -17,6 +25,36 @@ ModuleProvider & system_module_provider =
 
 namespace detail {
 
+namespace {
+
+constexpr int section_memory_access(DWORD characteristics)
+{
+	int mem_access = 0;
+	if (characteristics & IMAGE_SCN_MEM_READ) mem_access |= MemoryManager::ReadAccess;
+	if (characteristics & IMAGE_SCN_MEM_WRITE) mem_access |= MemoryManager::WriteAccess;
+	if (characteristics & IMAGE_SCN_MEM_EXECUTE) mem_access |= MemoryManager::ExecuteAccess;
+	return mem_access;
+}
+
+SectionMemoryStats query_section_memory_stats(const char * mem, std::size_t size, int mem_access)
+{
+	const std::size_t page_size = system_page_size();
+	const std::size_t reserved_size = (size + page_size - 1) & ~(page_size - 1);
+
+	SectionMemoryStats sect_stats;
+	sect_stats.address = reinterpret_cast<std::uintptr_t>(mem);
+	sect_stats.reserved_size = reserved_size;
+	sect_stats.committed_size = query_memory_state(GetCurrentProcess(), mem, reserved_size).committed_size;
+	sect_stats.access = mem_access;
+
+	sect_stats.resident_size = sect_stats.committed_size != 0
+	                         ? query_resident_size(GetCurrentProcess(), mem, reserved_size) : 0;
+	sect_stats.discarded = sect_stats.committed_size == 0;
+	return sect_stats;
+}
+
+}
+
 SystemModule::SystemModule(HMODULE handle)
 	: _handle { handle } {}
 
@@ -32,6 +70,55 @@ SystemModule::~SystemModule()
 		FreeLibrary(_handle);
 }
 
+ModuleMemoryStats SystemModule::memory_stats() const
+{
+	MODULEINFO module_info;
+	if (!GetModuleInformation(GetCurrentProcess(), _handle, &module_info, sizeof(module_info)))
+		throw std::system_error(GetLastError(), std::system_category());
+
+	const auto image_base = static_cast<const char *>(module_info.lpBaseOfDll);
+	const auto dos_header = reinterpret_cast<const IMAGE_DOS_HEADER *>(image_base);
+	const auto nt_headers = reinterpret_cast<const IMAGE_NT_HEADERS *>(image_base + dos_header->e_lfanew);
+
+	ModuleMemoryStats mem_stats;
+	mem_stats.reserved_size = module_info.SizeOfImage;
+	mem_stats.metadata_size = sizeof(*this);
+	mem_stats.sections.push_back(query_section_memory_stats(image_base, nt_headers->OptionalHeader.SizeOfHeaders,
+	                                                        MemoryManager::ReadAccess));
+
+	const IMAGE_SECTION_HEADER * const sect_headers = IMAGE_FIRST_SECTION(nt_headers);
+	for (WORD i = 0; i < nt_headers->FileHeader.NumberOfSections; ++i) {
+		const IMAGE_SECTION_HEADER & sect_header = sect_headers[i];
+		const std::size_t sect_size = sect_header.Misc.VirtualSize != 0 ? sect_header.Misc.VirtualSize
+		                                                                : sect_header.SizeOfRawData;
+
+		SectionMemoryStats sect_stats = query_section_memory_stats(image_base + sect_header.VirtualAddress, sect_size,
+		                                                           section_memory_access(sect_header.Characteristics));
+		const auto name_ptr = reinterpret_cast<const char *>(sect_header.Name);
+		sect_stats.name.assign(name_ptr, std::find(name_ptr, name_ptr + IMAGE_SIZEOF_SHORT_NAME, '\0'));
+		mem_stats.sections.push_back(std::move(sect_stats));
+	}
+
+	for (const SectionMemoryStats & sect_stats : mem_stats.sections) {
+		mem_stats.committed_size += sect_stats.committed_size;
+		mem_stats.resident_size += sect_stats.resident_size;
+		if (sect_stats.discarded)
+			mem_stats.discarded_size += sect_stats.reserved_size;
+	}
+
+	return mem_stats;
+}
+
+ModuleAbi SystemModule::abi() const
+{
+	return ModuleAbi::Windows;
+}
+
+void * SystemModule::tls_data() const
+{
+	return nullptr;
+}
+
 ProcPtr SystemModule::get_proc_address(std::string_view name) const
 {
 	const DataPtr data_addr = get_data_address(name);
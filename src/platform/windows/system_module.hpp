@@ -14,6 +14,10 @@ public:
 	SystemModule(SystemModule && other);
 	virtual ~SystemModule();
 
+	virtual ModuleMemoryStats memory_stats() const override;
+	virtual ModuleAbi abi() const override;
+	virtual void * tls_data() const override;
+
 protected:
 	virtual ProcPtr get_proc_address(std::string_view name) const override;
 	virtual DataPtr get_data_address(std::string_view name) const override;
@@ -0,0 +1,13 @@
+#include "../unwind_frames.hpp"
+
+namespace load::detail {
+
+bool register_unwind_frames(const char *)
+{
+	return false;
+}
+
+void deregister_unwind_frames(const char *)
+{}
+
+}
\ No newline at end of file
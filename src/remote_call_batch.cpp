@@ -0,0 +1,139 @@
+#include "remote_call_batch.hpp"
+#include "code_chunk.hpp"
+#include "memory_block.hpp"
+#include "trampoline_cache.hpp"
+
+#include <load/codegen/calling_convention.hpp>
+#include <load/codegen/code_generator.hpp>
+#include <load/memory/memory_manager.hpp>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace load::detail {
+
+namespace {
+
+std::size_t align_to_page(std::size_t size, std::size_t page_size)
+{
+	return (size + page_size - 1) / page_size * page_size;
+}
+
+}
+
+std::size_t RemoteCallBatch::add_call(std::uintptr_t target, const ParameterList & params)
+{
+	const TrampolineRecord record = make_trampoline_record(target, params);
+	_calls.push_back({ _records.size(), static_cast<unsigned int>(params.size()), false });
+	_records.insert(_records.end(), record.begin(), record.end());
+	return _calls.size() - 1;
+}
+
+std::size_t RemoteCallBatch::add_checked_call(std::uintptr_t target, const ParameterList & params)
+{
+	const std::size_t call_index = add_call(target, params);
+	_calls[call_index].checked = true;
+	return call_index;
+}
+
+std::size_t RemoteCallBatch::size() const
+{
+	return _calls.size();
+}
+
+std::vector<std::uint64_t> RemoteCallBatch::run(Process & process) const
+{
+	if (_calls.empty()) return {};
+
+	const CallingConvention * const cconv = process.code_generator().get_calling_convention();
+	if (cconv == nullptr)
+		throw std::runtime_error("Process has no calling convention");
+
+	MemoryManager & mem_manager = process.memory_manager();
+
+	// Trampolines for the current process are reused across runs; other processes get them with the records
+	std::map<unsigned int, std::uintptr_t> trampoline_addrs;
+	std::map<unsigned int, std::unique_ptr<CodeChunk>> trampolines;
+	std::size_t trampolines_size = 0;
+	for (const CallRecord & call : _calls) {
+		if (mem_manager.allows_direct_addressing()) {
+			if (trampoline_addrs.count(call.argc) == 0) {
+				void * const trampoline = local_trampoline_cache().get_trampoline(*cconv, call.argc);
+				trampoline_addrs[call.argc] = reinterpret_cast<std::uintptr_t>(trampoline);
+			}
+			continue;
+		}
+
+		auto & trampoline = trampolines[call.argc];
+		if (trampoline == nullptr) {
+			trampoline = cconv->make_trampoline(call.argc);
+			trampolines_size += trampoline->max_size();
+		}
+	}
+
+	const std::size_t page_size = mem_manager.page_size();
+	const std::size_t records_size = _records.size() * sizeof(std::uint64_t);
+	const std::size_t trampolines_offset = align_to_page(records_size, page_size);
+	const std::size_t data_size = trampolines_offset + align_to_page(trampolines_size, page_size);
+
+	OwnedMemoryBlock data_mem { mem_manager, mem_manager.allocate(0, data_size), data_size };
+	mem_manager.commit(data_mem.data(), data_size);
+	mem_manager.copy_into(_records.data(), records_size, data_mem.data());
+
+	if (!trampolines.empty()) {
+		char * const trampolines_ptr = data_mem.data() + trampolines_offset;
+		StagingCodeSink code_sink { mem_manager, trampolines_ptr, trampolines_size };
+		std::size_t code_size = 0;
+		for (const auto & [argc, trampoline] : trampolines) {
+			trampoline_addrs[argc] = reinterpret_cast<std::uintptr_t>(trampolines_ptr + code_size);
+			code_size += trampoline->emit(trampolines_ptr + code_size, code_sink);
+		}
+		code_sink.flush();
+		mem_manager.set_access(trampolines_ptr, data_size - trampolines_offset,
+		                       MemoryManager::ReadAccess | MemoryManager::ExecuteAccess);
+	}
+
+	// The routine returns the number of calls that ran
+	CodeBlock routine;
+	routine.add(cconv->make_prolog(1));
+	const auto records_addr = reinterpret_cast<std::uintptr_t>(data_mem.data());
+	for (std::size_t call_index = 0; call_index < _calls.size(); ++call_index) {
+		const CallRecord & call = _calls[call_index];
+		const AbsoluteCodeLocation trampoline { reinterpret_cast<void *>(trampoline_addrs[call.argc]) };
+		const std::uintptr_t record_addr = records_addr + call.offset * sizeof(std::uint64_t);
+		routine.add(cconv->invoke_proc(trampoline, make_proc_params(record_addr)));
+		if (!call.checked) continue;
+
+		auto stop = cconv->return_if_false(1, call_index + 1);
+		if (stop == nullptr)
+			throw std::runtime_error("Calling convention cannot stop a call batch");
+		routine.add(std::move(stop));
+	}
+	routine.add(cconv->set_return_value(_calls.size()));
+	routine.add(cconv->make_epilog(1));
+
+	const std::size_t routine_size = align_to_page(routine.max_size(), page_size);
+	OwnedMemoryBlock routine_mem { mem_manager, mem_manager.allocate(0, routine_size), routine_size };
+	mem_manager.commit(routine_mem.data(), routine_size);
+	emit_code(routine, mem_manager, routine_mem.data());
+	mem_manager.set_access(routine_mem.data(), routine_size,
+	                       MemoryManager::ReadAccess | MemoryManager::ExecuteAccess);
+
+	const std::size_t calls_run = std::min<std::size_t>(process.execute(routine_mem.data(), nullptr), _calls.size());
+
+	std::vector<std::uint64_t> records (_records.size());
+	mem_manager.copy_from(data_mem.data(), records_size, records.data());
+
+	std::vector<std::uint64_t> results;
+	results.reserve(calls_run);
+	for (std::size_t call_index = 0; call_index < calls_run; ++call_index) {
+		const CallRecord & call = _calls[call_index];
+		results.push_back(records[call.offset + 1 + call.argc]);
+	}
+	return results;
+}
+
+}
\ No newline at end of file
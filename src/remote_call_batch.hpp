@@ -0,0 +1,38 @@
+#ifndef LOAD_SRC_REMOTECALLBATCH_HPP_
+#define LOAD_SRC_REMOTECALLBATCH_HPP_
+
+#include <load/codegen/common.hpp>
+#include <load/process/process.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace load::detail {
+
+class RemoteCallBatch
+{
+public:
+	std::size_t add_call(std::uintptr_t target, const ParameterList & params);
+	// The batch stops after this call when the low 32 bits of its result are zero, as for a BOOL that is FALSE
+	std::size_t add_checked_call(std::uintptr_t target, const ParameterList & params);
+	std::size_t size() const;
+
+	// Results of the calls that ran, so a checked call that stopped the batch is the last one
+	std::vector<std::uint64_t> run(Process & process) const;
+
+private:
+	struct CallRecord
+	{
+		std::size_t  offset;
+		unsigned int argc;
+		bool         checked;
+	};
+
+	std::vector<std::uint64_t> _records;
+	std::vector<CallRecord>    _calls;
+};
+
+}
+
+#endif
\ No newline at end of file
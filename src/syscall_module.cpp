@@ -0,0 +1,108 @@
+#include "syscall_module.hpp"
+#include "module_provider.hpp"
+
+#include <load/codegen.hpp>
+#include <load/process.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+
+namespace load {
+
+using namespace detail;
+
+namespace {
+
+auto linux_syscall_module_provider =
+	make_module_provider([] (const std::string & name) {
+		std::shared_ptr<Module> module_sp;
+		if (!is_syscall_module_name(name)) return module_sp;
+
+		// The stubs issue Linux system calls, which other hosts would interpret differently
+#ifdef __linux__
+		const CodeGenerator & code_generator = current_process().code_generator();
+		if (const SystemServices * const linux_services = code_generator.get_system_services("linux"))
+			module_sp = std::make_shared<SyscallModule>(*linux_services);
+#endif
+		return module_sp;
+	});
+
+}
+
+ModuleProvider & syscall_module_provider = linux_syscall_module_provider;
+
+namespace detail {
+
+SyscallModule::SyscallModule(const SystemServices & system_services)
+	: _system_services { &system_services }
+	, _code_arena { 0x1000 }
+{}
+
+ModuleMemoryStats SyscallModule::memory_stats() const
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+
+	ModuleMemoryStats mem_stats;
+	for (const auto & [code, code_stub] : _syscall_procs)
+		mem_stats.committed_size += code_stub.size;
+	mem_stats.metadata_size = sizeof(*this) + _syscall_procs.size() * sizeof(*_syscall_procs.begin());
+	return mem_stats;
+}
+
+ModuleAbi SyscallModule::abi() const
+{
+	return ModuleAbi::Windows;
+}
+
+void * SyscallModule::tls_data() const
+{
+	return nullptr;
+}
+
+DataPtr SyscallModule::get_data_address(std::string_view name) const
+{
+	return get_syscall_proc(name);
+}
+
+ProcPtr SyscallModule::get_proc_address(std::string_view name) const
+{
+	return reinterpret_cast<ProcPtr>(get_syscall_proc(name));
+}
+
+const void * SyscallModule::get_syscall_proc(std::string_view name) const
+{
+	const auto code = _system_services->syscall_code(name);
+	if (!code) return nullptr;
+
+	const std::lock_guard<std::mutex> lock { _mutex };
+
+	auto proc_it = _syscall_procs.find(*code);
+	if (proc_it == _syscall_procs.end()) {
+		const auto code_chunk = _system_services->make_syscall_proc(*code);
+		proc_it = _syscall_procs.emplace(*code, _code_arena.emit(*code_chunk, "libload_syscall_" + std::string(name))).first;
+	}
+
+	return proc_it->second.address;
+}
+
+bool is_syscall_module_name(std::string_view name)
+{
+	constexpr std::string_view module_name = "syscall";
+	constexpr std::string_view module_ext = ".dll";
+
+	const auto iequals = [] (std::string_view lhs, std::string_view rhs) {
+		return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [] (char lch, char rch) {
+			return std::tolower(static_cast<unsigned char>(lch)) == std::tolower(static_cast<unsigned char>(rch));
+		});
+	};
+
+	if (name.size() > module_ext.size() && iequals(name.substr(name.size() - module_ext.size()), module_ext))
+		name.remove_suffix(module_ext.size());
+
+	return iequals(name, module_name);
+}
+
+}
+
+}
\ No newline at end of file
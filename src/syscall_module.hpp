@@ -0,0 +1,40 @@
+#ifndef LOAD_SRC_SYSCALLMODULE_HPP_
+#define LOAD_SRC_SYSCALLMODULE_HPP_
+
+#include "code_arena.hpp"
+
+#include <load/codegen/system_services.hpp>
+#include <load/module/module.hpp>
+
+#include <mutex>
+#include <unordered_map>
+
+namespace load::detail {
+
+class SyscallModule final : public Module
+{
+public:
+	explicit SyscallModule(const SystemServices & system_services);
+
+	virtual ModuleMemoryStats memory_stats() const override;
+	virtual ModuleAbi abi() const override;
+	virtual void * tls_data() const override;
+
+protected:
+	virtual DataPtr get_data_address(std::string_view name) const override;
+	virtual ProcPtr get_proc_address(std::string_view name) const override;
+
+private:
+	const void * get_syscall_proc(std::string_view name) const;
+
+	const SystemServices                     * _system_services;
+	mutable std::mutex                         _mutex;
+	mutable CodeArena                          _code_arena;
+	mutable std::unordered_map<int, CodeStub>  _syscall_procs;
+};
+
+bool is_syscall_module_name(std::string_view name);
+
+}
+
+#endif
\ No newline at end of file
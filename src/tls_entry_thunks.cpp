@@ -0,0 +1,64 @@
+#include <config.hpp>
+#include "tls_entry_thunks.hpp"
+#include "tls_registry.hpp"
+
+#if defined(LIBLOAD_ARCH_X86_64) && defined(LIBLOAD_ENABLE_ARCH_X86_64)
+	#include "arch/x64/abi_thunks.hpp"
+	#define LIBLOAD_HAS_ENTRY_HOOK_THUNKS 1
+#endif
+
+#include <stdexcept>
+
+namespace load::detail {
+
+namespace {
+
+void attach_entering_thread(std::uintptr_t slot_index)
+{
+	tls_registry().attach_thread(static_cast<unsigned int>(slot_index));
+}
+
+}
+
+TlsEntryThunks::TlsEntryThunks(unsigned int slot_index)
+	: _slot_index { slot_index }
+	, _code_arena { 0x1000 }
+{
+	if (!is_tls_entry_thunk_supported())
+		throw std::logic_error("Unsupported TLS entry thunk");
+}
+
+const void * TlsEntryThunks::entry_thunk(const void * module_proc)
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+
+	auto thunk_it = _thunks.find(module_proc);
+	if (thunk_it == _thunks.end()) {
+		std::unique_ptr<CodeChunk> code_chunk;
+#ifdef LIBLOAD_HAS_ENTRY_HOOK_THUNKS
+		code_chunk = make_x64_entry_hook_thunk(reinterpret_cast<std::uintptr_t>(module_proc),
+		                                       reinterpret_cast<std::uintptr_t>(&attach_entering_thread),
+		                                       _slot_index);
+#endif
+		thunk_it = _thunks.emplace(module_proc, _code_arena.emit(*code_chunk, "libload_tls_entry_thunk")).first;
+	}
+
+	return thunk_it->second.address;
+}
+
+bool is_tls_entry_thunk_supported()
+{
+#ifdef LIBLOAD_HAS_ENTRY_HOOK_THUNKS
+	return true;
+#else
+	return false;
+#endif
+}
+
+std::unique_ptr<TlsEntryThunks> make_tls_entry_thunks(unsigned int slot_index)
+{
+	if (!is_tls_entry_thunk_supported()) return nullptr;
+	return std::make_unique<TlsEntryThunks>(slot_index);
+}
+
+}
\ No newline at end of file
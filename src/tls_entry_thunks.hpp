@@ -0,0 +1,35 @@
+#ifndef LOAD_SRC_TLSENTRYTHUNKS_HPP_
+#define LOAD_SRC_TLSENTRYTHUNKS_HPP_
+
+#include "code_arena.hpp"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace load::detail {
+
+// Procedures handed to the host enter the module through these thunks, which attach the calling thread to
+// the module's thread notification slot first
+class TlsEntryThunks
+{
+public:
+	explicit TlsEntryThunks(unsigned int slot_index);
+	TlsEntryThunks(const TlsEntryThunks &) = delete;
+	TlsEntryThunks & operator=(const TlsEntryThunks &) = delete;
+
+	const void * entry_thunk(const void * module_proc);
+
+private:
+	unsigned int _slot_index;
+	std::mutex   _mutex;
+	CodeArena    _code_arena;
+	std::unordered_map<const void *, CodeStub> _thunks;
+};
+
+bool is_tls_entry_thunk_supported();
+std::unique_ptr<TlsEntryThunks> make_tls_entry_thunks(unsigned int slot_index);
+
+}
+
+#endif
\ No newline at end of file
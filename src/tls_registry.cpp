@@ -0,0 +1,286 @@
+#include "tls_registry.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace load::detail {
+
+namespace {
+
+constexpr std::size_t MIN_BLOCK_ALIGNMENT = 16;
+constexpr std::size_t MIN_SLAB_BLOCKS     = 4;
+
+char * align_pointer(char * ptr, std::size_t alignment)
+{
+	const auto addr = reinterpret_cast<std::uintptr_t>(ptr);
+	return ptr + ((alignment - addr % alignment) % alignment);
+}
+
+}
+
+TlsRegistry & tls_registry()
+{
+	static TlsRegistry registry;
+	return registry;
+}
+
+TlsRegistry::TlsRegistry()
+	: _generations { new std::atomic<std::uint32_t>[MAX_SLOTS] {} }
+	, _notify_locks { new std::shared_mutex[MAX_SLOTS] }
+{}
+
+TlsRegistry::ThreadState::~ThreadState()
+{
+	TlsRegistry & registry = tls_registry();
+	for (unsigned int index = 0; index < slots.size(); ++index)
+		registry.release_thread_slot(slots[index], index);
+}
+
+TlsRegistry::ThreadState & TlsRegistry::current_thread()
+{
+	static thread_local ThreadState thread_state;
+	return thread_state;
+}
+
+unsigned int TlsRegistry::allocate_slot(TlsSlotInfo slot_info)
+{
+	slot_info.alignment = std::max<std::size_t>(slot_info.alignment, MIN_BLOCK_ALIGNMENT);
+	const std::size_t block_size = std::max<std::size_t>(slot_info.init_data.size() + slot_info.zero_fill_size, 1);
+
+	Slot slot;
+	slot.block_stride = (block_size + slot_info.alignment - 1) / slot_info.alignment * slot_info.alignment;
+	slot.info = std::make_shared<const TlsSlotInfo>(std::move(slot_info));
+
+	unsigned int index;
+	std::uint32_t generation;
+	{
+		const std::lock_guard<std::mutex> lock { _mutex };
+		if (!_free_indices.empty()) {
+			index = _free_indices.back();
+			_free_indices.pop_back();
+			_slots[index] = std::move(slot);
+		} else if (_slots.size() < MAX_SLOTS) {
+			index = static_cast<unsigned int>(_slots.size());
+			_slots.push_back(std::move(slot));
+		} else {
+			throw std::length_error("Out of TLS slots");
+		}
+		generation = _generations[index].fetch_add(1, std::memory_order_acq_rel) + 1;
+	}
+
+	ThreadState & thread = current_thread();
+	if (thread.slots.size() <= index)
+		thread.slots.resize(index + 1);
+
+	ThreadSlot & thread_slot = thread.slots[index];
+	release_thread_slot(thread_slot, index);
+	thread_slot.generation = generation;
+	return index;
+}
+
+void TlsRegistry::release_slot(unsigned int index)
+{
+	if (index >= MAX_SLOTS)
+		throw std::invalid_argument("TLS slot is not allocated");
+
+	ThreadState & thread = current_thread();
+	if (index < thread.slots.size()
+	 && thread.slots[index].generation == _generations[index].load(std::memory_order_acquire))
+		release_thread_slot(thread.slots[index], index);
+
+	std::vector<std::unique_ptr<char[]>> slabs;
+	{
+		const std::unique_lock<std::shared_mutex> notify_lock { _notify_locks[index] };
+		const std::lock_guard<std::mutex> lock { _mutex };
+		if (index >= _slots.size() || _slots[index].info == nullptr)
+			throw std::invalid_argument("TLS slot is not allocated");
+
+		slabs = std::move(_slots[index].slabs);
+		_slots[index] = Slot();
+		_generations[index].fetch_add(1, std::memory_order_acq_rel);
+		_free_indices.push_back(index);
+	}
+}
+
+void TlsRegistry::attach_thread(unsigned int index)
+{
+	if (index >= MAX_SLOTS) return;
+
+	ThreadState & thread = current_thread();
+	const std::uint32_t generation = _generations[index].load(std::memory_order_acquire);
+	if (index < thread.slots.size() && thread.slots[index].attached && thread.slots[index].generation == generation)
+		return;
+
+	if (thread.slots.size() <= index)
+		thread.slots.resize(index + 1);
+
+	ThreadSlot & thread_slot = thread.slots[index];
+	if (thread_slot.generation != generation) {
+		release_thread_slot(thread_slot, index);
+		thread_slot.generation = generation;
+	}
+	thread_slot.attached = true;
+	notify_thread(index, generation, true);
+}
+
+void * TlsRegistry::thread_block(unsigned int index)
+{
+	ThreadState & thread = current_thread();
+	if (index < thread.slots.size()) {
+		const ThreadSlot & thread_slot = thread.slots[index];
+		if (thread_slot.block != nullptr
+		 && thread_slot.generation == _generations[index].load(std::memory_order_acquire))
+			return thread_slot.block;
+	}
+
+	return create_thread_block(thread, index);
+}
+
+std::size_t TlsRegistry::slab_count() const
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+	std::size_t count = 0;
+	for (const Slot & slot : _slots)
+		count += slot.slabs.size();
+	return count;
+}
+
+TlsRegistry::SlotInfoPtr TlsRegistry::find_slot_info(unsigned int index, std::uint32_t generation) const
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+	if (index >= _slots.size() || _generations[index].load(std::memory_order_relaxed) != generation)
+		return nullptr;
+	return _slots[index].info;
+}
+
+void * TlsRegistry::create_thread_block(ThreadState & thread, unsigned int index)
+{
+	if (index >= MAX_SLOTS)
+		throw std::out_of_range("Invalid TLS slot");
+
+	const std::uint32_t generation = _generations[index].load(std::memory_order_acquire);
+	const SlotInfoPtr slot_info = find_slot_info(index, generation);
+	if (slot_info == nullptr)
+		throw std::invalid_argument("TLS slot is not allocated");
+
+	if (thread.slots.size() <= index)
+		thread.slots.resize(index + 1);
+
+	ThreadSlot & thread_slot = thread.slots[index];
+	if (thread_slot.generation != generation) {
+		release_thread_slot(thread_slot, index);
+		thread_slot.generation = generation;
+	}
+
+	char * const block = allocate_block(index, generation);
+	if (block == nullptr)
+		throw std::invalid_argument("TLS slot is not allocated");
+
+	const std::size_t data_size = slot_info->init_data.size();
+	std::memcpy(block, slot_info->init_data.data(), data_size);
+	std::memset(block + data_size, 0, slot_info->zero_fill_size);
+
+	thread_slot.block = block;
+	return block;
+}
+
+void TlsRegistry::release_thread_slot(ThreadSlot & thread_slot, unsigned int index)
+{
+	// The detach notification may attach other slots, which can move the thread's slot vector
+	const ThreadSlot released = std::exchange(thread_slot, ThreadSlot());
+	if (released.generation == 0) return;
+
+	if (released.attached)
+		notify_thread(index, released.generation, false);
+	if (released.block != nullptr)
+		free_block(index, released.generation, released.block);
+}
+
+void TlsRegistry::notify_thread(unsigned int index, std::uint32_t generation, bool attach)
+{
+	const std::shared_lock<std::shared_mutex> notify_lock { _notify_locks[index] };
+	const SlotInfoPtr slot_info = find_slot_info(index, generation);
+	if (slot_info == nullptr) return;
+
+	const std::function<void ()> & notify = attach ? slot_info->thread_attach : slot_info->thread_detach;
+	if (notify)
+		notify();
+}
+
+char * TlsRegistry::allocate_block(unsigned int index, std::uint32_t generation)
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+	if (_generations[index].load(std::memory_order_relaxed) != generation)
+		return nullptr;
+
+	Slot & slot = _slots[index];
+	if (!slot.free_blocks.empty()) {
+		char * const block = slot.free_blocks.back();
+		slot.free_blocks.pop_back();
+		return block;
+	}
+
+	if (slot.slab_cursor == slot.slab_end) {
+		// Slabs start small and grow, so a slot touched by few threads stays cheap
+		const std::size_t max_blocks = std::max<std::size_t>(SLAB_SIZE / slot.block_stride, 1);
+		const std::size_t slab_blocks = std::min<std::size_t>(MIN_SLAB_BLOCKS << std::min<std::size_t>(slot.slabs.size(), 16),
+		                                                      max_blocks);
+		const std::size_t slab_size = slab_blocks * slot.block_stride;
+		const std::size_t alignment = slot.info->alignment;
+		char * const slab = slot.slabs.emplace_back(new char[slab_size + alignment]).get();
+		slot.slab_cursor = align_pointer(slab, alignment);
+		slot.slab_end = slot.slab_cursor + slab_size;
+	}
+
+	char * const block = slot.slab_cursor;
+	slot.slab_cursor += slot.block_stride;
+	return block;
+}
+
+void TlsRegistry::free_block(unsigned int index, std::uint32_t generation, char * block)
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+	if (_generations[index].load(std::memory_order_relaxed) == generation)
+		_slots[index].free_blocks.push_back(block);
+}
+
+TlsSlot::TlsSlot(TlsSlotInfo slot_info)
+	: _index { tls_registry().allocate_slot(std::move(slot_info)) } {}
+
+TlsSlot::TlsSlot(TlsSlot && other)
+	: _index { std::exchange(other._index, INVALID_INDEX) } {}
+
+TlsSlot & TlsSlot::operator=(TlsSlot && other)
+{
+	if (this != &other) {
+		reset();
+		_index = std::exchange(other._index, INVALID_INDEX);
+	}
+	return *this;
+}
+
+TlsSlot::~TlsSlot()
+{
+	reset();
+}
+
+void TlsSlot::attach_thread() const
+{
+	if (_index != INVALID_INDEX)
+		tls_registry().attach_thread(_index);
+}
+
+void * TlsSlot::thread_block() const
+{
+	return _index != INVALID_INDEX ? tls_registry().thread_block(_index) : nullptr;
+}
+
+void TlsSlot::reset()
+{
+	if (_index != INVALID_INDEX)
+		tls_registry().release_slot(std::exchange(_index, INVALID_INDEX));
+}
+
+}
\ No newline at end of file
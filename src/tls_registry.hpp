@@ -0,0 +1,121 @@
+#ifndef LOAD_SRC_TLSREGISTRY_HPP_
+#define LOAD_SRC_TLSREGISTRY_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+namespace load::detail {
+
+struct TlsSlotInfo
+{
+	std::vector<char>      init_data;
+	std::size_t            zero_fill_size = 0;
+	std::size_t            alignment      = 16;
+	std::function<void ()> thread_attach;
+	std::function<void ()> thread_detach;
+};
+
+class TlsRegistry
+{
+public:
+	enum { MAX_SLOTS = 1088, SLAB_SIZE = 0x10000 };
+
+	TlsRegistry(const TlsRegistry &) = delete;
+	TlsRegistry & operator=(const TlsRegistry &) = delete;
+
+	unsigned int allocate_slot(TlsSlotInfo slot_info);
+
+	// Detaches the calling thread, waits for thread notifications in progress elsewhere, then frees the blocks
+	void release_slot(unsigned int index);
+
+	// Sends the thread attach notification on the calling thread's first call
+	void attach_thread(unsigned int index);
+
+	// Creates the calling thread's block from the template; this does not attach the thread
+	void * thread_block(unsigned int index);
+
+	std::size_t slab_count() const;
+
+private:
+	using SlotInfoPtr = std::shared_ptr<const TlsSlotInfo>;
+
+	// Blocks of a slot are carved from its own slabs, which go away with the slot
+	struct Slot
+	{
+		SlotInfoPtr                          info;
+		std::size_t                          block_stride = 0;
+		std::vector<std::unique_ptr<char[]>> slabs;
+		char                               * slab_cursor  = nullptr;
+		char                               * slab_end     = nullptr;
+		std::vector<char *>                  free_blocks;
+	};
+
+	struct ThreadSlot
+	{
+		char        * block      = nullptr;
+		std::uint32_t generation = 0;
+		bool          attached   = false;
+	};
+
+	struct ThreadState
+	{
+		~ThreadState();
+		std::vector<ThreadSlot> slots;
+	};
+
+	TlsRegistry();
+	friend TlsRegistry & tls_registry();
+
+	static ThreadState & current_thread();
+
+	SlotInfoPtr find_slot_info(unsigned int index, std::uint32_t generation) const;
+	void * create_thread_block(ThreadState & thread, unsigned int index);
+	void release_thread_slot(ThreadSlot & thread_slot, unsigned int index);
+
+	// Skipped once the slot is released; release_slot waits for a notification that already started
+	void notify_thread(unsigned int index, std::uint32_t generation, bool attach);
+
+	char * allocate_block(unsigned int index, std::uint32_t generation);
+	void free_block(unsigned int index, std::uint32_t generation, char * block);
+
+	mutable std::mutex                            _mutex;
+	std::unique_ptr<std::atomic<std::uint32_t>[]> _generations;
+	std::unique_ptr<std::shared_mutex[]>          _notify_locks;
+	std::vector<Slot>                             _slots;
+	std::vector<unsigned int>                     _free_indices;
+};
+
+TlsRegistry & tls_registry();
+
+class TlsSlot
+{
+public:
+	enum : unsigned int { INVALID_INDEX = ~0u };
+
+	TlsSlot() = default;
+	explicit TlsSlot(TlsSlotInfo slot_info);
+	TlsSlot(TlsSlot && other);
+	TlsSlot & operator=(TlsSlot && other);
+	~TlsSlot();
+
+	explicit operator bool() const { return _index != INVALID_INDEX; }
+	unsigned int index() const { return _index; }
+
+	void attach_thread() const;
+	void * thread_block() const;
+	void reset();
+
+private:
+	unsigned int _index = INVALID_INDEX;
+};
+
+}
+
+#endif
\ No newline at end of file
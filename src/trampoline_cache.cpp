@@ -0,0 +1,59 @@
+#include "trampoline_cache.hpp"
+
+#include <load/codegen/code_chunk.hpp>
+
+#include <stdexcept>
+#include <string>
+
+namespace load::detail {
+
+TrampolineRecord make_trampoline_record(std::uintptr_t target, const ParameterList & params)
+{
+	TrampolineRecord record;
+	record.reserve(params.size() + 2);
+	record.push_back(target);
+	for (const std::uintmax_t param : params) {
+		if (param > UINT64_MAX)
+			throw std::overflow_error("Parameter value exceeds 64 bits");
+		record.push_back(param);
+	}
+	record.push_back(0);
+	return record;
+}
+
+std::uint64_t trampoline_record_result(const TrampolineRecord & record)
+{
+	return record.back();
+}
+
+TrampolineCache::TrampolineCache(CodeArena & code_arena)
+	: _code_arena { &code_arena } {}
+
+TrampolineCache::~TrampolineCache()
+{
+	for (const auto & [key, code_stub] : _trampolines)
+		_code_arena->free(code_stub);
+}
+
+void * TrampolineCache::get_trampoline(const CallingConvention & calling_convention, unsigned int argc)
+{
+	const std::lock_guard<std::mutex> lock { _mutex };
+
+	const TrampolineKey key { &calling_convention, argc };
+	auto trampoline_it = _trampolines.find(key);
+	if (trampoline_it == _trampolines.end()) {
+		const auto code_chunk = calling_convention.make_trampoline(argc);
+		trampoline_it = _trampolines.emplace(key, _code_arena->emit(*code_chunk, "libload_trampoline_" + std::to_string(argc))).first;
+	}
+
+	return trampoline_it->second.address;
+}
+
+TrampolineCache & local_trampoline_cache()
+{
+	static CodeArena code_arena;
+	static TrampolineCache trampoline_cache { code_arena };
+	return trampoline_cache;
+}
+
+}
\ No newline at end of file
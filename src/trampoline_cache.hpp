@@ -0,0 +1,45 @@
+#ifndef LOAD_SRC_TRAMPOLINECACHE_HPP_
+#define LOAD_SRC_TRAMPOLINECACHE_HPP_
+
+#include "code_arena.hpp"
+
+#include <load/codegen/calling_convention.hpp>
+#include <load/codegen/common.hpp>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace load::detail {
+
+using TrampolineRecord = std::vector<std::uint64_t>;
+
+TrampolineRecord make_trampoline_record(std::uintptr_t target, const ParameterList & params);
+std::uint64_t trampoline_record_result(const TrampolineRecord & record);
+
+class TrampolineCache
+{
+public:
+	explicit TrampolineCache(CodeArena & code_arena);
+	TrampolineCache(const TrampolineCache &) = delete;
+	TrampolineCache & operator=(const TrampolineCache &) = delete;
+	~TrampolineCache();
+
+	void * get_trampoline(const CallingConvention & calling_convention, unsigned int argc);
+
+private:
+	using TrampolineKey = std::pair<const CallingConvention *, unsigned int>;
+
+	std::mutex                        _mutex;
+	CodeArena                       * _code_arena;
+	std::map<TrampolineKey, CodeStub> _trampolines;
+};
+
+// Trampolines for calls issued into the current process, which live as long as the process
+TrampolineCache & local_trampoline_cache();
+
+}
+
+#endif
\ No newline at end of file
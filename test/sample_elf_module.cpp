@@ -0,0 +1,39 @@
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+extern "C" {
+
+int sample_data = 123;
+int sample_init_data = 0;
+
+extern const char * const sample_strings[];
+const char * const sample_strings[] = { "libload", "elf", "module" };
+
+__attribute__((constructor)) static void sample_init()
+{
+	sample_init_data = 456;
+}
+
+int sample_proc()
+{
+	return 123;
+}
+
+const char * sample_string(int index)
+{
+	return sample_strings[index];
+}
+
+std::size_t sample_strlen(const char * str)
+{
+	return std::strlen(str);
+}
+
+void sample_throw(int value)
+{
+	throw std::runtime_error(std::to_string(value));
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#define BOOST_TEST_MODULE AbiThunks
+#include <boost/test/unit_test.hpp>
+
+#include "../src/abi_bridge.hpp"
+#include "../src/arch/x64/abi_thunks.hpp"
+#include "../src/call_counters.hpp"
+#include "../src/code_arena.hpp"
+#include "../src/code_chunk.hpp"
+
+#include <load/module.hpp>
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#define TEST_MS_ABI __attribute__((ms_abi))
+
+using namespace load;
+
+std::uint64_t TEST_MS_ABI weighted_sum(std::uint64_t a, std::uint64_t b, std::uint64_t c,
+                                       std::uint64_t d, std::uint64_t e, std::uint64_t f)
+{
+	return a + 2 * b + 3 * c + 4 * d + 5 * e + 6 * f;
+}
+
+[[noreturn]] void TEST_MS_ABI throwing_proc(std::uint64_t value)
+{
+	throw std::runtime_error(std::to_string(value));
+}
+
+std::uint64_t sum8(std::uint64_t a, std::uint64_t b, std::uint64_t c, std::uint64_t d,
+                   std::uint64_t e, std::uint64_t f, std::uint64_t g, std::uint64_t h)
+{
+	return a + 2 * b + 3 * c + 4 * d + 5 * e + 6 * f + 7 * g + 8 * h;
+}
+
+BOOST_AUTO_TEST_CASE(abi_thunks)
+{
+	detail::CodeArena code_arena;
+
+	const auto export_chunk = detail::make_x64_sysv_to_win64_thunk(reinterpret_cast<std::uintptr_t>(&weighted_sum), 6);
+	const detail::CodeStub export_stub = code_arena.emit(*export_chunk);
+	using sysv_sum6_fn = std::uint64_t (std::uint64_t, std::uint64_t, std::uint64_t,
+	                                    std::uint64_t, std::uint64_t, std::uint64_t);
+	const auto sysv_sum6 = reinterpret_cast<sysv_sum6_fn *>(export_stub.address);
+	BOOST_TEST(sysv_sum6(1, 1, 1, 1, 1, 2) == 27u);
+
+	const auto import_chunk = detail::make_x64_win64_to_sysv_thunk(reinterpret_cast<std::uintptr_t>(&sum8), 8);
+	const detail::CodeStub import_stub = code_arena.emit(*import_chunk);
+	using ms_sum8_fn = std::uint64_t TEST_MS_ABI (std::uint64_t, std::uint64_t, std::uint64_t, std::uint64_t,
+	                                              std::uint64_t, std::uint64_t, std::uint64_t, std::uint64_t);
+	const auto ms_sum8 = reinterpret_cast<ms_sum8_fn *>(import_stub.address);
+	BOOST_TEST(ms_sum8(1, 1, 1, 1, 1, 1, 1, 2) == 44u);
+
+	detail::AbiBridge abi_bridge { ModuleAbi::Windows, ModuleAbi::SystemV };
+	const void * const export_thunk = abi_bridge.export_thunk(reinterpret_cast<const void *>(&weighted_sum));
+	BOOST_TEST(abi_bridge.export_thunk(reinterpret_cast<const void *>(&weighted_sum)) == export_thunk);
+	BOOST_TEST(reinterpret_cast<sysv_sum6_fn *>(const_cast<void *>(export_thunk))(0, 0, 0, 0, 0, 1) == 6u);
+
+	using ms_strtoull_fn = unsigned long long TEST_MS_ABI (const char *, char **, int);
+	const auto host_strtoull = reinterpret_cast<const void *>(&std::strtoull);
+	const void * const import_thunk = abi_bridge.import_thunk(host_strtoull);
+	BOOST_TEST(import_thunk != host_strtoull);
+	BOOST_TEST(reinterpret_cast<ms_strtoull_fn *>(const_cast<void *>(import_thunk))("4096", nullptr, 16) == 0x4096u);
+	BOOST_TEST(abi_bridge.import_thunk(&environ) == &environ);
+}
+
+BOOST_AUTO_TEST_CASE(import_call_counters)
+{
+	using ms_sum8_fn = std::uint64_t TEST_MS_ABI (std::uint64_t, std::uint64_t, std::uint64_t, std::uint64_t,
+	                                              std::uint64_t, std::uint64_t, std::uint64_t, std::uint64_t);
+	using ms_throwing_fn = void TEST_MS_ABI (std::uint64_t);
+
+	detail::AbiBridge abi_bridge { ModuleAbi::Windows, ModuleAbi::SystemV };
+	const void * const sum8_thunk = abi_bridge.import_thunk(reinterpret_cast<const void *>(&sum8));
+
+	for (const auto instrumentation : { CallInstrumentation::CountCalls, CallInstrumentation::CountAndTimeCalls }) {
+		const bool timed = instrumentation == CallInstrumentation::CountAndTimeCalls;
+		const auto call_counters = detail::make_import_call_counters(instrumentation);
+		const auto counted_sum8 = reinterpret_cast<ms_sum8_fn *>(
+			const_cast<void *>(call_counters->counting_thunk("host", "sum8", sum8_thunk)));
+		const auto counted_throwing = reinterpret_cast<ms_throwing_fn *>(
+			const_cast<void *>(call_counters->counting_thunk("host", "throwing_proc",
+			                                                 reinterpret_cast<const void *>(&throwing_proc))));
+
+		for (std::uint64_t i = 0; i < 10; ++i)
+			BOOST_TEST(counted_sum8(i, 1, 1, 1, 1, 1, 1, 2) == i + 43);
+		try {
+			counted_throwing(7);
+			BOOST_ERROR("Exception did not propagate");
+		} catch (const std::runtime_error & error) {
+			BOOST_TEST(error.what() == std::string("7"));
+		}
+
+		const ModuleCallStats call_stats = call_counters->stats();
+		BOOST_REQUIRE_EQUAL(call_stats.imports.size(), 2);
+		BOOST_TEST(call_stats.imports[0].module_name == "host");
+		BOOST_TEST(call_stats.imports[0].proc_name == "sum8");
+		BOOST_TEST(call_stats.imports[0].call_count == 10u);
+		BOOST_TEST((call_stats.imports[0].cycle_count != 0) == timed);
+		BOOST_TEST(call_stats.imports[1].call_count == (timed ? 0u : 1u));
+		BOOST_TEST(call_stats.call_count == call_stats.imports[0].call_count + call_stats.imports[1].call_count);
+	}
+
+	const auto call_counters = detail::make_import_call_counters(CallInstrumentation::CountCalls);
+	const void * const environ_import = call_counters->import_thunk("libc", "environ", &environ, nullptr);
+	BOOST_TEST(environ_import == &environ);
+
+	const auto counted_getpid = reinterpret_cast<pid_t (*)()>(const_cast<void *>(
+		call_counters->import_thunk("libc", "getpid", reinterpret_cast<const void *>(&getpid), nullptr)));
+	BOOST_TEST(counted_getpid != &getpid);
+	BOOST_TEST(counted_getpid() == getpid());
+	BOOST_REQUIRE_EQUAL(call_counters->stats().imports.size(), 1);
+	BOOST_TEST(call_counters->stats().call_count == 1u);
+
+	BOOST_TEST(!detail::make_import_call_counters(CallInstrumentation::None));
+}
\ No newline at end of file
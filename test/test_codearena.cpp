@@ -0,0 +1,139 @@
+#define BOOST_TEST_MODULE CodeArena
+#include <boost/test/unit_test.hpp>
+
+#include "../src/code_arena.hpp"
+#include "../src/code_chunk.hpp"
+#include "../src/trampoline_cache.hpp"
+
+#include <load/codegen.hpp>
+#include <load/process.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#	define TEST_MS_ABI
+#else
+#	define TEST_MS_ABI __attribute__((ms_abi))
+#endif
+
+using namespace load;
+
+struct CodeGeneratorTest
+{
+	CodeGeneratorTest()
+		: _code_generator { &current_process().code_generator() }
+	{}
+
+	const CodeGenerator * _code_generator;
+};
+
+detail::CodeBlock make_stub_fn(const CallingConvention & calling_convention)
+{
+	detail::CodeBlock code_block;
+	code_block.add(calling_convention.make_prolog(0));
+	code_block.add(calling_convention.set_return_value(0));
+	code_block.add(calling_convention.make_epilog(0));
+	return code_block;
+}
+
+BOOST_FIXTURE_TEST_CASE(code_arena, CodeGeneratorTest)
+{
+	const auto cconv = _code_generator->get_calling_convention();
+	if (cconv == nullptr) return;
+
+	detail::CodeArena code_arena { 0x1000 };
+	const auto stub_fn = make_stub_fn(*cconv);
+
+	std::vector<detail::CodeStub> code_stubs;
+	for (int i = 0; i < 256; ++i) {
+		const detail::CodeStub code_stub = code_arena.emit(stub_fn);
+		BOOST_TEST(reinterpret_cast<int (*)()>(code_stub.address)() == 0);
+		code_stubs.push_back(code_stub);
+	}
+	BOOST_TEST(code_arena.slab_count() < code_stubs.size() / 16);
+
+	const std::size_t slab_count = code_arena.slab_count();
+	for (const detail::CodeStub & code_stub : code_stubs)
+		code_arena.free(code_stub);
+	for (std::size_t i = 0; i < code_stubs.size(); ++i)
+		code_arena.emit(stub_fn);
+	BOOST_TEST(code_arena.slab_count() == slab_count);
+}
+
+std::uint64_t TEST_MS_ABI weighted_sum(std::uint64_t a, std::uint64_t b, std::uint64_t c,
+                                       std::uint64_t d, std::uint64_t e, std::uint64_t f)
+{
+	return a + 2 * b + 3 * c + 4 * d + 5 * e + 6 * f;
+}
+
+BOOST_FIXTURE_TEST_CASE(trampoline_cache, CodeGeneratorTest)
+{
+	const auto cconv = _code_generator->get_calling_convention();
+	if (cconv == nullptr) return;
+
+	detail::CodeArena code_arena;
+	detail::TrampolineCache trampoline_cache { code_arena };
+	void * const trampoline = trampoline_cache.get_trampoline(*cconv, 6);
+	BOOST_TEST(trampoline_cache.get_trampoline(*cconv, 6) == trampoline);
+	BOOST_TEST(trampoline_cache.get_trampoline(*cconv, 2) != trampoline);
+
+	const auto target = reinterpret_cast<std::uintptr_t>(&weighted_sum);
+	for (std::uint64_t i = 0; i < 4; ++i) {
+		auto record = detail::make_trampoline_record(target, { i, 1, 2, 3, 4, 5 });
+
+		detail::CodeBlock caller;
+		caller.add(cconv->make_prolog(0));
+		caller.add(cconv->invoke_proc(detail::AbsoluteCodeLocation(trampoline),
+		                              detail::make_proc_params(reinterpret_cast<std::uintptr_t>(record.data()))));
+		caller.add(cconv->make_epilog(0));
+
+		const detail::CodeStub caller_stub = code_arena.emit(caller);
+		reinterpret_cast<void (*)()>(caller_stub.address)();
+		code_arena.free(caller_stub);
+
+		BOOST_TEST(detail::trampoline_record_result(record) == i + 2 + 6 + 12 + 20 + 30);
+	}
+}
+
+[[noreturn]] void TEST_MS_ABI throwing_proc(std::uint64_t value)
+{
+	throw std::runtime_error(std::to_string(value));
+}
+
+BOOST_FIXTURE_TEST_CASE(unwind_info, CodeGeneratorTest)
+{
+	const auto cconv = _code_generator->get_calling_convention();
+	if (cconv == nullptr) return;
+
+	const auto prolog_rules = detail::collect_call_frame_rules(*cconv->make_prolog(0), nullptr);
+	BOOST_REQUIRE_EQUAL(prolog_rules.size(), 3);
+	BOOST_TEST(prolog_rules[0].offset == 1);
+	BOOST_TEST(prolog_rules[0].kind == detail::CallFrameRule::DefCfaOffset);
+	BOOST_TEST(prolog_rules[2].offset == 4);
+	BOOST_TEST(prolog_rules[2].kind == detail::CallFrameRule::DefCfaRegister);
+
+#if defined(__linux__) && defined(__x86_64__)
+	detail::CodeArena code_arena;
+	detail::TrampolineCache trampoline_cache { code_arena };
+	void * const trampoline = trampoline_cache.get_trampoline(*cconv, 1);
+
+	auto record = detail::make_trampoline_record(reinterpret_cast<std::uintptr_t>(&throwing_proc), { 42 });
+	detail::CodeBlock caller;
+	caller.add(cconv->make_prolog(0));
+	caller.add(cconv->invoke_proc(detail::AbsoluteCodeLocation(trampoline),
+	                              detail::make_proc_params(reinterpret_cast<std::uintptr_t>(record.data()))));
+	caller.add(cconv->make_epilog(0));
+
+	const detail::CodeStub caller_stub = code_arena.emit(caller);
+	try {
+		reinterpret_cast<void (*)()>(caller_stub.address)();
+		BOOST_ERROR("Exception did not propagate");
+	} catch (const std::runtime_error & error) {
+		BOOST_TEST(error.what() == std::string("42"));
+	}
+	code_arena.free(caller_stub);
+#endif
+}
\ No newline at end of file
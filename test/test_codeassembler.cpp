@@ -0,0 +1,159 @@
+#define BOOST_TEST_MODULE CodeAssembler
+#include <boost/test/unit_test.hpp>
+
+#include "../src/code_arena.hpp"
+#include "../src/code_chunk.hpp"
+
+#include <load/codegen.hpp>
+#include <load/process.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+using namespace load;
+
+struct CodeGeneratorTest
+{
+	CodeGeneratorTest()
+		: _code_generator { &current_process().code_generator() }
+	{}
+
+	const CodeGenerator * _code_generator;
+};
+
+struct StringCodeSink final : public CodeSink
+{
+	virtual void append(const char * data, std::size_t size) override
+	{
+		code.append(data, size);
+	}
+
+	std::string code;
+};
+
+BOOST_AUTO_TEST_CASE(assembler_rel32)
+{
+	detail::CodeAssembler code_chunk;
+	code_chunk.append('\x90');
+	code_chunk.append('\xe8');
+	code_chunk.append_rel32(0x10000);
+	code_chunk.append_imm32(0xdeadbeef);
+	BOOST_TEST(code_chunk.max_size() == 10u);
+
+	StringCodeSink code_sink;
+	const std::size_t code_size = code_chunk.emit(reinterpret_cast<void *>(0x8000), code_sink);
+	BOOST_TEST(code_size == 10u);
+	BOOST_TEST(code_sink.code == std::string("\x90\xe8\xfa\x7f\x00\x00\xef\xbe\xad\xde", 10));
+
+	StringCodeSink far_sink;
+	BOOST_CHECK_THROW(code_chunk.emit(reinterpret_cast<void *>(0x100000000), far_sink), std::overflow_error);
+}
+
+BOOST_FIXTURE_TEST_CASE(compact_immediates, CodeGeneratorTest)
+{
+	const auto cconv = _code_generator->get_calling_convention();
+	if (cconv == nullptr) return;
+
+	const std::pair<std::uintmax_t, std::size_t> values[] = {
+		{ 0, 2 }, { 1, 5 }, { 0xffffffff, 5 }, { std::uint64_t(-2), 7 }, { 0x123456789, 10 }
+	};
+
+	detail::CodeArena code_arena;
+	for (const auto & [value, encoded_size] : values) {
+		BOOST_TEST(cconv->set_return_value(value)->max_size() == encoded_size);
+
+		detail::CodeBlock code_block;
+		code_block.add(cconv->make_prolog(0));
+		code_block.add(cconv->set_return_value(value));
+		code_block.add(cconv->make_epilog(0));
+
+		const detail::CodeStub code_stub = code_arena.emit(code_block);
+		BOOST_TEST(reinterpret_cast<std::uint64_t (*)()>(code_stub.address)() == value);
+		code_arena.free(code_stub);
+	}
+}
+
+bool far_target_called = false;
+
+void far_target()
+{
+	far_target_called = true;
+}
+
+BOOST_FIXTURE_TEST_CASE(far_call, CodeGeneratorTest)
+{
+	const auto cconv = _code_generator->get_calling_convention();
+	if (cconv == nullptr) return;
+
+	const auto target = reinterpret_cast<void *>(&far_target);
+	detail::CodeBlock caller;
+	caller.add(cconv->make_prolog(0));
+	caller.add(cconv->invoke_proc(detail::AbsoluteCodeLocation(target), {}));
+	caller.add(cconv->make_epilog(0));
+
+	StringCodeSink far_sink;
+	const auto far_location = static_cast<char *>(target) + 0x100000000;
+	BOOST_TEST(caller.emit(far_location, far_sink) == caller.max_size());
+	BOOST_TEST(far_sink.code.find("\xff\x15") != std::string::npos);
+
+	StringCodeSink near_sink;
+	const auto near_location = static_cast<char *>(target) + 0x1000;
+	BOOST_TEST(caller.emit(near_location, near_sink) < caller.max_size());
+	BOOST_TEST(near_sink.code.find("\xe8") != std::string::npos);
+
+	detail::CodeArena code_arena;
+	const detail::CodeStub code_stub = code_arena.emit(caller);
+	reinterpret_cast<void (*)()>(code_stub.address)();
+	BOOST_TEST(far_target_called);
+}
+
+BOOST_AUTO_TEST_CASE(branch_relaxation)
+{
+	detail::CodeArena code_arena;
+
+	detail::CodeBlock loop_block;
+	const detail::CodeLabel loop_label = loop_block.make_label();
+	loop_block.add(std::make_unique<detail::CodeChunkLiteral>(
+		std::string_view("\x31\xc0"             // xor eax, eax
+		                 "\xb9\x0a\x00\x00\x00", 7))); // mov ecx, 10
+	loop_block.bind(loop_label);
+	loop_block.add(std::make_unique<detail::CodeChunkLiteral>(
+		"\x01\xc8" // add eax, ecx
+		"\xff\xc9" // dec ecx
+	));
+	loop_block.add_branch(loop_label, detail::BranchCondition::NotEqual);
+	loop_block.add(std::make_unique<detail::CodeChunkLiteral>("\xc3" /* ret */));
+
+	StringCodeSink loop_sink;
+	BOOST_TEST(loop_block.emit(nullptr, loop_sink) == 14u);
+	BOOST_TEST(loop_block.max_size() == 18u);
+
+	const detail::CodeStub loop_stub = code_arena.emit(loop_block);
+	BOOST_TEST(reinterpret_cast<int (*)()>(loop_stub.address)() == 55);
+
+	static const std::string padding (200, '\x90');
+	detail::CodeBlock skip_block;
+	const detail::CodeLabel skip_label = skip_block.make_label();
+	skip_block.add_branch(skip_label);
+	skip_block.add(std::make_unique<detail::CodeChunkLiteral>(padding));
+	skip_block.bind(skip_label);
+	skip_block.add(std::make_unique<detail::CodeChunkLiteral>(
+		std::string_view("\xb8\x01\x00\x00\x00" // mov eax, 1
+		                 "\xc3", 6)));          // ret
+
+	StringCodeSink skip_sink;
+	BOOST_TEST(skip_block.emit(nullptr, skip_sink) == 5u + 200u + 6u);
+	BOOST_TEST(skip_sink.code.substr(0, 5) == std::string("\xe9\xc8\x00\x00\x00", 5));
+
+	const detail::CodeStub skip_stub = code_arena.emit(skip_block);
+	BOOST_TEST(reinterpret_cast<int (*)()>(skip_stub.address)() == 1);
+
+	detail::CodeBlock unbound_block;
+	unbound_block.add_branch(unbound_block.make_label());
+	StringCodeSink unbound_sink;
+	BOOST_CHECK_THROW(unbound_block.emit(nullptr, unbound_sink), std::logic_error);
+}
\ No newline at end of file
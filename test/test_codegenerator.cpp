@@ -10,6 +10,11 @@
 
 #include <utility>
 
+#if !defined(_WIN32) && !defined(__stdcall)
+#	define __stdcall
+#	define __cdecl
+#endif
+
 using namespace load;
 
 struct CodeGeneratorTest
@@ -38,7 +43,7 @@ auto invoke_code_block(const detail::CodeBlock & code_block, Args && ...args)
 	detail::OwnedMemoryBlock mem_block { memory_manager, memory_manager.allocate(0, block_size), block_size };
 	memory_manager.commit(mem_block.data(), mem_block.size());
 	
-	code_block.emit(mem_block.data(), detail::MemoryBufferCodeSink(mem_block));
+	detail::emit_code(code_block, memory_manager, mem_block.data());
 	const int mem_access = MemoryManager::ReadAccess | MemoryManager::ExecuteAccess;
 	memory_manager.set_access(mem_block.data(), mem_block.size(), mem_access);
 	return reinterpret_cast<Fn>(mem_block.data())(std::forward<Args>(args)...);
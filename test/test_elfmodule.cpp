@@ -0,0 +1,279 @@
+#define BOOST_TEST_MODULE ElfModule
+#include <boost/test/unit_test.hpp>
+
+#include <load/memory.hpp>
+#include <load/module.hpp>
+
+#include <elf.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+using namespace load;
+
+namespace {
+
+constexpr std::size_t fake_strlen_result = 42;
+
+std::size_t fake_strlen(const char *)
+{
+	return fake_strlen_result;
+}
+
+std::string mapping_permissions(const void * address)
+{
+	const auto addr = reinterpret_cast<std::uintptr_t>(address);
+	std::ifstream maps { "/proc/self/maps" };
+	std::string line;
+	while (std::getline(maps, line)) {
+		std::istringstream fields { line };
+		std::uintptr_t begin, end;
+		char dash;
+		std::string permissions;
+		fields >> std::hex >> begin >> dash >> end >> permissions;
+		if (begin <= addr && addr < end) return permissions;
+	}
+	return {};
+}
+
+}
+
+struct ModuleTest
+{
+	ModuleTest()
+		: _file { "libsample_elf_module.so" }
+	{}
+
+	MappedFile _file;
+};
+
+BOOST_FIXTURE_TEST_CASE(load_module_from_memory, ModuleTest)
+{
+	BOOST_REQUIRE_NO_THROW({
+		auto module = load::load_module(_file);
+		BOOST_REQUIRE_NE(module, nullptr);
+		BOOST_CHECK(module->abi() == ModuleAbi::SystemV);
+	});
+}
+
+struct StringBuffer final : public MemoryBuffer
+{
+	explicit StringBuffer(std::string data)
+		: data { std::move(data) }
+	{}
+
+	virtual std::size_t read(std::size_t offset, std::size_t size, void * into_buffer) const override
+	{
+		return data.copy(static_cast<char *>(into_buffer), size, std::min(offset, data.size()));
+	}
+
+	std::string data;
+};
+
+BOOST_FIXTURE_TEST_CASE(detect_format, ModuleTest)
+{
+	const ModuleFormatMatch match = detect_module_format(_file);
+	BOOST_REQUIRE(match);
+	BOOST_TEST(match.format->name() == "elf64");
+
+	const std::string headers { _file.contiguous_data(), 0x40 };
+	BOOST_TEST(detect_module_format(StringBuffer(headers)).format == match.format);
+	BOOST_CHECK(detect_module_format(StringBuffer(headers.substr(0, 0x20))).error == ModuleFormatError::TruncatedHeaders);
+
+	std::string other_machine = headers;
+	other_machine[0x12] = char(EM_AARCH64);
+	BOOST_CHECK(detect_module_format(StringBuffer(other_machine)).error == ModuleFormatError::UnsupportedMachine);
+	BOOST_TEST(load::load_module(StringBuffer(other_machine)) == nullptr);
+
+	std::string executable = headers;
+	executable[0x10] = char(ET_EXEC);
+	BOOST_CHECK(detect_module_format(StringBuffer(executable)).error == ModuleFormatError::UnsupportedImage);
+}
+
+struct NullModuleProvider final : public ModuleProvider
+{
+	virtual std::shared_ptr<Module> get_module(std::string_view) override
+	{
+		return nullptr;
+	}
+};
+
+struct HidingImportResolver final : public ImportResolver
+{
+	virtual const void * resolve_import(std::string_view, std::string_view symbol_name,
+	                                    const void * default_address) override
+	{
+		return symbol_name == "strlen" ? nullptr : default_address;
+	}
+};
+
+BOOST_FIXTURE_TEST_CASE(load_failures, ModuleTest)
+{
+	const LoadResult loaded = load::try_load_module(_file);
+	BOOST_REQUIRE(loaded);
+	BOOST_CHECK_EQUAL(loaded->get_proc<int()>("sample_proc")(), 123);
+
+	const LoadResult unknown = load::try_load_module(StringBuffer("not a module"));
+	BOOST_REQUIRE(!unknown);
+	BOOST_CHECK(unknown.error().error == LoadError::UnknownFormat);
+	BOOST_CHECK_THROW(unknown.value(), std::logic_error);
+
+	NullModuleProvider null_provider;
+	const LoadResult missing_module = load::try_load_module(_file, null_provider);
+	BOOST_REQUIRE(!missing_module);
+	BOOST_CHECK(missing_module.error().error == LoadError::MissingModule);
+	BOOST_CHECK(!missing_module.error().module_name.empty());
+	BOOST_CHECK_EQUAL(missing_module.error().message, "Image has unresolved imports");
+	BOOST_CHECK(missing_module.error().phase == LoadPhase::ResolveImports);
+	BOOST_CHECK_THROW(load::load_module(_file, null_provider), std::runtime_error);
+
+	HidingImportResolver hiding_resolver;
+	LoadOptions load_options;
+	load_options.import_resolver = &hiding_resolver;
+	const LoadResult missing_symbol = load::try_load_module(_file, load_options);
+	BOOST_REQUIRE(!missing_symbol);
+	BOOST_CHECK(missing_symbol.error().error == LoadError::MissingSymbol);
+	BOOST_CHECK_EQUAL(missing_symbol.error().symbol_name, "strlen");
+	BOOST_CHECK_EQUAL(load_error_name(missing_symbol.error().error), "missing_symbol");
+
+	load_options.call_instrumentation = CallInstrumentation::CountCalls;
+	const LoadResult unsupported_options = load::try_load_module(_file, load_options);
+	BOOST_CHECK(unsupported_options.error().error == LoadError::UnsupportedOptions);
+	BOOST_CHECK_EQUAL(unsupported_options.error().message, "Unsupported call instrumentation");
+	BOOST_CHECK(!unsupported_options.error().phase);
+}
+
+BOOST_FIXTURE_TEST_CASE(get_proc, ModuleTest)
+{
+	auto module = load::load_module(_file);
+	const auto sample_proc = module->get_proc<int()>("sample_proc");
+	BOOST_REQUIRE_NE(sample_proc, nullptr);
+	BOOST_CHECK_EQUAL(sample_proc(), 123);
+	BOOST_CHECK_EQUAL(module->get_proc<int()>("missing_proc"), nullptr);
+	BOOST_CHECK_EQUAL(module->get_proc<int()>("strlen"), nullptr);
+}
+
+BOOST_FIXTURE_TEST_CASE(get_data, ModuleTest)
+{
+	auto module = load::load_module(_file);
+	const int * sample_data = module->get_data<int>("sample_data");
+	BOOST_REQUIRE_NE(sample_data, nullptr);
+	BOOST_CHECK_EQUAL(*sample_data, 123);
+}
+
+BOOST_FIXTURE_TEST_CASE(initializers, ModuleTest)
+{
+	auto module = load::load_module(_file);
+	const int * sample_init_data = module->get_data<int>("sample_init_data");
+	BOOST_REQUIRE_NE(sample_init_data, nullptr);
+	BOOST_CHECK_EQUAL(*sample_init_data, 456);
+}
+
+BOOST_FIXTURE_TEST_CASE(relocations, ModuleTest)
+{
+	for (const char * file_name : { "libsample_elf_module.so", "libsample_elf_module_relr.so" }) {
+		if (!std::filesystem::exists(file_name)) continue;
+
+		auto module = load::load_module(MappedFile(file_name));
+		const auto sample_string = module->get_proc<const char * (int)>("sample_string");
+		BOOST_CHECK_EQUAL(sample_string(0), "libload");
+		BOOST_CHECK_EQUAL(sample_string(2), "module");
+
+		const auto sample_strlen = module->get_proc<std::size_t (const char *)>("sample_strlen");
+		BOOST_CHECK_EQUAL(sample_strlen("libload"), 7u);
+	}
+}
+
+BOOST_FIXTURE_TEST_CASE(exceptions, ModuleTest)
+{
+	auto module = load::load_module(_file);
+	const auto sample_throw = module->get_proc<void (int)>("sample_throw");
+	try {
+		sample_throw(7);
+		BOOST_ERROR("Exception did not propagate");
+	} catch (const std::runtime_error & error) {
+		BOOST_CHECK_EQUAL(error.what(), std::string("7"));
+	}
+}
+
+BOOST_FIXTURE_TEST_CASE(import_resolver, ModuleTest)
+{
+	ImportOverrides import_overrides;
+	import_overrides.add("strlen", reinterpret_cast<const void *>(&fake_strlen));
+	LoadOptions load_options;
+	load_options.import_resolver = &import_overrides;
+
+	auto module = load::load_module(_file, load_options);
+	const auto sample_strlen = module->get_proc<std::size_t (const char *)>("sample_strlen");
+	BOOST_CHECK_EQUAL(sample_strlen("libload"), fake_strlen_result);
+}
+
+BOOST_FIXTURE_TEST_CASE(module_registry, ModuleTest)
+{
+	auto module = load::load_module(_file);
+	const auto sample_proc = module->get_proc<int()>("sample_proc");
+
+	ModuleRange range;
+	BOOST_REQUIRE(find_module_range(reinterpret_cast<std::uintptr_t>(sample_proc), range));
+	BOOST_CHECK_EQUAL(range.module, module.get());
+
+	const auto base_address = range.base_address;
+	module.reset();
+	BOOST_CHECK(!find_module_range(base_address, range));
+}
+
+BOOST_FIXTURE_TEST_CASE(relro_is_read_only, ModuleTest)
+{
+	auto module = load::load_module(_file);
+	const auto sample_strings = module->get_data<const char * const>("sample_strings");
+	BOOST_REQUIRE_NE(sample_strings, nullptr);
+	BOOST_CHECK_EQUAL(sample_strings[1], std::string("elf"));
+	BOOST_CHECK_EQUAL(mapping_permissions(sample_strings).substr(0, 3), "r--");
+
+	const int * sample_data = module->get_data<int>("sample_data");
+	BOOST_CHECK_EQUAL(mapping_permissions(sample_data).substr(0, 3), "rw-");
+}
+
+BOOST_FIXTURE_TEST_CASE(memory_stats, ModuleTest)
+{
+	auto module = load::load_module(_file);
+	const ModuleMemoryStats mem_stats = module->memory_stats();
+	BOOST_CHECK_GT(mem_stats.reserved_size, 0);
+	BOOST_CHECK_GT(mem_stats.metadata_size, 0);
+	BOOST_CHECK_LE(mem_stats.committed_size, mem_stats.reserved_size);
+	BOOST_CHECK_LE(mem_stats.resident_size, mem_stats.committed_size);
+	BOOST_CHECK(!mem_stats.sections.empty());
+
+	// Access is read back from the mappings, so it matches what the loader set
+	for (const SectionMemoryStats & seg_stats : mem_stats.sections) {
+		const std::string permissions = mapping_permissions(reinterpret_cast<const void *>(seg_stats.address));
+		BOOST_REQUIRE_GE(permissions.size(), 3);
+		BOOST_CHECK_EQUAL((seg_stats.access & MemoryManager::ReadAccess) != 0, permissions[0] == 'r');
+		BOOST_CHECK_EQUAL((seg_stats.access & MemoryManager::ExecuteAccess) != 0, permissions[2] == 'x');
+	}
+}
+
+BOOST_FIXTURE_TEST_CASE(load_observer, ModuleTest)
+{
+	std::ostringstream trace_stream;
+	{
+		ChromeTraceObserver trace_observer { trace_stream };
+		LoadOptions load_options;
+		load_options.observer = &trace_observer;
+		BOOST_REQUIRE_NE(load::load_module(_file, load_options), nullptr);
+	}
+
+	const std::string trace = trace_stream.str();
+	BOOST_CHECK_NE(trace.find("\"map_sections\""), std::string::npos);
+	BOOST_CHECK_NE(trace.find("\"initialize\""), std::string::npos);
+	BOOST_CHECK_NE(trace.find("libc.so.6"), std::string::npos);
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#define BOOST_TEST_MODULE HotPatch
+#include <boost/test/unit_test.hpp>
+
+#include "../src/arch/x64/instruction_relocation.hpp"
+#include "../src/platform/code_patching.hpp"
+
+#include <load/module.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+using namespace load;
+
+BOOST_AUTO_TEST_CASE(x64_instruction_decoding)
+{
+	const std::pair<std::string_view, std::size_t> lengths[] = {
+		{ "\xf3\x0f\x1e\xfa", 4 },                     // endbr64
+		{ "\x55", 1 },                                 // push rbp
+		{ "\x48\x89\xe5", 3 },                         // mov rbp, rsp
+		{ "\x48\x83\xec\x20", 4 },                     // sub rsp, 0x20
+		{ "\x48\x81\xec\x00\x01\x00\x00", 7 },         // sub rsp, 0x100
+		{ "\x66\xc7\x44\x24\x08\x01\x00", 7 },         // mov word [rsp + 8], 1
+		{ "\x48\xb8\x01\x02\x03\x04\x05\x06\x07\x08", 10 }, // mov rax, imm64
+		{ "\x4c\x8b\x44\x24\x38", 5 },                 // mov r8, [rsp + 0x38]
+		{ "\x0f\xb6\x04\x08", 4 },                     // movzx eax, byte [rax + rcx]
+	};
+	for (const auto & [code, length] : lengths)
+		BOOST_TEST(detail::decode_x64_instruction(code.data()).length == length);
+
+	const auto rip_cmp = detail::decode_x64_instruction("\x83\x3d\x10\x00\x00\x00\x05"); // cmp [rip + 0x10], 5
+	BOOST_TEST(rip_cmp.length == 7);
+	BOOST_TEST(rip_cmp.rel_offset == 2);
+	BOOST_TEST(rip_cmp.imm_size == 1);
+
+	BOOST_TEST(detail::decode_x64_instruction("\xe8\x00\x00\x00\x00").kind == detail::X64Instruction::Call);
+	BOOST_TEST(detail::decode_x64_instruction("\x74\x10").kind == detail::X64Instruction::ConditionalJump);
+	BOOST_TEST(detail::decode_x64_instruction("\xc3").kind == detail::X64Instruction::Return);
+	BOOST_CHECK_THROW(detail::decode_x64_instruction("\xc5\xf8\x77"), std::runtime_error);
+}
+
+#if defined(__GNUC__)
+
+__attribute__((noinline, aligned(16))) std::uint64_t hook_target(std::uint64_t value)
+{
+	std::uint64_t result = 1;
+	for (std::uint64_t i = 0; i < value; ++i)
+		result = result * 3 + i;
+	return result;
+}
+
+std::uint64_t (*hook_target_original)(std::uint64_t) = nullptr;
+
+std::uint64_t hook_replacement(std::uint64_t value)
+{
+	return hook_target_original(value) + 1000;
+}
+
+BOOST_AUTO_TEST_CASE(hot_patch)
+{
+	std::uint64_t (* volatile target_fn)(std::uint64_t) = &hook_target;
+	const std::uint64_t expected = target_fn(5);
+	const std::string entry_bytes(reinterpret_cast<const char *>(&hook_target), 16);
+	const int page_access = detail::code_page_access(reinterpret_cast<const void *>(&hook_target));
+
+	FunctionHook hook = hook_function(reinterpret_cast<void *>(&hook_target),
+	                                  reinterpret_cast<const void *>(&hook_replacement));
+	BOOST_REQUIRE(hook);
+	hook_target_original = hook.original<std::uint64_t (std::uint64_t)>();
+	BOOST_TEST(target_fn(5) == expected + 1000);
+	BOOST_TEST(hook_target_original(5) == expected);
+	BOOST_TEST(detail::code_page_access(reinterpret_cast<const void *>(&hook_target)) == page_access);
+
+	FunctionHook moved_hook = std::move(hook);
+	BOOST_TEST(!hook);
+	moved_hook.unhook();
+	BOOST_TEST(!moved_hook);
+	BOOST_TEST(target_fn(5) == expected);
+	BOOST_TEST(std::string(reinterpret_cast<const char *>(&hook_target), 16) == entry_bytes);
+
+	{
+		const FunctionHook scoped_hook = hook_function(reinterpret_cast<void *>(&hook_target),
+		                                               reinterpret_cast<const void *>(&hook_replacement));
+		hook_target_original = scoped_hook.original<std::uint64_t (std::uint64_t)>();
+		BOOST_TEST(target_fn(3) == hook_target_original(3) + 1000);
+	}
+	BOOST_TEST(target_fn(5) == expected);
+
+	const auto unaligned_entry = reinterpret_cast<char *>(&hook_target) + 5;
+	BOOST_CHECK_THROW(hook_function(unaligned_entry, reinterpret_cast<const void *>(&hook_replacement)),
+	                  std::invalid_argument);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,28 @@
+#define BOOST_TEST_MODULE ImportOverrides
+#include <boost/test/unit_test.hpp>
+
+#include <load/module.hpp>
+
+using namespace load;
+
+BOOST_AUTO_TEST_CASE(import_overrides)
+{
+	int default_symbol = 0, arena_malloc = 0, arena_free = 0, heap_alloc = 0;
+
+	ImportOverrides import_overrides;
+	import_overrides.add("malloc", &arena_malloc);
+	import_overrides.add("free", &arena_free);
+	import_overrides.add("KERNEL32.dll", "HeapAlloc", &heap_alloc);
+	ImportResolver & resolver = import_overrides;
+
+	BOOST_TEST(resolver.resolve_import("msvcrt.dll", "malloc", &default_symbol) == &arena_malloc);
+	BOOST_TEST(resolver.resolve_import("ucrtbase.dll", "free", nullptr) == &arena_free);
+	BOOST_TEST(resolver.resolve_import("kernel32.DLL", "HeapAlloc", &default_symbol) == &heap_alloc);
+	BOOST_TEST(resolver.resolve_import("other.dll", "HeapAlloc", &default_symbol) == &default_symbol);
+	BOOST_TEST(resolver.resolve_import("msvcrt.dll", "realloc", &default_symbol) == &default_symbol);
+	BOOST_TEST(resolver.resolve_import("msvcrt.dll", "calloc", nullptr) == nullptr);
+
+	import_overrides.add("msvcrt.dll", "malloc", &default_symbol);
+	BOOST_TEST(resolver.resolve_import("MSVCRT.dll", "malloc", nullptr) == &default_symbol);
+	BOOST_TEST(resolver.resolve_import("ucrtbase.dll", "malloc", nullptr) == &arena_malloc);
+}
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <load/module.hpp>
 
 #include <memory>
+#include <sstream>
+#include <string_view>
 
 using namespace load;
 
@@ -41,6 +43,54 @@ BOOST_FIXTURE_TEST_CASE(get_data, ModuleTest)
 	BOOST_CHECK_EQUAL(*sample_data, 123);
 }
 
+BOOST_FIXTURE_TEST_CASE(memory_stats, ModuleTest)
+{
+	auto module = load::load_module(_file);
+	const ModuleMemoryStats mem_stats = module->memory_stats();
+	BOOST_CHECK_GT(mem_stats.reserved_size, 0);
+	BOOST_CHECK_GT(mem_stats.metadata_size, 0);
+	BOOST_CHECK_LE(mem_stats.committed_size, mem_stats.reserved_size);
+	BOOST_CHECK_LE(mem_stats.resident_size, mem_stats.committed_size);
+	BOOST_CHECK(!mem_stats.sections.empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(load_observer, ModuleTest)
+{
+	std::ostringstream trace_stream;
+	{
+		ChromeTraceObserver trace_observer { trace_stream };
+		LoadOptions load_options;
+		load_options.observer = &trace_observer;
+		BOOST_REQUIRE_NE(load::load_module(_file, load_options), nullptr);
+	}
+
+	const std::string trace = trace_stream.str();
+	BOOST_CHECK_NE(trace.find("\"map_sections\""), std::string::npos);
+	BOOST_CHECK_NE(trace.find("\"initialize\""), std::string::npos);
+	BOOST_CHECK_EQUAL(trace.substr(trace.size() - 3), "]}\n");
+}
+
+struct NullModuleProvider final : public ModuleProvider
+{
+	virtual std::shared_ptr<Module> get_module(std::string_view) override
+	{
+		return nullptr;
+	}
+};
+
+BOOST_FIXTURE_TEST_CASE(load_failures, ModuleTest)
+{
+	const LoadResult loaded = load::try_load_module(_file);
+	BOOST_REQUIRE(loaded);
+	BOOST_CHECK_EQUAL(loaded->get_proc<int()>("sample_proc")(), 123);
+
+	NullModuleProvider null_provider;
+	const LoadResult missing_module = load::try_load_module(_file, null_provider);
+	BOOST_REQUIRE(!missing_module);
+	BOOST_CHECK(missing_module.error().error == LoadError::MissingModule);
+	BOOST_CHECK(!missing_module.error().module_name.empty());
+}
+
 #if defined(_MSC_VER) || defined(__DMC__)
 
 BOOST_FIXTURE_TEST_CASE(module_seh_handler, ModuleTest)
@@ -0,0 +1,54 @@
+#define BOOST_TEST_MODULE MemoryStats
+#include <boost/test/unit_test.hpp>
+
+#include <load/memory.hpp>
+#include <load/module.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+using namespace load;
+
+namespace {
+
+#ifdef _WIN32
+constexpr const char * system_module_name = "kernel32.dll";
+#else
+constexpr const char * system_module_name = "libc.so.6";
+#endif
+
+}
+
+BOOST_AUTO_TEST_CASE(system_module_memory_stats)
+{
+	const auto module = system_module_provider.get_module(system_module_name);
+	BOOST_REQUIRE_NE(module, nullptr);
+
+	const ModuleMemoryStats mem_stats = module->memory_stats();
+	BOOST_CHECK_GT(mem_stats.reserved_size, 0);
+	BOOST_CHECK_GT(mem_stats.committed_size, 0);
+	BOOST_CHECK_GT(mem_stats.resident_size, 0);
+	BOOST_CHECK_GT(mem_stats.metadata_size, 0);
+	BOOST_CHECK_LE(mem_stats.resident_size, mem_stats.committed_size);
+	BOOST_REQUIRE(!mem_stats.sections.empty());
+
+	std::size_t committed_size = 0, resident_size = 0;
+	for (const SectionMemoryStats & sect_stats : mem_stats.sections) {
+		BOOST_CHECK_NE(sect_stats.address, 0);
+		BOOST_CHECK_LE(sect_stats.committed_size, sect_stats.reserved_size);
+		BOOST_CHECK_LE(sect_stats.resident_size, sect_stats.committed_size);
+		committed_size += sect_stats.committed_size;
+		resident_size += sect_stats.resident_size;
+	}
+	BOOST_CHECK_EQUAL(committed_size, mem_stats.committed_size);
+	BOOST_CHECK_EQUAL(resident_size, mem_stats.resident_size);
+
+	// This process runs the module's code, so some of it is resident
+	const auto sect_it = std::find_if(mem_stats.sections.begin(), mem_stats.sections.end(),
+		[] (const SectionMemoryStats & sect_stats) {
+			return (sect_stats.access & MemoryManager::ExecuteAccess) != 0;
+		});
+	BOOST_REQUIRE(sect_it != mem_stats.sections.end());
+	BOOST_CHECK_GT(sect_it->resident_size, 0);
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#define BOOST_TEST_MODULE ModuleFormat
+#include <boost/test/unit_test.hpp>
+
+#include <load/memory.hpp>
+#include <load/module.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+using namespace load;
+
+namespace {
+
+struct StringBuffer final : public MemoryBuffer
+{
+	explicit StringBuffer(std::string data)
+		: data { std::move(data) }
+	{}
+
+	virtual std::size_t read(std::size_t offset, std::size_t size, void * into_buffer) const override
+	{
+		++read_count;
+		return data.copy(static_cast<char *>(into_buffer), size, std::min(offset, data.size()));
+	}
+
+	std::string         data;
+	mutable std::size_t read_count = 0;
+};
+
+struct TestModuleFormat final : public ModuleFormat
+{
+	virtual std::string_view name() const override
+	{
+		return "test";
+	}
+
+	virtual std::string_view magic() const override
+	{
+		return "LLTEST";
+	}
+
+	virtual ModuleFormatError probe(const char *, std::size_t header_size) const override
+	{
+		return header_size < 8 ? ModuleFormatError::TruncatedHeaders : ModuleFormatError::None;
+	}
+
+	virtual std::shared_ptr<Module> load(const MemoryBuffer &, const LoadOptions &,
+	                                     ModuleProvider &, Process &) const override
+	{
+		++load_count;
+		if (throws) throw std::runtime_error("Malformed image headers");
+		return nullptr;
+	}
+
+	mutable std::size_t load_count = 0;
+	bool                throws     = false;
+};
+}
+
+BOOST_AUTO_TEST_CASE(module_formats)
+{
+	TestModuleFormat test_format;
+	const StringBuffer test_module { std::string("LLTEST\0\0", 8) + std::string(0x2000, 'x') };
+	const StringBuffer truncated_module { "LLTEST" };
+	const StringBuffer unknown_module { std::string(0x100, '\0') };
+
+	BOOST_TEST(!detect_module_format(test_module));
+	BOOST_CHECK(detect_module_format(unknown_module).error == ModuleFormatError::UnknownFormat);
+
+	register_module_format(test_format);
+	BOOST_CHECK_THROW(register_module_format(test_format), std::invalid_argument);
+
+	test_module.read_count = 0;
+	const ModuleFormatMatch match = detect_module_format(test_module);
+	BOOST_TEST(test_module.read_count == 1);
+	BOOST_TEST(match.format == &test_format);
+	BOOST_CHECK(match.error == ModuleFormatError::None);
+	BOOST_CHECK(detect_module_format(truncated_module).error == ModuleFormatError::TruncatedHeaders);
+	BOOST_TEST(module_format_error_name(ModuleFormatError::TruncatedHeaders) == "truncated_headers");
+
+	BOOST_TEST(load_module(test_module) == nullptr);
+	BOOST_TEST(test_format.load_count == 1);
+
+	BOOST_CHECK(try_load_module(test_module).error().error == LoadError::UnsupportedImage);
+	test_format.throws = true;
+	const LoadResult malformed = try_load_module(test_module);
+	BOOST_CHECK(malformed.error().error == LoadError::MalformedImage);
+	BOOST_CHECK_EQUAL(malformed.error().message, "Malformed image headers");
+	BOOST_CHECK(try_load_module(truncated_module).error().error == LoadError::TruncatedHeaders);
+	BOOST_TEST(test_format.load_count == 3);
+	test_format.throws = false;
+
+	unregister_module_format(test_format);
+	BOOST_TEST(!detect_module_format(test_module));
+	BOOST_TEST(load_module(test_module) == nullptr);
+	BOOST_TEST(test_format.load_count == 3);
+}
\ No newline at end of file
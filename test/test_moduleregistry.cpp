@@ -0,0 +1,70 @@
+#define BOOST_TEST_MODULE ModuleRegistry
+#include <boost/test/unit_test.hpp>
+
+#include "../src/module_registry.hpp"
+
+#include <load/module.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace load;
+
+BOOST_AUTO_TEST_CASE(module_registry)
+{
+	const RuntimeFunction runtime_functions[] = {
+		{ 0x1000, 0x1040, 0x3000 }, { 0x1040, 0x1100, 0x3010 }, { 0x1200, 0x1280, 0x3020 }
+	};
+
+	std::vector<std::pair<ModuleEvent, std::uintptr_t>> events;
+	const ModuleEventListener listener = [] (ModuleEvent event, const ModuleRange & range, void * data) {
+		static_cast<decltype(events) *>(data)->emplace_back(event, range.base_address);
+	};
+
+	detail::ModuleRegistry registry;
+	registry.add_listener(listener, &events);
+	registry.add({ 0x400000, 0x4000, nullptr, runtime_functions, 3 });
+	registry.add({ 0x100000, 0x2000, nullptr, nullptr, 0 });
+	BOOST_CHECK_THROW(registry.add({ 0x401000, 0x1000, nullptr, nullptr, 0 }), std::invalid_argument);
+	BOOST_CHECK_THROW(registry.add({ 0x3ff000, 0x2000, nullptr, nullptr, 0 }), std::invalid_argument);
+
+	ModuleRange range;
+	BOOST_TEST(registry.find(0x401fff, range));
+	BOOST_TEST(range.base_address == 0x400000);
+	BOOST_TEST(registry.find(0x100000, range));
+	BOOST_TEST(range.base_address == 0x100000);
+	BOOST_TEST(!registry.find(0x102000, range));
+	BOOST_TEST(!registry.find(0x404000, range));
+
+	BOOST_TEST(registry.find_runtime_function(0x401040) == &runtime_functions[1]);
+	BOOST_TEST(registry.find_runtime_function(0x40127f) == &runtime_functions[2]);
+	BOOST_TEST(registry.find_runtime_function(0x401100) == nullptr);
+	BOOST_TEST(registry.find_runtime_function(0x101000) == nullptr);
+
+	std::vector<std::uintptr_t> bases;
+	const int stopped = registry.iterate([] (const ModuleRange & range, void * data) {
+		static_cast<std::vector<std::uintptr_t> *>(data)->push_back(range.base_address);
+		return 7;
+	}, &bases);
+	BOOST_TEST(stopped == 7);
+	BOOST_TEST(bases == std::vector<std::uintptr_t>{ 0x100000 }, boost::test_tools::per_element());
+
+	const Module * const moved_module = reinterpret_cast<const Module *>(&bases);
+	registry.set_module(0x100000, moved_module);
+	BOOST_TEST(registry.find(0x100000, range));
+	BOOST_TEST(range.module == moved_module);
+
+	registry.remove(0x400000);
+	BOOST_TEST(!registry.find(0x401000, range));
+	BOOST_CHECK_NO_THROW(registry.remove(0x400000));
+
+	registry.remove_listener(listener, &events);
+	registry.remove(0x100000);
+
+	const std::vector<std::pair<ModuleEvent, std::uintptr_t>> expected = {
+		{ ModuleEvent::Loaded, 0x400000 }, { ModuleEvent::Loaded, 0x100000 }, { ModuleEvent::Unloaded, 0x400000 }
+	};
+	BOOST_TEST((events == expected));
+}
\ No newline at end of file
@@ -0,0 +1,170 @@
+#define BOOST_TEST_MODULE PEGenerator
+#include <boost/test/unit_test.hpp>
+
+#include "../tools/pegen/pe_generator.hpp"
+
+#include <load/memory.hpp>
+#include <load/module.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+using namespace load;
+
+namespace {
+
+template <typename T>
+T read_le(const std::vector<char> & image, std::size_t offset)
+{
+	T value = 0;
+	for (std::size_t i = 0; i < sizeof(T); ++i)
+		value |= T(static_cast<unsigned char>(image[offset + i])) << (i * 8);
+	return value;
+}
+
+std::size_t nt_headers_offset(const std::vector<char> & image)
+{
+	return read_le<std::uint32_t>(image, 0x3c);
+}
+
+std::size_t data_directory_offset(const std::vector<char> & image, unsigned int bits)
+{
+	return nt_headers_offset(image) + 4 + 20 + (bits == 64 ? 112 : 96);
+}
+
+std::size_t rva_to_offset(const std::vector<char> & image, std::uint32_t rva)
+{
+	const std::size_t file_hdr = nt_headers_offset(image) + 4;
+	const std::size_t section_count = read_le<std::uint16_t>(image, file_hdr + 2);
+	const std::size_t opt_hdr_size = read_le<std::uint16_t>(image, file_hdr + 16);
+	for (std::size_t i = 0; i < section_count; ++i) {
+		const std::size_t sect_hdr = file_hdr + 20 + opt_hdr_size + i * 40;
+		const auto virtual_address = read_le<std::uint32_t>(image, sect_hdr + 12);
+		const auto raw_size = read_le<std::uint32_t>(image, sect_hdr + 16);
+		if (rva >= virtual_address && rva < virtual_address + raw_size)
+			return read_le<std::uint32_t>(image, sect_hdr + 20) + (rva - virtual_address);
+	}
+
+	throw std::out_of_range("RVA not mapped by any section");
+}
+
+std::size_t count_relocations(const std::vector<char> & image, unsigned int bits)
+{
+	const std::size_t reloc_dir = data_directory_offset(image, bits) + 5 * 8;
+	const auto reloc_rva = read_le<std::uint32_t>(image, reloc_dir);
+	const auto reloc_size = read_le<std::uint32_t>(image, reloc_dir + 4);
+
+	std::size_t reloc_count = 0;
+	const std::size_t reloc_offs = rva_to_offset(image, reloc_rva);
+	for (std::size_t block = 0; block < reloc_size;) {
+		const auto block_size = read_le<std::uint32_t>(image, reloc_offs + block + 4);
+		for (std::size_t entry = 8; entry < block_size; entry += 2) {
+			if (read_le<std::uint16_t>(image, reloc_offs + block + entry) >> 12)
+				++reloc_count;
+		}
+		block += block_size;
+	}
+
+	return reloc_count;
+}
+
+class StubModule final : public Module
+{
+public:
+	virtual ModuleMemoryStats memory_stats() const override { return {}; }
+	virtual ModuleAbi abi() const override { return native_module_abi; }
+	virtual void * tls_data() const override { return nullptr; }
+
+protected:
+	virtual DataPtr get_data_address(std::string_view) const override { return &_value; }
+	virtual ProcPtr get_proc_address(std::string_view) const override { return nullptr; }
+
+private:
+	int _value = 0;
+};
+
+class StubModuleProvider final : public ModuleProvider
+{
+public:
+	virtual std::shared_ptr<Module> get_module(std::string_view) override
+	{
+		return std::make_shared<StubModule>();
+	}
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(image_headers)
+{
+	for (const unsigned int bits : { 32u, 64u }) {
+		pegen::ImageSpec spec;
+		spec.bits = bits;
+		spec.section_count = 3;
+
+		const std::vector<char> image = pegen::generate_pe_image(spec);
+		BOOST_REQUIRE_GT(image.size(), 0x400);
+		BOOST_CHECK_EQUAL(std::memcmp(image.data(), "MZ", 2), 0);
+
+		const std::size_t nt_hdrs = nt_headers_offset(image);
+		BOOST_CHECK_EQUAL(std::memcmp(image.data() + nt_hdrs, "PE\0\0", 4), 0);
+		BOOST_CHECK_EQUAL(read_le<std::uint16_t>(image, nt_hdrs + 4), bits == 64 ? 0x8664 : 0x014c);
+		BOOST_CHECK_EQUAL(read_le<std::uint16_t>(image, nt_hdrs + 24), bits == 64 ? 0x20b : 0x10b);
+		BOOST_CHECK_EQUAL(read_le<std::uint16_t>(image, nt_hdrs + 6), 3 + spec.section_count);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(relocation_density)
+{
+	pegen::ImageSpec spec;
+	spec.section_count = 2;
+	spec.section_size = 0x10000;
+	spec.relocations_per_page = 64;
+	spec.tls_callback_count = 2;
+
+	pegen::ImageSummary summary;
+	const std::vector<char> image = pegen::generate_pe_image(spec, &summary);
+	BOOST_CHECK_EQUAL(summary.relocation_count, 2 * 16 * 64 + 4 + 2);
+	BOOST_CHECK_EQUAL(count_relocations(image, spec.bits), summary.relocation_count);
+}
+
+BOOST_AUTO_TEST_CASE(export_table)
+{
+	pegen::ImageSpec spec;
+	spec.export_count = 10000;
+	spec.forwarder_count = 16;
+
+	const std::vector<char> image = pegen::generate_pe_image(spec);
+	const std::size_t export_dir = data_directory_offset(image, spec.bits);
+	const std::size_t export_offs = rva_to_offset(image, read_le<std::uint32_t>(image, export_dir));
+	BOOST_CHECK_EQUAL(read_le<std::uint32_t>(image, export_offs + 20), 10016);
+
+	const std::size_t names_offs = rva_to_offset(image, read_le<std::uint32_t>(image, export_offs + 32));
+	const auto last_name = rva_to_offset(image, read_le<std::uint32_t>(image, names_offs + 10015 * 4));
+	BOOST_CHECK_EQUAL(image.data() + last_name, pegen::forwarder_symbol_name(15));
+}
+
+#ifdef LIBLOAD_ENABLE_FORMAT_PE64
+
+BOOST_AUTO_TEST_CASE(load_generated_module)
+{
+	pegen::ImageSpec spec;
+	spec.section_count = 4;
+	spec.relocations_per_page = 16;
+	spec.import_module_count = 4;
+	spec.imports_per_module = 32;
+	spec.export_count = 100;
+
+	const auto image_path = std::filesystem::temp_directory_path() / "pegen_load_test.dll";
+	pegen::write_pe_image(spec, image_path);
+
+	StubModuleProvider module_provider;
+	const auto module = load::load_module(MappedFile(image_path), module_provider);
+	BOOST_REQUIRE_NE(module, nullptr);
+	BOOST_CHECK_NE(module->get_proc<void()>(pegen::export_symbol_name(42)), nullptr);
+	std::filesystem::remove(image_path);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,55 @@
+#define BOOST_TEST_MODULE PerfMap
+#include <boost/test/unit_test.hpp>
+
+#include "../src/perf_map.hpp"
+
+#include <load/module.hpp>
+#include <load/process.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace load;
+
+BOOST_AUTO_TEST_CASE(perf_map)
+{
+	const auto map_path = std::filesystem::temp_directory_path() / "libload_perf_map_test.map";
+	const auto read_map = [&] {
+		std::ifstream map_stream { map_path };
+		return std::string(std::istreambuf_iterator<char>(map_stream), {});
+	};
+
+	int first_owner, second_owner;
+	std::filesystem::remove(map_path);
+	{
+		detail::PerfMap perf_map { map_path.string() };
+		perf_map.add(&first_owner, { { 0x1000, 0x40, "first!a" }, { 0x1040, 0x20, "first!b" } });
+		perf_map.add(&second_owner, { { 0xabc0, 0x10, "second" } });
+		BOOST_TEST(read_map() == "1000 40 first!a\n1040 20 first!b\nabc0 10 second\n");
+
+		perf_map.remove(&first_owner, 0x1000);
+		perf_map.remove(&second_owner);
+		BOOST_TEST(read_map() == "1040 20 first!b\n");
+
+		perf_map.remove(&second_owner);
+		BOOST_TEST(read_map() == "1040 20 first!b\n");
+
+		perf_map.transfer(&first_owner, &second_owner);
+		perf_map.remove(&first_owner);
+		BOOST_TEST(read_map() == "1040 20 first!b\n");
+		perf_map.remove(&second_owner);
+		BOOST_TEST(read_map() == "");
+	}
+	std::filesystem::remove(map_path);
+
+	const bool was_enabled = is_perf_map_enabled();
+	enable_perf_map();
+	BOOST_REQUIRE(detail::perf_map() != nullptr);
+	BOOST_TEST(detail::perf_map()->path().find(std::to_string(current_process().process_id())) != std::string::npos);
+	if (!was_enabled) {
+		disable_perf_map();
+		BOOST_TEST(detail::perf_map() == nullptr);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#define BOOST_TEST_MODULE RemoteCallBatch
+#include <boost/test/unit_test.hpp>
+
+#include "../src/remote_call_batch.hpp"
+
+#include <load/codegen.hpp>
+#include <load/process.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#if defined(_WIN32)
+#	define TEST_MS_ABI
+#else
+#	define TEST_MS_ABI __attribute__((ms_abi))
+#endif
+
+using namespace load;
+
+struct CodeGeneratorTest
+{
+	CodeGeneratorTest()
+		: _code_generator { &current_process().code_generator() }
+	{}
+
+	const CodeGenerator * _code_generator;
+};
+
+std::uint64_t TEST_MS_ABI weighted_sum(std::uint64_t a, std::uint64_t b, std::uint64_t c,
+                                       std::uint64_t d, std::uint64_t e, std::uint64_t f)
+{
+	return a + 2 * b + 3 * c + 4 * d + 5 * e + 6 * f;
+}
+
+std::uint64_t TEST_MS_ABI scaled_value(std::uint64_t value, std::uint64_t scale)
+{
+	return value * scale;
+}
+
+BOOST_FIXTURE_TEST_CASE(remote_call_batch, CodeGeneratorTest)
+{
+	if (_code_generator->get_calling_convention() == nullptr) return;
+
+	detail::RemoteCallBatch call_batch;
+	const auto weighted_sum_addr = reinterpret_cast<std::uintptr_t>(&weighted_sum);
+	const auto scaled_value_addr = reinterpret_cast<std::uintptr_t>(&scaled_value);
+	for (std::uint64_t i = 0; i < 3; ++i) {
+		call_batch.add_call(weighted_sum_addr, { i, 0, 0, 0, 0, 1 });
+		call_batch.add_call(scaled_value_addr, { i, 7 });
+	}
+	BOOST_TEST(call_batch.size() == 6u);
+
+	const std::vector<std::uint64_t> results = call_batch.run(current_process());
+	const std::vector<std::uint64_t> expected = { 6, 0, 7, 7, 8, 14 };
+	BOOST_TEST(results == expected, boost::test_tools::per_element());
+
+	detail::RemoteCallBatch checked_batch;
+	checked_batch.add_checked_call(scaled_value_addr, { 1, 3 });
+	checked_batch.add_call(scaled_value_addr, { 2, 3 });
+	checked_batch.add_checked_call(scaled_value_addr, { 0, 3 });
+	checked_batch.add_call(scaled_value_addr, { 4, 3 });
+	const std::vector<std::uint64_t> checked_expected = { 3, 6, 0 };
+	BOOST_TEST(checked_batch.run(current_process()) == checked_expected, boost::test_tools::per_element());
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#define BOOST_TEST_MODULE SyscallModule
+#include <boost/test/unit_test.hpp>
+
+#include <load/module.hpp>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstddef>
+
+#define TEST_MS_ABI __attribute__((ms_abi))
+
+using namespace load;
+
+BOOST_AUTO_TEST_CASE(syscall_module)
+{
+	const auto syscall_module = syscall_module_provider.get_module("SYSCALL.dll");
+	BOOST_TEST_REQUIRE(syscall_module != nullptr);
+	BOOST_TEST(syscall_module_provider.get_module("kernel32.dll") == nullptr);
+	BOOST_TEST(syscall_module->get_proc<void ()>("no_such_syscall") == nullptr);
+
+	using getpid_fn = long TEST_MS_ABI ();
+	BOOST_TEST(syscall_module->get_proc<getpid_fn>("getpid")() == getpid());
+
+	using mmap_fn = void * TEST_MS_ABI (void *, std::size_t, int, int, int, long);
+	using munmap_fn = int TEST_MS_ABI (void *, std::size_t);
+	const auto sys_mmap = syscall_module->get_proc<mmap_fn>("mmap");
+	const auto sys_munmap = syscall_module->get_proc<munmap_fn>("munmap");
+	BOOST_TEST(syscall_module->get_proc<mmap_fn>("mmap") == sys_mmap);
+
+	const auto mem = static_cast<char *>(sys_mmap(nullptr, 0x1000, PROT_READ | PROT_WRITE,
+	                                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+	BOOST_TEST_REQUIRE(mem != MAP_FAILED);
+	mem[0x800] = 42;
+	BOOST_TEST(mem[0x800] == 42);
+	BOOST_TEST(sys_munmap(mem, 0x1000) == 0);
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#define BOOST_TEST_MODULE TlsRegistry
+#include <boost/test/unit_test.hpp>
+
+#include "../src/tls_entry_thunks.hpp"
+#include "../src/tls_registry.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace load;
+
+BOOST_AUTO_TEST_CASE(tls_slots)
+{
+	static std::atomic<int> attach_count = 0;
+	static std::atomic<int> detach_count = 0;
+
+	detail::TlsSlotInfo slot_info;
+	slot_info.init_data = { 'a', 'b', 'c' };
+	slot_info.zero_fill_size = 13;
+	slot_info.alignment = 64;
+	slot_info.thread_attach = [] { ++attach_count; };
+	slot_info.thread_detach = [] { ++detach_count; };
+	detail::TlsSlot tls_slot { std::move(slot_info) };
+
+	const auto check_block = [] (void * block) {
+		const auto block_ptr = static_cast<const char *>(block);
+		return reinterpret_cast<std::uintptr_t>(block) % 64 == 0
+		    && std::string(block_ptr, 16) == std::string("abc\0\0\0\0\0\0\0\0\0\0\0\0\0", 16);
+	};
+
+	void * const main_block = tls_slot.thread_block();
+	BOOST_TEST(check_block(main_block));
+	BOOST_TEST(tls_slot.thread_block() == main_block);
+	BOOST_TEST(attach_count == 0);
+	tls_slot.attach_thread();
+	tls_slot.attach_thread();
+	BOOST_TEST(attach_count == 1);
+
+	std::atomic<int> valid_blocks = 0;
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 8; ++i) {
+		threads.emplace_back([&] {
+			tls_slot.attach_thread();
+			void * const block = tls_slot.thread_block();
+			if (check_block(block) && block != main_block && tls_slot.thread_block() == block)
+				++valid_blocks;
+			static_cast<char *>(block)[0] = 'x';
+		});
+	}
+	threads.emplace_back([] {});
+	for (std::thread & thread : threads)
+		thread.join();
+
+	BOOST_TEST(valid_blocks == 8);
+	BOOST_TEST(attach_count == 9);
+	BOOST_TEST(detach_count == 8);
+	BOOST_TEST(check_block(main_block));
+
+	const unsigned int slot_index = tls_slot.index();
+	BOOST_TEST(detail::tls_registry().slab_count() != 0u);
+	tls_slot.reset();
+	BOOST_TEST(detach_count == 9);
+	BOOST_TEST(detail::tls_registry().slab_count() == 0u);
+	BOOST_TEST(tls_slot.thread_block() == nullptr);
+	BOOST_CHECK_THROW(detail::tls_registry().thread_block(slot_index), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(tls_slot_release_waits_for_detach)
+{
+	static std::atomic<bool> detach_started = false;
+	static std::atomic<bool> detach_finished = false;
+
+	detail::TlsSlotInfo slot_info;
+	slot_info.thread_detach = [] {
+		detach_started = true;
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		detach_finished = true;
+	};
+	detail::TlsSlot tls_slot { std::move(slot_info) };
+
+	std::thread thread { [&] { tls_slot.attach_thread(); } };
+	while (!detach_started)
+		std::this_thread::yield();
+	tls_slot.reset();
+	BOOST_TEST(detach_finished);
+	thread.join();
+}
+
+long entry_target(long a, long b, long c, long d, long e, long f, double x)
+{
+	return a + 2 * b + 3 * c + 4 * d + 5 * e + 6 * f + static_cast<long>(x * 10);
+}
+
+BOOST_AUTO_TEST_CASE(tls_entry_thunks)
+{
+	if (!detail::is_tls_entry_thunk_supported()) return;
+
+	static std::atomic<int> attach_count = 0;
+
+	detail::TlsSlotInfo slot_info;
+	slot_info.thread_attach = [] { ++attach_count; };
+	detail::TlsSlot tls_slot { std::move(slot_info) };
+
+	const auto entry_thunks = detail::make_tls_entry_thunks(tls_slot.index());
+	const auto target = reinterpret_cast<const void *>(&entry_target);
+	const auto thunk = reinterpret_cast<decltype(&entry_target)>(entry_thunks->entry_thunk(target));
+	BOOST_TEST(entry_thunks->entry_thunk(target) == reinterpret_cast<const void *>(thunk));
+
+	BOOST_TEST(thunk(1, 2, 3, 4, 5, 6, 0.5) == 96);
+	BOOST_TEST(attach_count == 1);
+	BOOST_TEST(thunk(6, 5, 4, 3, 2, 1, 1.5) == 71);
+	BOOST_TEST(attach_count == 1);
+
+	std::thread thread { [&] { thunk(0, 0, 0, 0, 0, 0, 0.0); } };
+	thread.join();
+	BOOST_TEST(attach_count == 2);
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "pe_generator.hpp"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+void print_usage(const char * program)
+{
+	std::cerr << "usage: " << program << " [options] <output>\n"
+	             "  --bits <32|64>              image format (default 64)\n"
+	             "  --image-base <address>      preferred image base\n"
+	             "  --sections <count>          number of synthetic data sections\n"
+	             "  --section-size <bytes>      size of each synthetic section\n"
+	             "  --relocs-per-page <count>   base relocations per synthetic page\n"
+	             "  --import-modules <count>    number of imported modules\n"
+	             "  --imports-per-module <n>    named imports per module\n"
+	             "  --exports <count>           number of exported procedures\n"
+	             "  --forwarders <count>        number of forwarded exports\n"
+	             "  --forwarder-module <name>   module targeted by forwarders\n"
+	             "  --tls-callbacks <count>     number of TLS callbacks\n"
+	             "  --name <name>               module name in the export directory\n";
+}
+
+}
+
+int main(int argc, char * argv[])
+{
+	load::pegen::ImageSpec spec;
+	std::string output_path;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string_view arg = argv[i];
+		if (arg == "-h" || arg == "--help") {
+			print_usage(argv[0]);
+			return EXIT_SUCCESS;
+		}
+
+		if (arg.substr(0, 2) != "--") {
+			output_path = arg;
+			continue;
+		}
+
+		if (i + 1 >= argc) {
+			print_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+
+		const std::string value = argv[++i];
+		const auto number = [&] { return std::stoull(value, nullptr, 0); };
+		if      (arg == "--bits")               spec.bits = number();
+		else if (arg == "--image-base")         spec.image_base = number();
+		else if (arg == "--sections")           spec.section_count = number();
+		else if (arg == "--section-size")       spec.section_size = number();
+		else if (arg == "--relocs-per-page")    spec.relocations_per_page = number();
+		else if (arg == "--import-modules")     spec.import_module_count = number();
+		else if (arg == "--imports-per-module") spec.imports_per_module = number();
+		else if (arg == "--exports")            spec.export_count = number();
+		else if (arg == "--forwarders")         spec.forwarder_count = number();
+		else if (arg == "--forwarder-module")   spec.forwarder_module = value;
+		else if (arg == "--tls-callbacks")      spec.tls_callback_count = number();
+		else if (arg == "--name")               spec.image_name = value;
+		else {
+			print_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (output_path.empty()) {
+		print_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	try {
+		const auto summary = load::pegen::write_pe_image(spec, output_path);
+		std::cout << output_path << ": "
+		          << summary.file_size << " bytes on disk, "
+		          << summary.image_size << " bytes mapped, "
+		          << summary.relocation_count << " relocations, "
+		          << summary.import_count << " imports, "
+		          << summary.export_count << " exports\n";
+	} catch (const std::exception & e) {
+		std::cerr << argv[0] << ": " << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,556 @@
+#include "pe_generator.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace load::pegen {
+
+namespace {
+
+constexpr std::size_t SECTION_ALIGNMENT = 0x1000;
+constexpr std::size_t FILE_ALIGNMENT    = 0x200;
+constexpr std::size_t PAGE_SIZE         = 0x1000;
+
+constexpr std::uint16_t MACHINE_I386  = 0x014c;
+constexpr std::uint16_t MACHINE_AMD64 = 0x8664;
+
+constexpr std::uint32_t SCN_CNT_CODE             = 0x00000020;
+constexpr std::uint32_t SCN_CNT_INITIALIZED_DATA = 0x00000040;
+constexpr std::uint32_t SCN_MEM_DISCARDABLE      = 0x02000000;
+constexpr std::uint32_t SCN_MEM_EXECUTE          = 0x20000000;
+constexpr std::uint32_t SCN_MEM_READ             = 0x40000000;
+constexpr std::uint32_t SCN_MEM_WRITE            = 0x80000000;
+
+enum {
+	DIRECTORY_ENTRY_EXPORT    = 0,
+	DIRECTORY_ENTRY_IMPORT    = 1,
+	DIRECTORY_ENTRY_BASERELOC = 5,
+	DIRECTORY_ENTRY_TLS       = 9,
+	DIRECTORY_ENTRY_IAT       = 12,
+};
+
+constexpr std::size_t TLS_DATA_SIZE = 16;
+
+constexpr std::size_t align_to(std::size_t value, std::size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+class ByteBuffer
+{
+public:
+	std::size_t size() const { return _data.size(); }
+	const std::vector<char> & data() const { return _data; }
+
+	void resize(std::size_t size) { _data.resize(size); }
+	void align(std::size_t alignment) { _data.resize(align_to(_data.size(), alignment)); }
+
+	template <typename T>
+	void put(std::size_t offset, T value)
+	{
+		if (_data.size() < offset + sizeof(T))
+			_data.resize(offset + sizeof(T));
+		for (std::size_t i = 0; i < sizeof(T); ++i)
+			_data[offset + i] = static_cast<char>((std::uint64_t(value) >> (i * CHAR_BIT)) & UCHAR_MAX);
+	}
+
+	void put_bytes(std::size_t offset, std::string_view bytes)
+	{
+		if (_data.size() < offset + bytes.size())
+			_data.resize(offset + bytes.size());
+		std::copy(bytes.begin(), bytes.end(), _data.begin() + offset);
+	}
+
+	std::size_t append_string(std::string_view str)
+	{
+		const std::size_t offset = _data.size();
+		put_bytes(offset, str);
+		_data.push_back('\0');
+		return offset;
+	}
+
+private:
+	std::vector<char> _data;
+};
+
+struct Section
+{
+	std::string   name;
+	std::uint32_t characteristics;
+	std::uint32_t virtual_address;
+	std::uint32_t virtual_size;
+	std::uint32_t pointer_to_raw_data;
+	ByteBuffer    data;
+};
+
+struct DataDirectory
+{
+	std::uint32_t virtual_address = 0;
+	std::uint32_t size            = 0;
+};
+
+class ImageBuilder
+{
+public:
+	explicit ImageBuilder(const ImageSpec & spec);
+
+	std::vector<char> build(ImageSummary * summary);
+
+private:
+	std::size_t pointer_size() const { return _spec.bits / CHAR_BIT; }
+	std::uint16_t reloc_type() const { return _spec.bits == 64 ? 10 /* DIR64 */ : 3 /* HIGHLOW */; }
+
+	Section & add_section(std::string name, std::uint32_t characteristics);
+	void close_section();
+	void put_address(Section & section, std::size_t offset, std::uint64_t rva);
+
+	void build_text_section();
+	void build_synthetic_sections();
+	void build_data_section();
+	void build_rdata_section();
+	void build_import_directory(Section & rdata);
+	void build_export_directory(Section & rdata);
+	void build_tls_directory(Section & rdata);
+	void build_reloc_section();
+
+	std::vector<char> write_image() const;
+
+	ImageSpec                  _spec;
+	std::uint64_t              _image_base;
+	std::size_t                _headers_size;
+	std::uint32_t              _next_rva;
+	std::vector<Section>       _sections;
+	std::vector<std::uint32_t> _relocations;
+	DataDirectory              _directories[16];
+
+	std::uint32_t _entry_point_rva;
+	std::uint32_t _tls_callback_rva;
+	std::uint32_t _export_stubs_rva;
+	std::uint32_t _tls_data_rva;
+	std::size_t   _stub_size;
+};
+
+ImageBuilder::ImageBuilder(const ImageSpec & spec)
+	: _spec { spec }
+{
+	if (_spec.bits != 32 && _spec.bits != 64)
+		throw std::invalid_argument("Image bitness must be 32 or 64");
+
+	if (_spec.image_base == 0)
+		_image_base = _spec.bits == 64 ? 0x180000000 : 0x10000000;
+	else
+		_image_base = _spec.image_base;
+
+	const bool has_relocs = (_spec.relocations_per_page != 0 && _spec.section_count != 0)
+	                     || _spec.tls_callback_count != 0;
+	const std::size_t section_count = 3 + _spec.section_count + (has_relocs ? 1 : 0);
+	const std::size_t opt_header_size = _spec.bits == 64 ? 240 : 224;
+	_headers_size = align_to(0x40 + 4 + 20 + opt_header_size + section_count * 40, FILE_ALIGNMENT);
+	_next_rva = static_cast<std::uint32_t>(align_to(_headers_size, SECTION_ALIGNMENT));
+	_sections.reserve(section_count);
+
+	// 32-bit entry points and TLS callbacks are stdcall and pop their three arguments
+	_stub_size = _spec.bits == 64 ? 1 : 3;
+}
+
+Section & ImageBuilder::add_section(std::string name, std::uint32_t characteristics)
+{
+	Section & section = _sections.emplace_back();
+	section.name = std::move(name);
+	section.characteristics = characteristics;
+	section.virtual_address = _next_rva;
+	return section;
+}
+
+void ImageBuilder::close_section()
+{
+	Section & section = _sections.back();
+	section.virtual_size = static_cast<std::uint32_t>(std::max<std::size_t>(section.data.size(), 1));
+	_next_rva = static_cast<std::uint32_t>(align_to(section.virtual_address + section.virtual_size,
+	                                                SECTION_ALIGNMENT));
+}
+
+void ImageBuilder::put_address(Section & section, std::size_t offset, std::uint64_t rva)
+{
+	if (_spec.bits == 64)
+		section.data.put<std::uint64_t>(offset, _image_base + rva);
+	else
+		section.data.put<std::uint32_t>(offset, static_cast<std::uint32_t>(_image_base + rva));
+	_relocations.push_back(static_cast<std::uint32_t>(section.virtual_address + offset));
+}
+
+void ImageBuilder::build_text_section()
+{
+	const std::string_view ret_stub = _spec.bits == 64 ? std::string_view("\xc3", 1)
+	                                                   : std::string_view("\xc2\x0c\x00", 3);
+
+	Section & text = add_section(".text", SCN_CNT_CODE | SCN_MEM_EXECUTE | SCN_MEM_READ);
+	text.data.put_bytes(0, "\xb8\x01\x00\x00\x00" /* mov eax, 1 */);
+	text.data.put_bytes(5, ret_stub);
+	_entry_point_rva = text.virtual_address;
+
+	text.data.align(16);
+	_tls_callback_rva = static_cast<std::uint32_t>(text.virtual_address + text.data.size());
+	text.data.put_bytes(text.data.size(), ret_stub);
+
+	text.data.align(16);
+	_export_stubs_rva = static_cast<std::uint32_t>(text.virtual_address + text.data.size());
+	for (std::size_t i = 0; i < _spec.export_count; ++i)
+		text.data.put_bytes(text.data.size(), ret_stub);
+
+	close_section();
+}
+
+void ImageBuilder::build_synthetic_sections()
+{
+	const std::size_t ptr_size = pointer_size();
+	const std::size_t slots_per_page = PAGE_SIZE / ptr_size;
+	const std::size_t relocs_per_page = std::min(_spec.relocations_per_page, slots_per_page);
+
+	for (std::size_t i = 0; i < _spec.section_count; ++i) {
+		const std::uint32_t characteristics = SCN_CNT_INITIALIZED_DATA | SCN_MEM_READ | SCN_MEM_WRITE;
+		Section & section = add_section(".sec" + std::to_string(i), characteristics);
+		section.data.resize(_spec.section_size);
+		if (relocs_per_page == 0) {
+			close_section();
+			continue;
+		}
+
+		const std::size_t slot_stride = slots_per_page / relocs_per_page * ptr_size;
+		for (std::size_t page_offs = 0; page_offs < _spec.section_size; page_offs += PAGE_SIZE) {
+			for (std::size_t slot = 0; slot < relocs_per_page; ++slot) {
+				const std::size_t slot_offs = page_offs + slot * slot_stride;
+				if (slot_offs + ptr_size > _spec.section_size) break;
+				put_address(section, slot_offs, _export_stubs_rva);
+			}
+		}
+
+		close_section();
+	}
+}
+
+void ImageBuilder::build_data_section()
+{
+	Section & data = add_section(".data", SCN_CNT_INITIALIZED_DATA | SCN_MEM_READ | SCN_MEM_WRITE);
+	for (std::size_t i = 0; i < TLS_DATA_SIZE; ++i)
+		data.data.put<std::uint8_t>(i, static_cast<std::uint8_t>(i + 1));
+	data.data.put<std::uint32_t>(TLS_DATA_SIZE, 0);
+	_tls_data_rva = data.virtual_address;
+	close_section();
+}
+
+void ImageBuilder::build_import_directory(Section & rdata)
+{
+	const std::size_t module_count = _spec.import_module_count;
+	const std::size_t symbol_count = _spec.imports_per_module;
+	if (module_count == 0) return;
+
+	const std::size_t ptr_size = pointer_size();
+	const std::size_t thunks_size = module_count * (symbol_count + 1) * ptr_size;
+	const std::size_t dtors_offs = rdata.data.size();
+	const std::size_t ilt_offs = align_to(dtors_offs + (module_count + 1) * 20, 8);
+	const std::size_t iat_offs = ilt_offs + thunks_size;
+	rdata.data.resize(iat_offs + thunks_size);
+
+	const std::uint32_t rdata_rva = rdata.virtual_address;
+	for (std::size_t m = 0; m < module_count; ++m) {
+		const std::size_t dtor_offs = dtors_offs + m * 20;
+		const std::size_t thunk_offs = m * (symbol_count + 1) * ptr_size;
+		for (std::size_t s = 0; s < symbol_count; ++s) {
+			rdata.data.align(2);
+			const std::size_t hint_offs = rdata.data.size();
+			rdata.data.put<std::uint16_t>(hint_offs, 0);
+			rdata.data.append_string(import_symbol_name(m, s));
+
+			const std::uint64_t hint_rva = rdata_rva + hint_offs;
+			if (_spec.bits == 64) {
+				rdata.data.put<std::uint64_t>(ilt_offs + thunk_offs + s * ptr_size, hint_rva);
+				rdata.data.put<std::uint64_t>(iat_offs + thunk_offs + s * ptr_size, hint_rva);
+			} else {
+				rdata.data.put<std::uint32_t>(ilt_offs + thunk_offs + s * ptr_size, hint_rva);
+				rdata.data.put<std::uint32_t>(iat_offs + thunk_offs + s * ptr_size, hint_rva);
+			}
+		}
+
+		const std::size_t name_offs = rdata.data.append_string(import_module_name(m));
+		rdata.data.put<std::uint32_t>(dtor_offs +  0, rdata_rva + ilt_offs + thunk_offs);
+		rdata.data.put<std::uint32_t>(dtor_offs + 12, rdata_rva + name_offs);
+		rdata.data.put<std::uint32_t>(dtor_offs + 16, rdata_rva + iat_offs + thunk_offs);
+	}
+
+	_directories[DIRECTORY_ENTRY_IMPORT] = {
+		static_cast<std::uint32_t>(rdata_rva + dtors_offs),
+		static_cast<std::uint32_t>((module_count + 1) * 20)
+	};
+
+	_directories[DIRECTORY_ENTRY_IAT] = {
+		static_cast<std::uint32_t>(rdata_rva + iat_offs),
+		static_cast<std::uint32_t>(thunks_size)
+	};
+}
+
+void ImageBuilder::build_export_directory(Section & rdata)
+{
+	const std::size_t function_count = _spec.export_count + _spec.forwarder_count;
+	if (function_count == 0) return;
+
+	rdata.data.align(8);
+	const std::uint32_t rdata_rva = rdata.virtual_address;
+	const std::size_t dir_offs = rdata.data.size();
+	const std::size_t eat_offs = dir_offs + 40;
+	const std::size_t names_offs = eat_offs + function_count * 4;
+	const std::size_t ordinals_offs = names_offs + function_count * 4;
+	rdata.data.resize(ordinals_offs + function_count * 2);
+
+	const std::size_t dll_name_offs = rdata.data.append_string(_spec.image_name);
+	rdata.data.put<std::uint32_t>(dir_offs + 12, rdata_rva + dll_name_offs);
+	rdata.data.put<std::uint32_t>(dir_offs + 16, 1);
+	rdata.data.put<std::uint32_t>(dir_offs + 20, function_count);
+	rdata.data.put<std::uint32_t>(dir_offs + 24, function_count);
+	rdata.data.put<std::uint32_t>(dir_offs + 28, rdata_rva + eat_offs);
+	rdata.data.put<std::uint32_t>(dir_offs + 32, rdata_rva + names_offs);
+	rdata.data.put<std::uint32_t>(dir_offs + 36, rdata_rva + ordinals_offs);
+
+	// "export_*" sorts before "forward_*", which keeps the name table ordered
+	for (std::size_t i = 0; i < function_count; ++i) {
+		const bool is_forwarder = i >= _spec.export_count;
+		const std::size_t index = is_forwarder ? i - _spec.export_count : i;
+		const std::string name = is_forwarder ? forwarder_symbol_name(index) : export_symbol_name(index);
+		const std::size_t name_offs = rdata.data.append_string(name);
+
+		std::uint32_t function_rva;
+		if (is_forwarder) {
+			const std::string fwd_string = _spec.forwarder_module + '.' + export_symbol_name(index);
+			function_rva = static_cast<std::uint32_t>(rdata_rva + rdata.data.append_string(fwd_string));
+		} else {
+			function_rva = static_cast<std::uint32_t>(_export_stubs_rva + index * _stub_size);
+		}
+
+		rdata.data.put<std::uint32_t>(eat_offs + i * 4, function_rva);
+		rdata.data.put<std::uint32_t>(names_offs + i * 4, rdata_rva + name_offs);
+		rdata.data.put<std::uint16_t>(ordinals_offs + i * 2, i);
+	}
+
+	_directories[DIRECTORY_ENTRY_EXPORT] = {
+		static_cast<std::uint32_t>(rdata_rva + dir_offs),
+		static_cast<std::uint32_t>(rdata.data.size() - dir_offs)
+	};
+}
+
+void ImageBuilder::build_tls_directory(Section & rdata)
+{
+	const std::size_t callback_count = _spec.tls_callback_count;
+	if (callback_count == 0) return;
+
+	rdata.data.align(8);
+	const std::size_t ptr_size = pointer_size();
+	const std::size_t dir_offs = rdata.data.size();
+	const std::size_t dir_size = 4 * ptr_size + 8;
+	const std::size_t callbacks_offs = dir_offs + dir_size;
+	rdata.data.resize(callbacks_offs + (callback_count + 1) * ptr_size);
+
+	put_address(rdata, dir_offs + 0 * ptr_size, _tls_data_rva);
+	put_address(rdata, dir_offs + 1 * ptr_size, _tls_data_rva + TLS_DATA_SIZE);
+	put_address(rdata, dir_offs + 2 * ptr_size, _tls_data_rva + TLS_DATA_SIZE);
+	put_address(rdata, dir_offs + 3 * ptr_size, rdata.virtual_address + callbacks_offs);
+	for (std::size_t i = 0; i < callback_count; ++i)
+		put_address(rdata, callbacks_offs + i * ptr_size, _tls_callback_rva);
+
+	_directories[DIRECTORY_ENTRY_TLS] = {
+		static_cast<std::uint32_t>(rdata.virtual_address + dir_offs),
+		static_cast<std::uint32_t>(dir_size)
+	};
+}
+
+void ImageBuilder::build_rdata_section()
+{
+	Section & rdata = add_section(".rdata", SCN_CNT_INITIALIZED_DATA | SCN_MEM_READ);
+	build_import_directory(rdata);
+	build_export_directory(rdata);
+	build_tls_directory(rdata);
+	close_section();
+}
+
+void ImageBuilder::build_reloc_section()
+{
+	if (_relocations.empty()) return;
+
+	std::sort(_relocations.begin(), _relocations.end());
+	Section & reloc = add_section(".reloc", SCN_CNT_INITIALIZED_DATA | SCN_MEM_READ | SCN_MEM_DISCARDABLE);
+
+	auto reloc_it = _relocations.begin();
+	while (reloc_it != _relocations.end()) {
+		const std::uint32_t page_rva = *reloc_it & ~std::uint32_t(PAGE_SIZE - 1);
+		const auto page_end = std::find_if(reloc_it, _relocations.end(),
+			[=] (std::uint32_t rva) { return rva >= page_rva + PAGE_SIZE; });
+
+		const std::size_t block_offs = reloc.data.size();
+		std::size_t entry_offs = block_offs + 8;
+		for (; reloc_it != page_end; ++reloc_it, entry_offs += 2) {
+			const std::uint16_t page_offs = *reloc_it - page_rva;
+			reloc.data.put<std::uint16_t>(entry_offs, (reloc_type() << 12) | page_offs);
+		}
+
+		reloc.data.align(4);
+		reloc.data.put<std::uint32_t>(block_offs + 0, page_rva);
+		reloc.data.put<std::uint32_t>(block_offs + 4, reloc.data.size() - block_offs);
+	}
+
+	_directories[DIRECTORY_ENTRY_BASERELOC] = {
+		reloc.virtual_address, static_cast<std::uint32_t>(reloc.data.size())
+	};
+	close_section();
+}
+
+std::vector<char> ImageBuilder::write_image() const
+{
+	ByteBuffer image;
+	image.put_bytes(0, "MZ");
+	image.put<std::uint32_t>(0x3c, 0x40);
+	image.put_bytes(0x40, std::string_view("PE\0\0", 4));
+
+	const bool is_pe64 = _spec.bits == 64;
+	const std::size_t file_hdr = 0x44;
+	const std::size_t opt_hdr = file_hdr + 20;
+	const std::size_t opt_hdr_size = is_pe64 ? 240 : 224;
+	image.put<std::uint16_t>(file_hdr +  0, is_pe64 ? MACHINE_AMD64 : MACHINE_I386);
+	image.put<std::uint16_t>(file_hdr +  2, _sections.size());
+	image.put<std::uint16_t>(file_hdr + 16, opt_hdr_size);
+	image.put<std::uint16_t>(file_hdr + 18, 0x2002 | (is_pe64 ? 0x0020 : 0x0100));
+
+	std::uint32_t code_size = 0, data_size = 0;
+	for (const Section & section : _sections) {
+		const auto raw_size = static_cast<std::uint32_t>(align_to(section.data.size(), FILE_ALIGNMENT));
+		(section.characteristics & SCN_CNT_CODE ? code_size : data_size) += raw_size;
+	}
+
+	const Section & last_section = _sections.back();
+	const std::size_t image_size = align_to(last_section.virtual_address + last_section.virtual_size,
+	                                        SECTION_ALIGNMENT);
+
+	image.put<std::uint16_t>(opt_hdr +  0, is_pe64 ? 0x20b : 0x10b);
+	image.put<std::uint32_t>(opt_hdr +  4, code_size);
+	image.put<std::uint32_t>(opt_hdr +  8, data_size);
+	image.put<std::uint32_t>(opt_hdr + 16, _entry_point_rva);
+	image.put<std::uint32_t>(opt_hdr + 20, _sections.front().virtual_address);
+	if (is_pe64) {
+		image.put<std::uint64_t>(opt_hdr + 24, _image_base);
+	} else {
+		image.put<std::uint32_t>(opt_hdr + 24, _sections[1].virtual_address);
+		image.put<std::uint32_t>(opt_hdr + 28, _image_base);
+	}
+	image.put<std::uint32_t>(opt_hdr + 32, SECTION_ALIGNMENT);
+	image.put<std::uint32_t>(opt_hdr + 36, FILE_ALIGNMENT);
+	image.put<std::uint16_t>(opt_hdr + 40, 6);
+	image.put<std::uint16_t>(opt_hdr + 48, 6);
+	image.put<std::uint32_t>(opt_hdr + 56, image_size);
+	image.put<std::uint32_t>(opt_hdr + 60, _headers_size);
+	image.put<std::uint16_t>(opt_hdr + 68, 2 /* SUBSYSTEM_WINDOWS_GUI */);
+	image.put<std::uint16_t>(opt_hdr + 70, 0x0140 /* DYNAMIC_BASE | NX_COMPAT */);
+
+	const std::size_t sizes_offs = opt_hdr + 72;
+	const std::size_t sizes_width = is_pe64 ? 8 : 4;
+	const std::uint64_t stack_heap_sizes[] = { 0x100000, 0x1000, 0x100000, 0x1000 };
+	for (std::size_t i = 0; i < 4; ++i) {
+		if (is_pe64)
+			image.put<std::uint64_t>(sizes_offs + i * sizes_width, stack_heap_sizes[i]);
+		else
+			image.put<std::uint32_t>(sizes_offs + i * sizes_width, stack_heap_sizes[i]);
+	}
+
+	const std::size_t dirs_offs = sizes_offs + 4 * sizes_width + 8;
+	image.put<std::uint32_t>(dirs_offs - 4, 16);
+	for (std::size_t i = 0; i < 16; ++i) {
+		image.put<std::uint32_t>(dirs_offs + i * 8 + 0, _directories[i].virtual_address);
+		image.put<std::uint32_t>(dirs_offs + i * 8 + 4, _directories[i].size);
+	}
+
+	std::size_t raw_offs = _headers_size;
+	std::size_t sect_hdr = opt_hdr + opt_hdr_size;
+	for (const Section & section : _sections) {
+		const std::size_t raw_size = align_to(section.data.size(), FILE_ALIGNMENT);
+		image.put_bytes(sect_hdr, section.name.substr(0, 8));
+		image.put<std::uint32_t>(sect_hdr +  8, section.virtual_size);
+		image.put<std::uint32_t>(sect_hdr + 12, section.virtual_address);
+		image.put<std::uint32_t>(sect_hdr + 16, raw_size);
+		image.put<std::uint32_t>(sect_hdr + 20, raw_size ? raw_offs : 0);
+		image.put<std::uint32_t>(sect_hdr + 36, section.characteristics);
+
+		const auto & data = section.data.data();
+		image.put_bytes(raw_offs, std::string_view(data.data(), data.size()));
+		raw_offs += raw_size;
+		sect_hdr += 40;
+	}
+
+	image.resize(raw_offs);
+	return image.data();
+}
+
+std::vector<char> ImageBuilder::build(ImageSummary * summary)
+{
+	build_text_section();
+	build_synthetic_sections();
+	build_data_section();
+	build_rdata_section();
+	build_reloc_section();
+
+	std::vector<char> image = write_image();
+	if (summary != nullptr) {
+		summary->file_size = image.size();
+		summary->image_size = _next_rva;
+		summary->relocation_count = _relocations.size();
+		summary->import_count = _spec.import_module_count * _spec.imports_per_module;
+		summary->export_count = _spec.export_count + _spec.forwarder_count;
+	}
+	return image;
+}
+
+}
+
+std::string import_module_name(std::size_t module_index)
+{
+	return "import" + std::to_string(module_index) + ".dll";
+}
+
+std::string import_symbol_name(std::size_t module_index, std::size_t symbol_index)
+{
+	return "import" + std::to_string(module_index) + "_" + std::to_string(symbol_index);
+}
+
+std::string export_symbol_name(std::size_t export_index)
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "export_%08zu", export_index);
+	return name;
+}
+
+std::string forwarder_symbol_name(std::size_t forwarder_index)
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "forward_%08zu", forwarder_index);
+	return name;
+}
+
+std::vector<char> generate_pe_image(const ImageSpec & spec, ImageSummary * summary)
+{
+	return ImageBuilder(spec).build(summary);
+}
+
+ImageSummary write_pe_image(const ImageSpec & spec, const std::filesystem::path & path)
+{
+	ImageSummary summary;
+	const std::vector<char> image = generate_pe_image(spec, &summary);
+
+	std::ofstream image_file { path, std::ios::binary };
+	image_file.write(image.data(), image.size());
+	if (!image_file)
+		throw std::runtime_error("Unable to write image file");
+	return summary;
+}
+
+}
\ No newline at end of file
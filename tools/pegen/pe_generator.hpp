@@ -0,0 +1,48 @@
+#ifndef LOAD_TOOLS_PEGEN_PEGENERATOR_HPP_
+#define LOAD_TOOLS_PEGEN_PEGENERATOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace load::pegen {
+
+struct ImageSpec
+{
+	unsigned int  bits                 = 64;
+	std::uint64_t image_base           = 0;
+	std::size_t   section_count        = 1;
+	std::size_t   section_size         = 0x1000;
+	std::size_t   relocations_per_page = 0;
+	std::size_t   import_module_count  = 0;
+	std::size_t   imports_per_module   = 0;
+	std::size_t   export_count         = 0;
+	std::size_t   forwarder_count      = 0;
+	std::size_t   tls_callback_count   = 0;
+	std::string   image_name           = "synthetic.dll";
+	std::string   forwarder_module     = "forward";
+};
+
+struct ImageSummary
+{
+	std::size_t image_size;
+	std::size_t file_size;
+	std::size_t relocation_count;
+	std::size_t import_count;
+	std::size_t export_count;
+};
+
+std::string import_module_name(std::size_t module_index);
+std::string import_symbol_name(std::size_t module_index, std::size_t symbol_index);
+std::string export_symbol_name(std::size_t export_index);
+std::string forwarder_symbol_name(std::size_t forwarder_index);
+
+std::vector<char> generate_pe_image(const ImageSpec & spec, ImageSummary * summary = nullptr);
+
+ImageSummary write_pe_image(const ImageSpec & spec, const std::filesystem::path & path);
+
+}
+
+#endif
\ No newline at end of file